@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#ifndef BUFFERED_TRACE_WRITER_H
+#define BUFFERED_TRACE_WRITER_H
+
+#include <stdint.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+/**
+ * \brief Keeps a trace file open and writes it in large blocks
+ *
+ * Trace sinks append records to an in-memory buffer which is written to
+ * the file once it holds FlushSize bytes, when Flush is called, and when
+ * the simulator is destroyed. Records are either text lines or binary
+ * fields in host byte order; binary files start with a 4 character magic
+ * and a uint32_t version so that a converter can recognize them.
+ */
+class BufferedTraceWriter
+{
+public:
+  /**
+   * \param fileName the file to create, truncated if it exists
+   * \param flushSize bytes buffered before writing to the file
+   */
+  BufferedTraceWriter (std::string fileName, std::size_t flushSize = 1 << 16)
+    : m_fileName (fileName),
+      m_flushSize (flushSize)
+  {
+    m_file.open (fileName.c_str (), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!m_file.is_open ())
+      {
+        std::cerr << "Error: Can't open file " << fileName << "\n";
+      }
+    m_buffer.reserve (flushSize + 256);
+    Simulator::ScheduleDestroy (&BufferedTraceWriter::Flush, this);
+  }
+  ~BufferedTraceWriter ()
+  {
+    Flush ();
+  }
+  /**
+   * Start a binary file
+   * \param magic four characters identifying the record layout
+   * \param version the version of the record layout
+   */
+  void WriteHeader (const char magic[4], uint32_t version)
+  {
+    m_buffer.append (magic, 4);
+    Write (version);
+  }
+  /**
+   * Append a binary field
+   * \param value the field, copied as is
+   */
+  template <typename T>
+  void Write (const T &value)
+  {
+    m_buffer.append (reinterpret_cast<const char *> (&value), sizeof (T));
+  }
+  /**
+   * Append raw bytes
+   * \param data the bytes
+   * \param size the number of bytes
+   */
+  void Write (const uint8_t *data, std::size_t size)
+  {
+    m_buffer.append (reinterpret_cast<const char *> (data), size);
+  }
+  /**
+   * Append text
+   * \param text the text, including its line break
+   */
+  void WriteText (const std::string &text)
+  {
+    m_buffer.append (text);
+  }
+  /// To be called after each record, writes the buffer once it is large enough
+  void EndRecord (void)
+  {
+    if (m_buffer.size () >= m_flushSize)
+      {
+        Flush ();
+      }
+  }
+  /// Write the buffered records to the file
+  void Flush (void)
+  {
+    if (!m_buffer.empty () && m_file.is_open ())
+      {
+        m_file.write (m_buffer.data (), m_buffer.size ());
+        m_file.flush ();
+      }
+    m_buffer.clear ();
+  }
+  /// \returns the name of the file
+  std::string GetFileName (void) const
+  {
+    return m_fileName;
+  }
+
+private:
+  /// Not copyable, the simulator keeps a pointer to flush at destroy time
+  BufferedTraceWriter (const BufferedTraceWriter &);
+  /// Not copyable
+  BufferedTraceWriter & operator= (const BufferedTraceWriter &);
+
+  std::string m_fileName;  ///< file name
+  std::size_t m_flushSize; ///< buffer size that triggers a write
+  std::ofstream m_file;    ///< the file, open for the whole run
+  std::string m_buffer;    ///< records not yet written
+};
+
+} // namespace ns3
+
+#endif /* BUFFERED_TRACE_WRITER_H */
@@ -21,8 +21,9 @@
  * IEEE802.11s stack installed at each node with peering management
  * and HWMP protocol.
  *
- * If mobility is disabled the nodes' location is set according to he
- * #include n_eq_* files and the number of nodes especified (default is 60)
+ * If mobility is disabled the nodes' location is set according to the
+ * stationary-scenarios/set1/n_eq_<nodes>_3d.topo file, or the one given with
+ * --topology-file, and the number of nodes especified (default is 60)
  * Additionally, if grid is enabled, this script creates
  * m_xSize * m_ySize square grid topology as defined by Kirill Andreev:
  *
@@ -61,11 +62,12 @@
 #include "ns3/propagation-module.h"
 //#include "ns3/data-rate.h"
 
-//For non-grid topology
-#include "n_eq_coord.h"
-#include "n_eq_20_3d.h"
-#include "n_eq_40_3d.h"
-#include "n_eq_60_3d.h"
+//For non-grid topology (binary files made from the n_eq_*_3d.h tables by nEqToTopology.py)
+#include "topology-file.h"
+//For mobility traces compiled by ns2ToWaypoints.py
+#include "waypoint-stream.h"
+
+#include "buffered-trace-writer.h"
 
 //For Animation with NetAnim
 #include "ns3/netanim-module.h"
@@ -78,6 +80,9 @@ NS_LOG_COMPONENT_DEFINE ("TestMeshScript");
 Mac48Address g_sinkMac;
 std::string g_rChangeFile = "rChanges.csv";
 std::string g_courseChangeFile = "courseChanges.csv";
+bool g_binaryTraces = false;
+BufferedTraceWriter *g_rChangeWriter = 0;
+BufferedTraceWriter *g_courseChangeWriter = 0;
 /**
  * \ingroup mesh
  * \brief MeshTest class
@@ -129,8 +134,17 @@ private:
   bool      m_doFlag;
   bool      m_rfFlag;
   bool      m_ns2Mobil;
-
-  vector< coordinates > nodeCoords;
+  bool      m_spatialIndex;
+  bool      m_pathLossCache;
+  bool      m_batchedPathLoss;
+  double    m_pathLossQuantum;
+  uint32_t  m_propThreads;
+  bool      m_wallClock;
+  double    m_routeExpiredAge;
+
+  std::string m_topologyFile;  ///< Binary file with the stationary topologies, empty to pick it from m_nNodes
+  TopologyFile m_topologies;   ///< The mapped topology file
+  WaypointStreamInstaller m_waypoints; ///< Streams the mobility of .wpt scenarios
 
   std::string m_stack;         ///< stack
   std::string m_metric;        ///< The routing metric [airtime, airtime-b, etx]
@@ -142,6 +156,7 @@ private:
   std::string m_UdpTcpMode;    ///< to hold Command Line Argument Value
   std::string m_asciiFile;     ///< Suffix for diagnostics files
   std::string m_scenario;      ///< ns2 trace file for node location and mobility
+  std::string m_outputDir;     ///< Directory where all the output files of the run are written
 
   /// List of network nodes
   NodeContainer nodes;
@@ -161,9 +176,23 @@ private:
   /// Print mesh devices diagnostics
   void Report ();
   /// Functions called to process tracing information
-  static void RouteChangeSink(std::string context, ns3::dot11s::RouteChange rChange);
-  static void CourseChange (std::string context, Ptr<const MobilityModel> model);
-  void ExportMobility (std::string stage);
+  static void RouteChangeSink (uint32_t nodeId, ns3::dot11s::RouteChange rChange);
+  static void RouteChangeBatchSink (uint32_t nodeId, ns3::dot11s::RouteChangeType type,
+                                    const ns3::dot11s::HwmpProtocol::FailedDestination *destinations, uint32_t n);
+  /// Write a route change to the route change trace
+  static void WriteRouteChange (uint32_t nodeId, const ns3::dot11s::RouteChange &rChange);
+  static void CourseChange (uint32_t nodeId, Ptr<const MobilityModel> model);
+  /// Write the position and velocity of a node to the course change trace
+  static void WriteCourse (uint32_t nodeId, Ptr<const MobilityModel> model);
+  /// Write the current position and velocity of every node to the course change trace
+  void ExportMobility ();
+  /// Open the trace files and connect the sinks of every node
+  void ConnectTraces ();
+  /**
+   * \param name the name of an output file
+   * \returns the path of the file within the output directory
+   */
+  std::string GetOutputPath (std::string name) const;
 };
 MeshTest::MeshTest () :
   m_xSize (4),
@@ -192,6 +221,14 @@ MeshTest::MeshTest () :
   m_doFlag (true),
   m_rfFlag (true),
   m_ns2Mobil (true),
+  m_spatialIndex (false),
+  m_pathLossCache (false),
+  m_batchedPathLoss (false),
+  m_pathLossQuantum (0.0),
+  m_propThreads (1),
+  m_wallClock (false),
+  m_routeExpiredAge (30.0),
+  m_topologyFile (""),
   m_stack ("ns3::Dot11sStack"),
   m_metric ("airtime"),
   m_wifiStandard ("80211n2.4"),
@@ -201,7 +238,8 @@ MeshTest::MeshTest () :
   m_root ("00:00:00:00:00:01"), // Default: "ff:ff:ff:ff:ff:ff"
   m_UdpTcpMode ("udp"),
   m_asciiFile  ("mesh.tr"),
-  m_scenario ("gm3d-60-1.ns_movements")
+  m_scenario ("gm3d-60-1.ns_movements"),
+  m_outputDir ("")
 {
   // The node that receives the data from all the other nodes
   m_sink = 0;// m_xSize * m_ySize - 1; //15
@@ -212,7 +250,8 @@ MeshTest::Configure (int argc, char *argv[])
   CommandLine cmd;
   cmd.AddValue ("x-size", "Number of nodes in a row grid", m_xSize);
   cmd.AddValue ("y-size", "Number of rows in a grid", m_ySize);
-  cmd.AddValue ("nodes", "Number of nodes in a custom distribution", m_nNodes);
+  cmd.AddValue ("nodes", "Number of nodes in a custom distribution, stationary runs read "
+                "stationary-scenarios/set1/n_eq_<nodes>_3d.topo unless --topology-file is given", m_nNodes);
   cmd.AddValue ("step",   "Size of edge in our grid (meters)", m_step);
   // Avoid starting all mesh nodes at the same time (beacons may collide)
   cmd.AddValue ("start", "Maximum random start delay for beacon jitter (sec)", m_randomStart);
@@ -226,7 +265,9 @@ MeshTest::Configure (int argc, char *argv[])
   cmd.AddValue ("pcap",  "Enable PCAP traces on interfaces", m_pcap);
   cmd.AddValue ("ascii", "Enable Ascii traces on interfaces", m_ascii);
   cmd.AddValue ("grid", "Choice whether grid or random topology", m_gridtopology);
-  cmd.AddValue ("topology", "Number of topology from predefined list (0-29)", m_topoId);
+  cmd.AddValue ("topology", "Index of the topology in the topology file", m_topoId);
+  cmd.AddValue ("topology-file", "Binary topology file (see nEqToTopology.py), its number of nodes must match --nodes; "
+                "a relative path, including the default, is taken from the working directory", m_topologyFile);
   cmd.AddValue ("ns2mobility", "Nodes move per ns2 mobility trace file", m_ns2Mobil);
   cmd.AddValue ("stack", "Type of protocol stack. ns3::Dot11sStack by default", m_stack);
   cmd.AddValue ("metric", "Selection of routing metric by name, it affects the boolean metric selecting attributes", m_metric);
@@ -247,10 +288,34 @@ MeshTest::Configure (int argc, char *argv[])
   cmd.AddValue ("link-rate", "The link speed used with Constant Rate Wifi Manager (string)", m_linkRate);
   cmd.AddValue ("propagation-loss-model", "The Propagation Loss Model for the medium (string)", m_propLoss);
   cmd.AddValue ("ascii-file", "The Ascii report filename", m_asciiFile);
-  cmd.AddValue ("scenario", "Ns2 trace file with location and mobility scenario", m_scenario);
+  cmd.AddValue ("scenario", "Ns2 trace file with location and mobility scenario, or a .wpt file made by ns2ToWaypoints.py", m_scenario);
+  cmd.AddValue ("binary-traces", "Write route and course changes as binary records (see droneMeshTraceToCsv.py)", g_binaryTraces);
+  cmd.AddValue ("output-dir", "Directory for the csv, xml and trace files of this run (created if needed)", m_outputDir);
+  cmd.AddValue ("spatial-index", "Skip out of range receivers in the channel (friis and logdistance only)", m_spatialIndex);
+  cmd.AddValue ("pathloss-cache", "Reuse the rx power of node pairs that did not move (deterministic models only)", m_pathLossCache);
+  cmd.AddValue ("batched-pathloss", "Compute the rx powers of a transmission in one pass (friis and logdistance only)", m_batchedPathLoss);
+  cmd.AddValue ("pathloss-quantum", "Seconds a cached rx power is reused while the nodes move", m_pathLossQuantum);
+  cmd.AddValue ("propagation-threads", "Threads computing the rx powers of a transmission (1 disables). Only used when a "
+                "transmission has ns3::YansWifiChannel::PropagationThreadThreshold receivers or more (200 by default) "
+                "and the path loss cache is off", m_propThreads);
+  cmd.AddValue ("route-expired-age", "Seconds an expired route is kept before it is evicted (0 keeps it until a PERR)",
+                m_routeExpiredAge);
+  cmd.AddValue ("wall-clock", "Print the wall clock time of Simulator::Run to stderr (see droneMeshBenchmark.py)", m_wallClock);
 
   cmd.Parse (argc, argv);
   NS_ASSERT_MSG (m_beaconWinSize < 31, "Maximum Size of Beacons Window is 30.");
+  // Keep the output of concurrent runs apart
+  if (!m_outputDir.empty ())
+    {
+      SystemPath::MakeDirectories (m_outputDir);
+    }
+  if (g_binaryTraces)
+    {
+      g_rChangeFile = "rChanges.bin";
+      g_courseChangeFile = "courseChanges.bin";
+    }
+  g_rChangeFile = GetOutputPath (g_rChangeFile);
+  g_courseChangeFile = GetOutputPath (g_courseChangeFile);
   // g_sinkMac = Mac48Address(m_root.c_str());
   if (m_root != "ff:ff:ff:ff:ff:ff")
     {
@@ -267,6 +332,21 @@ MeshTest::Configure (int argc, char *argv[])
   if (m_metric == "hop-count") m_hopCntMetric = true;
   if (m_metric == "srftime") { m_srAirtime = true; m_airTimeBMetric = true; }
 
+  if (!m_ns2Mobil && !m_gridtopology)
+    {
+      if (m_topologyFile.empty ())
+        {
+          std::ostringstream os;
+          os << "stationary-scenarios/set1/n_eq_" << m_nNodes << "_3d.topo";
+          m_topologyFile = os.str ();
+        }
+      std::string error = m_topologies.Open (m_topologyFile);
+      NS_ABORT_MSG_IF (!error.empty (), "Topology file: " << error);
+      NS_ABORT_MSG_IF (m_topoId < 0 || (uint32_t) m_topoId >= m_topologies.GetNTopologies (),
+                       "Topology " << m_topoId << " not in " << m_topologyFile << " (" << m_topologies.GetNTopologies () << " topologies)");
+      NS_ABORT_MSG_IF (m_nNodes < 0 || (uint32_t) m_nNodes != m_topologies.GetNNodes (),
+                       m_topologyFile << " has " << m_topologies.GetNNodes () << " nodes, not " << m_nNodes << " (see --nodes)");
+    }
   if (m_gridtopology)
   {
     NS_LOG_DEBUG ("Grid: " << m_xSize << "*" << m_ySize);
@@ -326,6 +406,11 @@ MeshTest::CreateNodes ()
   if (m_propLoss == "friis")        wifiChannel.AddPropagationLoss ("ns3::FriisPropagationLossModel", "Frequency", DoubleValue(2.437e9));
 
   wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  Config::SetDefault ("ns3::YansWifiChannel::SpatialIndex", BooleanValue (m_spatialIndex));
+  Config::SetDefault ("ns3::YansWifiChannel::PathLossCache", BooleanValue (m_pathLossCache));
+  Config::SetDefault ("ns3::YansWifiChannel::BatchedPathLoss", BooleanValue (m_batchedPathLoss));
+  Config::SetDefault ("ns3::YansWifiChannel::PathLossCacheQuantum", TimeValue (Seconds (m_pathLossQuantum)));
+  Config::SetDefault ("ns3::YansWifiChannel::PropagationThreads", UintegerValue (m_propThreads));
   wifiPhy.SetChannel (wifiChannel.Create ());
 
   // Configure the parameters of the Peer Link
@@ -347,6 +432,7 @@ MeshTest::CreateNodes ()
   Config::SetDefault ("ns3::dot11s::HwmpProtocol::EtxMetric", BooleanValue (m_etxMetric));
   Config::SetDefault ("ns3::dot11s::HwmpProtocol::LinkProbePacket", BooleanValue (m_enableLpp));
   Config::SetDefault ("ns3::dot11s::HwmpProtocol::HopCountMetric", BooleanValue (m_hopCntMetric));
+  Config::SetDefault ("ns3::dot11s::HwmpRtable::MaxExpiredAge", TimeValue (Seconds (m_routeExpiredAge))); //Default: 0
 
   // Configure parameters of the MeshWifiInterfaceMac
   // Config::SetDefault ("ns3::MeshWifiInterfaceMac::BeaconInterval", TimeValue (Seconds (1.0)));   //Default: 0.5
@@ -401,7 +487,13 @@ MeshTest::CreateNodes ()
 
   MobilityHelper mobility;
   // Setup ns2 mobility
-  if (m_ns2Mobil)
+  if (m_ns2Mobil && m_scenario.size () > 4 && m_scenario.substr (m_scenario.size () - 4) == ".wpt")
+  {
+    // Only the next waypoint of each node is scheduled
+    std::string error = m_waypoints.Install (m_scenario);
+    NS_ABORT_MSG_IF (!error.empty (), "Waypoint file: " << error);
+  }
+  else if (m_ns2Mobil)
   {
     Ns2MobilityHelper ns2mobility = Ns2MobilityHelper(m_scenario);
     ns2mobility.Install();
@@ -423,24 +515,10 @@ MeshTest::CreateNodes ()
   else
   {
     // Setup static node locations from file
-    switch (m_nNodes) {
-      case 20:
-        for (int i = 0; i < m_nNodes; i++)
-          nodeCoords.push_back (n_eq_20_3d[m_topoId][i]);
-        break;
-      case 40:
-        for (int i = 0; i < m_nNodes; i++)
-          nodeCoords.push_back (n_eq_40_3d[m_topoId][i]);
-        break;
-      case 60:
-        for (int i = 0; i < m_nNodes; i++)
-          nodeCoords.push_back (n_eq_60_3d[m_topoId][i]);
-        break;
-    }
     Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
-    for (vector< coordinates >::iterator j = nodeCoords.begin (); j != nodeCoords.end (); j++)
+    for (int i = 0; i < m_nNodes; i++)
       {
-        positionAlloc->Add (Vector ((*j).X, (*j).Y, (*j).Z));
+        positionAlloc->Add (m_topologies.GetPosition (m_topoId, i));
       }
     mobility.SetPositionAllocator (positionAlloc);
     mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
@@ -448,11 +526,11 @@ MeshTest::CreateNodes ()
   }
 
   if (m_pcap)
-    wifiPhy.EnablePcapAll (std::string ("mp-"));
+    wifiPhy.EnablePcapAll (GetOutputPath ("mp-"));
   if (m_ascii)
     {
       AsciiTraceHelper ascii;
-      wifiPhy.EnableAsciiAll (ascii.CreateFileStream (m_asciiFile));
+      wifiPhy.EnableAsciiAll (ascii.CreateFileStream (GetOutputPath (m_asciiFile)));
     }
 }
 void
@@ -499,47 +577,122 @@ MeshTest::InstallApplication ()
     }
   }
 }
+/*
+ * Binary trace records, host byte order, after a 4 character magic and a uint32_t version (1):
+ *  "DMRC": int64 time (ns), uint32 node, uint8 type (dot11s::RouteChangeType), uint8[6] destination, uint8[6] retransmitter,
+ *          uint32 metric, uint32 sequence number
+ *  "DMCC": uint32 node, int64 time (ns), double[3] position, double[3] velocity
+ */
 void
-MeshTest::RouteChangeSink(std::string context, ns3::dot11s::RouteChange rChange)
+MeshTest::RouteChangeSink (uint32_t nodeId, ns3::dot11s::RouteChange rChange)
 {
   if (rChange.destination == g_sinkMac)
-  {
-    std::ofstream osf (g_rChangeFile.c_str(), std::ios::out | std::ios::app);
-    if (!osf.is_open ())
-      {
-        std::cerr << "Error: Can't open file " << g_rChangeFile << "\n";
-        return;
-      }
-    osf << Simulator::Now() << ",";
-    uint8_t index = 10;
-    while (context[index] != '/')
     {
-      osf << context[index];
-      index++;
+      WriteRouteChange (nodeId, rChange);
     }
-    osf << "," << rChange.type << "," << rChange.destination << "," << rChange.retransmitter;
-    osf << "," << rChange.metric << "," << rChange.seqnum << std::endl;
-    osf.close();
-  }
 }
 void
-MeshTest::CourseChange(std::string context, Ptr<const MobilityModel> model)
+MeshTest::RouteChangeBatchSink (uint32_t nodeId, ns3::dot11s::RouteChangeType type,
+                                const ns3::dot11s::HwmpProtocol::FailedDestination *destinations, uint32_t n)
 {
-  std::ofstream osf (g_courseChangeFile.c_str(), std::ios::out | std::ios::app);
-  if (!osf.is_open())
-  {
-    std::cerr << "Error: Can't open File " << g_courseChangeFile << "\n";
-    return;
-  }
-  uint8_t index = 10;
-  while (context[index] != '/')
-  {
-    osf << context[index];
-    index++;
-  }
-  osf << "," << Simulator::Now();
-  osf << "," << model->GetPosition() << "," << model->GetVelocity() << std::endl;
-  osf.close();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (destinations[i].destination == g_sinkMac)
+        {
+          ns3::dot11s::RouteChange rChange;
+          rChange.type = type;
+          rChange.destination = destinations[i].destination;
+          rChange.seqnum = destinations[i].seqnum;
+          WriteRouteChange (nodeId, rChange);
+        }
+    }
+}
+void
+MeshTest::WriteRouteChange (uint32_t nodeId, const ns3::dot11s::RouteChange &rChange)
+{
+  if (g_binaryTraces)
+    {
+      uint8_t address[6];
+      g_rChangeWriter->Write (Simulator::Now ().GetNanoSeconds ());
+      g_rChangeWriter->Write (nodeId);
+      g_rChangeWriter->Write (static_cast<uint8_t> (rChange.type));
+      rChange.destination.CopyTo (address);
+      g_rChangeWriter->Write (address, 6);
+      rChange.retransmitter.CopyTo (address);
+      g_rChangeWriter->Write (address, 6);
+      g_rChangeWriter->Write (rChange.metric);
+      g_rChangeWriter->Write (rChange.seqnum);
+    }
+  else
+    {
+      std::ostringstream osf;
+      osf << Simulator::Now () << "," << nodeId;
+      osf << "," << rChange.type << "," << rChange.destination << "," << rChange.retransmitter;
+      osf << "," << rChange.metric << "," << rChange.seqnum << std::endl;
+      g_rChangeWriter->WriteText (osf.str ());
+    }
+  g_rChangeWriter->EndRecord ();
+}
+void
+MeshTest::CourseChange (uint32_t nodeId, Ptr<const MobilityModel> model)
+{
+  WriteCourse (nodeId, model);
+}
+void
+MeshTest::WriteCourse (uint32_t nodeId, Ptr<const MobilityModel> model)
+{
+  Vector position = model->GetPosition ();
+  Vector velocity = model->GetVelocity ();
+  if (g_binaryTraces)
+    {
+      g_courseChangeWriter->Write (nodeId);
+      g_courseChangeWriter->Write (Simulator::Now ().GetNanoSeconds ());
+      g_courseChangeWriter->Write (position.x);
+      g_courseChangeWriter->Write (position.y);
+      g_courseChangeWriter->Write (position.z);
+      g_courseChangeWriter->Write (velocity.x);
+      g_courseChangeWriter->Write (velocity.y);
+      g_courseChangeWriter->Write (velocity.z);
+    }
+  else
+    {
+      std::ostringstream osf;
+      osf << nodeId << "," << Simulator::Now ();
+      osf << "," << position << "," << velocity << std::endl;
+      g_courseChangeWriter->WriteText (osf.str ());
+    }
+  g_courseChangeWriter->EndRecord ();
+}
+void
+MeshTest::ConnectTraces ()
+{
+  // Both files stay open for the whole run and are flushed by Simulator::Destroy
+  g_rChangeWriter = new BufferedTraceWriter (g_rChangeFile);
+  g_courseChangeWriter = new BufferedTraceWriter (g_courseChangeFile);
+  if (g_binaryTraces)
+    {
+      g_rChangeWriter->WriteHeader ("DMRC", 1);
+      g_courseChangeWriter->WriteHeader ("DMCC", 1);
+    }
+  else
+    {
+      g_rChangeWriter->WriteText ("Time,Node,Type,Destination,Retransmitter,Metric,SeqNumber\n");
+      g_courseChangeWriter->WriteText ("Node,Time,Position,Velocity\n");
+    }
+  for (NodeContainer::Iterator j = nodes.Begin (); j != nodes.End (); ++j)
+    {
+      Ptr<Node> node = *j;
+      Ptr<MeshPointDevice> mp = DynamicCast<MeshPointDevice> (node->GetDevice (0));
+      if (mp != 0)
+        {
+          mp->GetRoutingProtocol ()->TraceConnectWithoutContext ("RouteChange",
+                                                                 MakeBoundCallback (&RouteChangeSink, node->GetId ()));
+          mp->GetRoutingProtocol ()->TraceConnectWithoutContext ("RouteChangeBatch",
+                                                                 MakeBoundCallback (&RouteChangeBatchSink, node->GetId ()));
+        }
+      node->GetObject<MobilityModel> ()->TraceConnectWithoutContext ("CourseChange",
+                                                                     MakeBoundCallback (&CourseChange, node->GetId ()));
+    }
 }
 int
 MeshTest::Run ()
@@ -547,15 +700,10 @@ MeshTest::Run ()
   CreateNodes ();
   InstallInternetStack ();
   InstallApplication ();
-  Config::Connect ("/NodeList/*/DeviceList/0/$ns3::MeshPointDevice/RoutingProtocol/$ns3::dot11s::HwmpProtocol/RouteChange", MakeCallback (&RouteChangeSink));
-  Config::Connect ("/NodeList/*/$ns3::MobilityModel/CourseChange", MakeCallback (&CourseChange));
+  ConnectTraces ();
   Simulator::Schedule (Seconds (m_totalTime), &MeshTest::Report, this);
-  // Prepare file to store Route Changes
-  std::ofstream osf (g_rChangeFile.c_str ());
-  osf << "Time,Node,Type,Destination,Retransmitter,Metric,SeqNumber" << std::endl;
-  osf.close();
-  // Prepare file to store Course Changes
-  ExportMobility ("start");
+  // Initial node locations
+  ExportMobility ();
   //Flow monitor
   Ptr<FlowMonitor> flowMonitor;
   FlowMonitorHelper flowHelper;
@@ -565,14 +713,25 @@ MeshTest::Run ()
   // anim.SetMobilityPollInterval (Seconds (0.5));
 
   Simulator::Stop (Seconds (m_totalTime));
+  SystemWallClockMs wallClock;
+  wallClock.Start ();
   Simulator::Run ();
+  int64_t wallMs = wallClock.End ();
+  if (m_wallClock)
+    {
+      std::cerr << "Simulation took " << wallMs << " ms of wall clock time\n";
+    }
 
-  flowMonitor->SerializeToXmlFile("MeshPerformance.xml", true, true);
+  flowMonitor->SerializeToXmlFile(GetOutputPath ("MeshPerformance.xml"), true, true);
 
   //After Simulation save final node locations
-  ExportMobility ("end");
+  ExportMobility ();
 
   Simulator::Destroy ();
+  delete g_rChangeWriter;
+  delete g_courseChangeWriter;
+  g_rChangeWriter = 0;
+  g_courseChangeWriter = 0;
   return 0;
 }
 void
@@ -582,7 +741,7 @@ MeshTest::Report ()
   for (NetDeviceContainer::Iterator i = meshDevices.Begin (); i != meshDevices.End (); ++i, ++n)
     {
       std::ostringstream os;
-      os << "mp-report-" << n << ".xml";
+      os << GetOutputPath ("mp-report-") << n << ".xml";
       std::cerr << "Printing mesh point device #" << n << " diagnostics to " << os.str () << "\n";
       std::ofstream of;
       of.open (os.str ().c_str ());
@@ -596,23 +755,21 @@ MeshTest::Report ()
     }
 }
 void
-MeshTest::ExportMobility (std::string stage)
+MeshTest::ExportMobility ()
 {
-  std::ofstream osf;
-  if (stage == "start") {
-    osf.open (g_courseChangeFile.c_str());
-    osf << "Node,Time,Position,Velocity" << std::endl;
-  }
-  else {
-    osf.open (g_courseChangeFile.c_str(), std::ios::app);
-  }
   for (NodeContainer::Iterator j = nodes.Begin(); j != nodes.End(); ++j) {
       Ptr<Node> node = *j;
-      Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
-      osf << node->GetId() << "," << Simulator::Now();
-      osf << "," << mobility->GetPosition() << "," << mobility->GetVelocity() << std::endl;
+      WriteCourse (node->GetId (), node->GetObject<MobilityModel> ());
   }
-  osf.close();
+}
+std::string
+MeshTest::GetOutputPath (std::string name) const
+{
+  if (m_outputDir.empty ())
+    {
+      return name;
+    }
+  return SystemPath::Append (m_outputDir, name);
 }
 int
 main (int argc, char *argv[])
@@ -0,0 +1,165 @@
+#! /usr/bin/env python3
+#
+# Copyright (c) 2020 Oscar Bautista
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Author: Oscar Bautista <obaut004@fiu.edu>
+#
+"""
+Compares the wall clock time of Simulator::Run between droneMesh variants.
+
+A variant is LABEL=ARGS, where ARGS are droneMesh arguments separated by
+spaces. LABEL@BINARY=ARGS runs another droneMesh executable, e.g. one built
+from an older revision. Every variant runs on the same stationary
+topologies, one at a time so that they do not compete for the CPU, and
+--repeat times each. The median time of every variant is printed per
+topology file, with the speedup over the first variant.
+
+With --heap, every run is done once under valgrind instead, and the
+number of heap allocations per simulated second is printed, with the
+ratio to the first variant.
+
+Example, the pairwise path loss cache on the set1 and set2 60 node
+topologies, from the ns-3 top level directory (after ./waf build):
+
+  ./scratch/droneMeshBenchmark.py \\
+      --topology-files stationary-scenarios/set1/n_eq_60_3d.topo,stationary-scenarios/set2/n_eq_60_3d.topo \\
+      --topologies 0-4 --repeat 3 \\
+      --variant 'no-cache=--pathloss-cache=0' --variant 'cache=--pathloss-cache=1' -- --time=125
+
+Heap allocations of two builds, e.g. before and after a change, with a
+short run since valgrind is slow:
+
+  ./scratch/droneMeshBenchmark.py --heap \\
+      --variant 'before@../ns-3-before/build/scratch/droneMesh=' --variant 'after=' -- --time=20
+"""
+
+import argparse
+import os
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+
+from droneMeshSweep import find_binary, parse_list
+
+WALL_CLOCK = re.compile (r'^Simulation took (\d+) ms of wall clock time$', re.M)
+HEAP_USAGE = re.compile (r'total heap usage: ([\d,]+) allocs')
+# Default of droneMesh --time
+DEFAULT_SIM_TIME = 125.0
+
+
+def parse_variant (text, default_binary):
+    """'label[@binary]=args' -> (label, binary, [args])"""
+    if '=' not in text:
+        sys.exit ('bad variant %r, expected LABEL=ARGS' % text)
+    label, args = text.split ('=', 1)
+    binary = default_binary
+    if '@' in label:
+        label, binary = label.split ('@', 1)
+        binary = os.path.abspath (binary)
+    return label, binary, args.split ()
+
+
+def sim_time (sim_args):
+    """Simulated seconds of a run, the last --time wins as in ns-3 CommandLine"""
+    seconds = DEFAULT_SIM_TIME
+    for arg in sim_args:
+        if arg.startswith ('--time='):
+            seconds = float (arg[len ('--time='):])
+    return seconds
+
+
+def run_once (binary, env, sim_args, heap):
+    """Run droneMesh in a scratch directory, return the Simulator::Run time in ms or
+    the number of heap allocations of the whole process with heap"""
+    directory = tempfile.mkdtemp (prefix='droneMeshBenchmark-')
+    # Heap runs do not need --wall-clock, so builds that predate it can be compared too
+    command = ['valgrind', '--tool=memcheck', '--leak-check=no', binary] if heap else [binary, '--wall-clock=1']
+    try:
+        proc = subprocess.run (command + sim_args, cwd=directory, env=env, stdout=subprocess.DEVNULL,
+                               stderr=subprocess.PIPE, universal_newlines=True)
+    finally:
+        shutil.rmtree (directory, ignore_errors=True)
+    if proc.returncode != 0:
+        sys.exit ('%s failed with exit code %d:\n%s' % (' '.join ([binary] + sim_args), proc.returncode,
+                                                        proc.stderr[-2000:]))
+    if heap:
+        m = HEAP_USAGE.search (proc.stderr)
+        if not m:
+            sys.exit ('no heap summary from valgrind for ' + binary)
+        return int (m.group (1).replace (',', ''))
+    m = WALL_CLOCK.search (proc.stderr)
+    if not m:
+        sys.exit ('%s did not print its wall clock time, is it built with --wall-clock?' % binary)
+    return int (m.group (1))
+
+
+def main ():
+    parser = argparse.ArgumentParser (description='Wall clock comparison of scratch/droneMesh.cc variants',
+                                      epilog='Arguments after -- are passed to every run')
+    parser.add_argument ('--ns3-dir', default='.', help='ns-3 top level directory')
+    parser.add_argument ('--binary', help='droneMesh executable (default: newest under build/scratch)')
+    parser.add_argument ('--variant', action='append', default=[], help='LABEL[@BINARY]=ARGS, at least two')
+    parser.add_argument ('--topology-files', default='stationary-scenarios/set1/n_eq_60_3d.topo',
+                         help='comma separated list of topology files')
+    parser.add_argument ('--topologies', default='0', help='topology indices, e.g. 0-4')
+    parser.add_argument ('--repeat', type=int, default=3, help='runs per variant and topology')
+    parser.add_argument ('--heap', action='store_true',
+                         help='count heap allocations under valgrind instead of timing (one run each)')
+    parser.add_argument ('sim_args', nargs='*', help='extra droneMesh arguments')
+    args = parser.parse_args ()
+
+    binary = os.path.abspath (args.binary) if args.binary else find_binary (args.ns3_dir)
+    variants = [parse_variant (v, binary) for v in args.variant]
+    if len (variants) < 2:
+        sys.exit ('Give at least two --variant')
+    env = dict (os.environ)
+    lib_dir = os.path.abspath (os.path.join (args.ns3_dir, 'build', 'lib'))
+    env['LD_LIBRARY_PATH'] = lib_dir + os.pathsep + env.get ('LD_LIBRARY_PATH', '')
+
+    for topology_file in parse_list (args.topology_files):
+        times = dict ((label, []) for label, _, _ in variants)
+        for topology in parse_list (args.topologies):
+            for _ in range (1 if args.heap else args.repeat):
+                # Interleave the variants so that a slow period of the machine hits all of them
+                for label, variant_binary, variant_args in variants:
+                    sim_args = ['--ns2mobility=0', '--grid=0', '--topology-file=' + os.path.abspath (topology_file),
+                                '--topology=' + topology] + variant_args + args.sim_args
+                    result = run_once (variant_binary, env, sim_args, args.heap)
+                    times[label].append (result / sim_time (sim_args) if args.heap else result)
+        print (topology_file)
+        if args.heap:
+            baseline = statistics.mean (times[variants[0][0]])
+            for label, _, _ in variants:
+                mean = statistics.mean (times[label])
+                print ('  %-20s %12.0f allocations per simulated second over %3d runs, %.3f of %s'
+                       % (label, mean, len (times[label]), mean / baseline if baseline else float ('inf'),
+                          variants[0][0]))
+            sys.stdout.flush ()
+            continue
+        baseline = statistics.median (times[variants[0][0]])
+        for label, _, _ in variants:
+            median = statistics.median (times[label])
+            print ('  %-20s median %8.0f ms over %3d runs, speedup %.2fx'
+                   % (label, median, len (times[label]), baseline / median if median else float ('inf')))
+        sys.stdout.flush ()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit (main ())
@@ -0,0 +1,252 @@
+#! /usr/bin/env python3
+#
+# Copyright (c) 2020 Oscar Bautista
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Author: Oscar Bautista <obaut004@fiu.edu>
+#
+"""
+Runs droneMesh over a grid of parameters with a bounded pool of processes.
+
+Every run gets its own directory <out>/<metric>/<scenario>/run-<seed> which
+is passed to droneMesh as --output-dir and used as working directory. A run
+is marked complete by a 'done' file, so an interrupted sweep is resumed by
+running the same command again. After all runs finish, summary.csv is
+written in <out> with one row per run.
+
+Example, from the ns-3 top level directory (after ./waf build):
+
+  ./scratch/droneMeshSweep.py --out sweep \\
+      --metrics airtime,airtime-b,etx,hop-count,srftime \\
+      --scenarios gm3d-60-1,gm3d-60-2,gm3d-60-3,gm3d-60-4,gm3d-60-5 \\
+      --topologies 0-29 --seeds 1-5 -- --time=125
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import glob
+import itertools
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+import xml.etree.ElementTree as ET
+
+TIME_UNITS = {'s': 1e9, 'ms': 1e6, 'us': 1e3, 'ns': 1.0, 'ps': 1e-3, 'fs': 1e-6}
+SUMMARY_FIELDS = ['metric', 'scenario', 'seed', 'status', 'wallSeconds', 'flows',
+                  'txPackets', 'rxPackets', 'lostPackets', 'deliveryRatio',
+                  'meanDelayMs', 'throughputKbps', 'routeChanges']
+# Default of droneMesh --nodes
+DEFAULT_NODES = 60
+
+
+def parse_list (text):
+    """'1-3,7' -> ['1', '2', '3', '7']"""
+    items = []
+    for part in text.split (','):
+        part = part.strip ()
+        if not part:
+            continue
+        m = re.match (r'^(\d+)-(\d+)$', part)
+        if m:
+            items.extend (str (i) for i in range (int (m.group (1)), int (m.group (2)) + 1))
+        else:
+            items.append (part)
+    return items
+
+
+def parse_time_ns (text):
+    """Parse an ns-3 Time as printed in the flow monitor xml, e.g. '+1.5e+09ns'"""
+    m = re.match (r'^\s*([-+]?[0-9.]+(?:[eE][-+]?\d+)?)\s*([a-z]*)\s*$', text)
+    if not m:
+        raise ValueError ('bad time ' + text)
+    return float (m.group (1)) * TIME_UNITS.get (m.group (2) or 'ns', 1.0)
+
+
+def find_binary (ns3_dir):
+    candidates = [f for f in glob.glob (os.path.join (ns3_dir, 'build', 'scratch', '*droneMesh*'))
+                  if os.path.isfile (f) and os.access (f, os.X_OK) and not f.endswith ('.o')]
+    if not candidates:
+        sys.exit ('droneMesh binary not found under build/scratch, run ./waf build first or use --binary')
+    return max (candidates, key=os.path.getmtime)
+
+
+def node_count (sim_args):
+    """Number of nodes of a run, the last --nodes wins as in ns-3 CommandLine"""
+    nodes = DEFAULT_NODES
+    for arg in sim_args:
+        if arg.startswith ('--nodes='):
+            nodes = int (arg[len ('--nodes='):])
+    return nodes
+
+
+def make_runs (args):
+    """One entry per run: (metric, scenario label, seed, droneMesh arguments)"""
+    scenarios = []
+    for name in parse_list (args.scenarios):
+        # Compiled .wpt traces are used as given
+        path = name if name.endswith (('.ns_movements', '.wpt')) else name + '.ns_movements'
+        if not os.path.isabs (path):
+            path = os.path.abspath (os.path.join (args.scenario_dir, path))
+        scenarios.append ((os.path.splitext (os.path.basename (path))[0],
+                           ['--ns2mobility=1', '--scenario=' + path]))
+    topologies = parse_list (args.topologies)
+    if topologies:
+        # Runs start in their own directory, so the topology file is passed as an absolute path
+        topology_file = args.topology_file or os.path.join ('stationary-scenarios', 'set1',
+                                                            'n_eq_%d_3d.topo' % node_count (args.sim_args))
+        topology_file = os.path.abspath (topology_file)
+        if not os.path.isfile (topology_file):
+            sys.exit ('no topology file ' + topology_file)
+    for topo in topologies:
+        scenarios.append (('topology-' + topo, ['--ns2mobility=0', '--topology-file=' + topology_file,
+                                                '--topology=' + topo]))
+    runs = []
+    for metric, (label, scenario_args), seed in itertools.product (parse_list (args.metrics), scenarios,
+                                                                   parse_list (args.seeds)):
+        runs.append ((metric, label, seed, ['--metric=' + metric] + scenario_args + ['--RngRun=' + seed]))
+    return runs
+
+
+def run_dir (out, metric, label, seed):
+    return os.path.join (out, metric, label, 'run-' + seed)
+
+
+def execute (binary, env, directory, sim_args):
+    """Run one simulation in its own directory, return (status, wall seconds)"""
+    if os.path.isdir (directory):
+        # Leftovers of an interrupted run
+        shutil.rmtree (directory)
+    os.makedirs (directory)
+    start = time.time ()
+    with open (os.path.join (directory, 'stdout.txt'), 'w') as out, \
+            open (os.path.join (directory, 'stderr.txt'), 'w') as err:
+        code = subprocess.call ([binary, '--output-dir=' + directory] + sim_args,
+                                cwd=directory, env=env, stdout=out, stderr=err)
+    wall = time.time () - start
+    if code == 0:
+        with open (os.path.join (directory, 'done'), 'w') as done:
+            done.write ('%.3f\n' % wall)
+    return ('ok' if code == 0 else 'exit-%d' % code), wall
+
+
+def summarize (directory):
+    """Aggregate the flow monitor and route change files of one run"""
+    row = {'flows': 0, 'txPackets': 0, 'rxPackets': 0, 'lostPackets': 0}
+    delay_ns = 0.0
+    rx_bytes = 0
+    first_tx = None
+    last_rx = None
+    tree = ET.parse (os.path.join (directory, 'MeshPerformance.xml'))
+    for flow in tree.getroot ().iter ('Flow'):
+        if 'txPackets' not in flow.attrib:
+            continue
+        row['flows'] += 1
+        row['txPackets'] += int (flow.get ('txPackets'))
+        row['rxPackets'] += int (flow.get ('rxPackets'))
+        row['lostPackets'] += int (flow.get ('lostPackets'))
+        rx_bytes += int (flow.get ('rxBytes'))
+        delay_ns += parse_time_ns (flow.get ('delaySum'))
+        tx = parse_time_ns (flow.get ('timeFirstTxPacket'))
+        first_tx = tx if first_tx is None else min (first_tx, tx)
+        if int (flow.get ('rxPackets')) > 0:
+            rx = parse_time_ns (flow.get ('timeLastRxPacket'))
+            last_rx = rx if last_rx is None else max (last_rx, rx)
+    if row['txPackets']:
+        row['deliveryRatio'] = '%.6f' % (float (row['rxPackets']) / row['txPackets'])
+    if row['rxPackets']:
+        row['meanDelayMs'] = '%.6f' % (delay_ns / row['rxPackets'] / 1e6)
+    if last_rx is not None and last_rx > first_tx:
+        row['throughputKbps'] = '%.3f' % (rx_bytes * 8 / ((last_rx - first_tx) / 1e9) / 1e3)
+    changes = os.path.join (directory, 'rChanges.csv')
+    if os.path.exists (changes):
+        with open (changes) as f:
+            row['routeChanges'] = max (0, sum (1 for _ in f) - 1)
+    elif os.path.exists (os.path.join (directory, 'rChanges.bin')):
+        # --binary-traces: 8 byte header and 33 byte records, see droneMeshTraceToCsv.py
+        row['routeChanges'] = max (0, (os.path.getsize (os.path.join (directory, 'rChanges.bin')) - 8) // 33)
+    return row
+
+
+def main ():
+    parser = argparse.ArgumentParser (description='Parallel parameter sweep for scratch/droneMesh.cc',
+                                      epilog='Arguments after -- are passed to every run')
+    parser.add_argument ('--ns3-dir', default='.', help='ns-3 top level directory')
+    parser.add_argument ('--binary', help='droneMesh executable (default: newest under build/scratch)')
+    parser.add_argument ('--out', default='sweep', help='root of the run directories')
+    parser.add_argument ('--jobs', type=int, default=os.cpu_count () or 1, help='concurrent runs')
+    parser.add_argument ('--metrics', default='airtime', help='comma separated list')
+    parser.add_argument ('--scenarios', default='', help='ns2 mobility scenarios, e.g. gm3d-60-1,gm3d-60-2')
+    parser.add_argument ('--scenario-dir', default='mobile-scenarios', help='where the .ns_movements files are')
+    parser.add_argument ('--topologies', default='', help='stationary topologies, e.g. 0-29')
+    parser.add_argument ('--topology-file', default='',
+                         help='binary topology file (default: stationary-scenarios/set1/n_eq_<nodes>_3d.topo)')
+    parser.add_argument ('--seeds', default='1', help='RngRun values, e.g. 1-10')
+    parser.add_argument ('--force', action='store_true', help='rerun completed runs')
+    parser.add_argument ('sim_args', nargs='*', help='extra droneMesh arguments')
+    args = parser.parse_args ()
+
+    binary = os.path.abspath (args.binary) if args.binary else find_binary (args.ns3_dir)
+    out = os.path.abspath (args.out)
+    env = dict (os.environ)
+    lib_dir = os.path.abspath (os.path.join (args.ns3_dir, 'build', 'lib'))
+    env['LD_LIBRARY_PATH'] = lib_dir + os.pathsep + env.get ('LD_LIBRARY_PATH', '')
+
+    runs = make_runs (args)
+    if not runs:
+        sys.exit ('Empty grid: give --scenarios and/or --topologies')
+    pending = []
+    for metric, label, seed, sim_args in runs:
+        directory = run_dir (out, metric, label, seed)
+        if args.force or not os.path.exists (os.path.join (directory, 'done')):
+            pending.append ((directory, sim_args + args.sim_args))
+    print ('%d runs, %d already done, %d jobs' % (len (runs), len (runs) - len (pending), args.jobs))
+
+    failed = 0
+    with concurrent.futures.ThreadPoolExecutor (max_workers=args.jobs) as pool:
+        futures = dict ((pool.submit (execute, binary, env, d, a), d) for d, a in pending)
+        for n, future in enumerate (concurrent.futures.as_completed (futures), 1):
+            status, wall = future.result ()
+            failed += status != 'ok'
+            print ('[%d/%d] %s %s (%.1f s)' % (n, len (pending), os.path.relpath (futures[future], out), status, wall))
+            sys.stdout.flush ()
+
+    with open (os.path.join (out, 'summary.csv'), 'w') as f:
+        writer = csv.DictWriter (f, fieldnames=SUMMARY_FIELDS, restval='')
+        writer.writeheader ()
+        for metric, label, seed, _ in runs:
+            directory = run_dir (out, metric, label, seed)
+            row = {'metric': metric, 'scenario': label, 'seed': seed}
+            done = os.path.join (directory, 'done')
+            if os.path.exists (done):
+                with open (done) as d:
+                    row['wallSeconds'] = d.read ().strip ()
+                try:
+                    row.update (summarize (directory))
+                    row['status'] = 'ok'
+                except (IOError, OSError, ET.ParseError, ValueError):
+                    row['status'] = 'bad-output'
+            else:
+                row['status'] = 'failed'
+            writer.writerow (row)
+    print ('Summary written to ' + os.path.join (out, 'summary.csv'))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit (main ())
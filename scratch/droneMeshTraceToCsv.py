@@ -0,0 +1,91 @@
+#! /usr/bin/env python3
+#
+# Copyright (c) 2020 Oscar Bautista
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Author: Oscar Bautista <obaut004@fiu.edu>
+#
+"""
+Converts the binary traces written by droneMesh --binary-traces=1
+(rChanges.bin, courseChanges.bin) to the csv files droneMesh writes by
+default. The record layouts are documented next to MeshTest::RouteChangeSink.
+
+  ./scratch/droneMeshTraceToCsv.py rChanges.bin courseChanges.bin
+
+writes rChanges.csv and courseChanges.csv next to the inputs.
+"""
+
+import os
+import struct
+import sys
+
+ROUTE_CHANGE_TYPES = {0: 'Unknown', 1: 'Add Reactive', 2: 'Add Proactive',
+                      3: 'Delete Reactive', 4: 'Delete Proactive'}
+ROUTE_CHANGE = struct.Struct ('=qIB6s6sII')
+COURSE_CHANGE = struct.Struct ('=Iq6d')
+
+
+def time_str (ns):
+    # Same text as ns-3 prints a Time with nanosecond resolution
+    return '%+d.0ns' % ns
+
+
+def mac_str (raw):
+    return ':'.join ('%02x' % b for b in bytearray (raw))
+
+
+def vector_str (x, y, z):
+    # std::ostream default formatting of doubles
+    return '%g:%g:%g' % (x, y, z)
+
+
+def route_changes (data, out):
+    out.write ('Time,Node,Type,Destination,Retransmitter,Metric,SeqNumber\n')
+    for time, node, kind, dst, retransmitter, metric, seqnum in ROUTE_CHANGE.iter_unpack (data):
+        out.write ('%s,%d,%s,%s,%s,%d,%d\n' % (time_str (time), node, ROUTE_CHANGE_TYPES.get (kind, 'Unknown'),
+                                             mac_str (dst), mac_str (retransmitter), metric, seqnum))
+
+
+def course_changes (data, out):
+    out.write ('Node,Time,Position,Velocity\n')
+    for node, time, px, py, pz, vx, vy, vz in COURSE_CHANGE.iter_unpack (data):
+        out.write ('%d,%s,%s,%s\n' % (node, time_str (time), vector_str (px, py, pz), vector_str (vx, vy, vz)))
+
+
+FORMATS = {b'DMRC': (ROUTE_CHANGE, route_changes), b'DMCC': (COURSE_CHANGE, course_changes)}
+
+
+def convert (path):
+    with open (path, 'rb') as f:
+        data = f.read ()
+    magic, version = data[:4], struct.unpack ('=I', data[4:8])[0] if len (data) >= 8 else None
+    if magic not in FORMATS or version != 1:
+        sys.exit ('%s: not a droneMesh binary trace' % path)
+    layout, writer = FORMATS[magic]
+    body = data[8:]
+    if len (body) % layout.size:
+        sys.stderr.write ('%s: ignoring %d trailing bytes\n' % (path, len (body) % layout.size))
+        body = body[:len (body) - len (body) % layout.size]
+    target = os.path.splitext (path)[0] + '.csv'
+    with open (target, 'w') as out:
+        writer (body, out)
+    print ('%s -> %s (%d records)' % (path, target, len (body) // layout.size))
+
+
+if __name__ == '__main__':
+    if len (sys.argv) < 2:
+        sys.exit (__doc__)
+    for name in sys.argv[1:]:
+        convert (name)
@@ -0,0 +1,70 @@
+#! /usr/bin/env python3
+#
+# Copyright (c) 2020 Oscar Bautista
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Author: Oscar Bautista <obaut004@fiu.edu>
+#
+"""
+Converts an n_eq_*_3d.h coordinate table to the binary topology format read
+by droneMesh --topology-file (see scratch/topology-file.h):
+
+  4 bytes  magic "DMTP"
+  uint32   version (1)
+  uint32   number of topologies
+  uint32   nodes per topology
+  float32  x, y, z of every node, topology after topology
+
+All fields are little endian.
+
+  ./scratch/nEqToTopology.py stationary-scenarios/set1/n_eq_60_3d.h [out.topo]
+"""
+
+import os
+import re
+import struct
+import sys
+
+NUMBER = r'([-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?)'
+TABLE = re.compile (r'struct\s+coordinates\s+\w+\s*\[\s*(\d+)\s*\]\s*\[\s*(\d+)\s*\]')
+COORDINATE = re.compile (r'\{\s*' + NUMBER + r'\s*,\s*' + NUMBER + r'\s*,\s*' + NUMBER + r'\s*\}')
+
+
+def convert (source, target):
+    with open (source) as f:
+        text = f.read ()
+    table = TABLE.search (text)
+    if not table:
+        sys.exit ('%s: no coordinates table found' % source)
+    n_topologies, n_nodes = int (table.group (1)), int (table.group (2))
+    # Drop comments such as //#0 before picking the coordinates
+    body = re.sub (r'//[^\n]*', '', text[table.end ():])
+    values = [tuple (float (v) for v in m.groups ()) for m in COORDINATE.finditer (body)]
+    if len (values) != n_topologies * n_nodes:
+        sys.exit ('%s: expected %d coordinates, found %d' % (source, n_topologies * n_nodes, len (values)))
+    with open (target, 'wb') as out:
+        out.write (b'DMTP')
+        out.write (struct.pack ('<III', 1, n_topologies, n_nodes))
+        for x, y, z in values:
+            out.write (struct.pack ('<fff', x, y, z))
+    print ('%s -> %s (%d topologies of %d nodes)' % (source, target, n_topologies, n_nodes))
+
+
+if __name__ == '__main__':
+    if len (sys.argv) not in (2, 3):
+        sys.exit (__doc__)
+    source = sys.argv[1]
+    target = sys.argv[2] if len (sys.argv) == 3 else os.path.splitext (source)[0] + '.topo'
+    convert (source, target)
@@ -0,0 +1,110 @@
+#! /usr/bin/env python3
+#
+# Copyright (c) 2020 Oscar Bautista
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Author: Oscar Bautista <obaut004@fiu.edu>
+#
+"""
+Compiles an ns2 movement trace (.ns_movements) into the binary waypoint
+format streamed by droneMesh when --scenario names a .wpt file (see
+scratch/waypoint-stream.h). All fields are little endian:
+
+  4 bytes    magic "DMWP"
+  uint32     version (1)
+  uint32     number of nodes
+  uint32     reserved (0)
+  float64[3] initial x, y, z of every node
+  uint64[2]  offset (bytes from the start of the file) and number of
+             waypoints of every node
+  waypoints  float64 time, x, y, z, speed per waypoint, grouped by node
+             and sorted by time; z is NaN when the setdest had no z
+
+Only the lines droneMesh scenarios use are understood: initial
+'$node_(i) set X_|Y_|Z_ v' and '$ns_ at t "$node_(i) setdest x y [z] speed"'.
+
+  ./scratch/ns2ToWaypoints.py mobile-scenarios/gm3d-60-1.ns_movements [out.wpt]
+"""
+
+import os
+import re
+import struct
+import sys
+
+NUMBER = r'([-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?)'
+INITIAL = re.compile (r'^\$node_\((\d+)\)\s+set\s+([XYZ])_\s+' + NUMBER + r'\s*$')
+SETDEST = re.compile (r'^\$ns_\s+at\s+' + NUMBER + r'\s+"\$node_\((\d+)\)\s+setdest\s+([^"]*)"\s*$')
+HEADER = struct.Struct ('<4sIII')
+WAYPOINT = struct.Struct ('<5d')
+
+
+def parse (source):
+    initial = {}
+    waypoints = {}
+    with open (source) as f:
+        for number, line in enumerate (f, 1):
+            line = line.strip ()
+            if not line or line.startswith ('#'):
+                continue
+            m = INITIAL.match (line)
+            if m:
+                initial.setdefault (int (m.group (1)), [0.0, 0.0, 0.0])['XYZ'.index (m.group (2))] = float (m.group (3))
+                continue
+            m = SETDEST.match (line)
+            if m:
+                args = [float (v) for v in m.group (3).split ()]
+                if len (args) == 3:
+                    x, y, speed = args
+                    z = float ('nan')
+                elif len (args) == 4:
+                    x, y, z, speed = args
+                else:
+                    sys.exit ('%s:%d: bad setdest' % (source, number))
+                waypoints.setdefault (int (m.group (2)), []).append ((float (m.group (1)), x, y, z, speed))
+                continue
+            sys.stderr.write ('%s:%d: ignoring unsupported line: %s\n' % (source, number, line))
+    return initial, waypoints
+
+
+def compile_trace (source, target):
+    initial, waypoints = parse (source)
+    n_nodes = max (list (initial.keys ()) + list (waypoints.keys ())) + 1 if (initial or waypoints) else 0
+    index_offset = HEADER.size + n_nodes * 24
+    offset = index_offset + n_nodes * 16
+    index = []
+    for node in range (n_nodes):
+        # Stable sort keeps the file order of waypoints with the same time
+        points = sorted (waypoints.get (node, []), key=lambda p: p[0])
+        waypoints[node] = points
+        index.append ((offset, len (points)))
+        offset += len (points) * WAYPOINT.size
+    with open (target, 'wb') as out:
+        out.write (HEADER.pack (b'DMWP', 1, n_nodes, 0))
+        for node in range (n_nodes):
+            out.write (struct.pack ('<3d', *initial.get (node, [0.0, 0.0, 0.0])))
+        for entry in index:
+            out.write (struct.pack ('<QQ', *entry))
+        for node in range (n_nodes):
+            for point in waypoints[node]:
+                out.write (WAYPOINT.pack (*point))
+    print ('%s -> %s (%d nodes, %d waypoints)' % (source, target, n_nodes, sum (n for _, n in index)))
+
+
+if __name__ == '__main__':
+    if len (sys.argv) not in (2, 3):
+        sys.exit (__doc__)
+    source = sys.argv[1]
+    target = sys.argv[2] if len (sys.argv) == 3 else os.path.splitext (source)[0] + '.wpt'
+    compile_trace (source, target)
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#ifndef TOPOLOGY_FILE_H
+#define TOPOLOGY_FILE_H
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+/**
+ * \brief Read only view of a binary topology file
+ *
+ * The file holds several stationary topologies of the same number of nodes,
+ * as produced by scratch/nEqToTopology.py from the n_eq_*_3d.h tables:
+ * a 16 byte header ("DMTP", version 1, number of topologies, nodes per
+ * topology, all uint32 little endian) followed by float32 x, y, z per node.
+ * The file is memory mapped, so opening it costs the same for any size.
+ * Coordinates are float32, i.e. exact to about 0.1 mm for a few km.
+ */
+class TopologyFile
+{
+public:
+  TopologyFile ()
+    : m_data (0),
+      m_size (0),
+      m_nTopologies (0),
+      m_nNodes (0)
+  {
+  }
+  ~TopologyFile ()
+  {
+    Close ();
+  }
+  /**
+   * \param fileName the topology file
+   * \returns an empty string on success, the reason of the failure otherwise
+   */
+  std::string Open (std::string fileName)
+  {
+    Close ();
+    int fd = open (fileName.c_str (), O_RDONLY);
+    if (fd < 0)
+      {
+        return "can't open " + fileName;
+      }
+    struct stat st;
+    if (fstat (fd, &st) != 0 || st.st_size < HEADER_SIZE)
+      {
+        close (fd);
+        return fileName + " is not a topology file";
+      }
+    void *data = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (data == MAP_FAILED)
+      {
+        return "can't map " + fileName;
+      }
+    m_data = static_cast<const uint8_t *> (data);
+    m_size = st.st_size;
+    if (std::memcmp (m_data, "DMTP", 4) != 0 || ReadUint32 (4) != 1)
+      {
+        Close ();
+        return fileName + " is not a version 1 topology file";
+      }
+    m_nTopologies = ReadUint32 (8);
+    m_nNodes = ReadUint32 (12);
+    if (m_size != HEADER_SIZE + (uint64_t)m_nTopologies * m_nNodes * 12)
+      {
+        Close ();
+        return fileName + " is truncated";
+      }
+    return "";
+  }
+  /// Unmap the file
+  void Close (void)
+  {
+    if (m_data != 0)
+      {
+        munmap (const_cast<uint8_t *> (m_data), m_size);
+      }
+    m_data = 0;
+    m_size = 0;
+    m_nTopologies = 0;
+    m_nNodes = 0;
+  }
+  /// \returns the number of topologies in the file
+  uint32_t GetNTopologies (void) const
+  {
+    return m_nTopologies;
+  }
+  /// \returns the number of nodes of every topology
+  uint32_t GetNNodes (void) const
+  {
+    return m_nNodes;
+  }
+  /**
+   * \param topology the topology index
+   * \param node the node index
+   * \returns the position of the node
+   */
+  Vector GetPosition (uint32_t topology, uint32_t node) const
+  {
+    uint64_t offset = HEADER_SIZE + ((uint64_t)topology * m_nNodes + node) * 12;
+    return Vector (ReadFloat (offset), ReadFloat (offset + 4), ReadFloat (offset + 8));
+  }
+
+private:
+  /// Not copyable, the mapping is owned
+  TopologyFile (const TopologyFile &);
+  /// Not copyable
+  TopologyFile & operator= (const TopologyFile &);
+
+  static const int HEADER_SIZE = 16; ///< magic, version, topologies, nodes
+
+  /**
+   * \param offset byte offset in the file
+   * \returns the little endian uint32_t at that offset
+   */
+  uint32_t ReadUint32 (uint64_t offset) const
+  {
+    const uint8_t *p = m_data + offset;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+  /**
+   * \param offset byte offset in the file
+   * \returns the little endian float32 at that offset
+   */
+  double ReadFloat (uint64_t offset) const
+  {
+    uint32_t bits = ReadUint32 (offset);
+    float value;
+    std::memcpy (&value, &bits, sizeof (value));
+    return value;
+  }
+
+  const uint8_t *m_data;   ///< the mapped file
+  uint64_t m_size;         ///< size of the mapping
+  uint32_t m_nTopologies;  ///< number of topologies
+  uint32_t m_nNodes;       ///< nodes per topology
+};
+
+} // namespace ns3
+
+#endif /* TOPOLOGY_FILE_H */
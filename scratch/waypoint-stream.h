@@ -0,0 +1,321 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#ifndef WAYPOINT_STREAM_H
+#define WAYPOINT_STREAM_H
+
+#include <stdint.h>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+
+namespace ns3 {
+
+/**
+ * \brief Read only view of a waypoint file compiled by scratch/ns2ToWaypoints.py
+ *
+ * The file is memory mapped and waypoints are decoded on demand, so only
+ * the pages of the waypoints being used stay resident. See the converter
+ * for the layout.
+ */
+class WaypointStream
+{
+public:
+  /// A setdest command
+  struct Waypoint
+  {
+    double time;      ///< when the node starts moving (s)
+    Vector position;  ///< destination, z is NaN if the trace gave none
+    double speed;     ///< speed (m/s)
+  };
+
+  WaypointStream ()
+    : m_data (0),
+      m_size (0),
+      m_nNodes (0)
+  {
+  }
+  ~WaypointStream ()
+  {
+    Close ();
+  }
+  /**
+   * \param fileName the waypoint file
+   * \returns an empty string on success, the reason of the failure otherwise
+   */
+  std::string Open (std::string fileName)
+  {
+    Close ();
+    int fd = open (fileName.c_str (), O_RDONLY);
+    if (fd < 0)
+      {
+        return "can't open " + fileName;
+      }
+    struct stat st;
+    if (fstat (fd, &st) != 0 || st.st_size < HEADER_SIZE)
+      {
+        close (fd);
+        return fileName + " is not a waypoint file";
+      }
+    void *data = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (data == MAP_FAILED)
+      {
+        return "can't map " + fileName;
+      }
+    m_data = static_cast<const uint8_t *> (data);
+    m_size = st.st_size;
+    if (std::memcmp (m_data, "DMWP", 4) != 0 || ReadUint (4, 4) != 1)
+      {
+        Close ();
+        return fileName + " is not a version 1 waypoint file";
+      }
+    m_nNodes = ReadUint (8, 4);
+    if (m_size < HEADER_SIZE + (uint64_t)m_nNodes * 40)
+      {
+        Close ();
+        return fileName + " is truncated";
+      }
+    for (uint32_t node = 0; node < m_nNodes; node++)
+      {
+        if (GetOffset (node) + GetNWaypoints (node) * WAYPOINT_SIZE > m_size)
+          {
+            Close ();
+            return fileName + " is truncated";
+          }
+      }
+    return "";
+  }
+  /// Unmap the file
+  void Close (void)
+  {
+    if (m_data != 0)
+      {
+        munmap (const_cast<uint8_t *> (m_data), m_size);
+      }
+    m_data = 0;
+    m_size = 0;
+    m_nNodes = 0;
+  }
+  /// \returns the number of nodes in the trace
+  uint32_t GetNNodes (void) const
+  {
+    return m_nNodes;
+  }
+  /**
+   * \param node the node id
+   * \returns the position of the node before its first waypoint
+   */
+  Vector GetInitialPosition (uint32_t node) const
+  {
+    uint64_t offset = HEADER_SIZE + (uint64_t)node * 24;
+    return Vector (ReadDouble (offset), ReadDouble (offset + 8), ReadDouble (offset + 16));
+  }
+  /**
+   * \param node the node id
+   * \returns the number of waypoints of the node
+   */
+  uint64_t GetNWaypoints (uint32_t node) const
+  {
+    return ReadUint (IndexOffset (node) + 8, 8);
+  }
+  /**
+   * \param node the node id
+   * \param i the waypoint index, waypoints are sorted by time
+   * \returns the waypoint
+   */
+  Waypoint GetWaypoint (uint32_t node, uint64_t i) const
+  {
+    uint64_t offset = GetOffset (node) + i * WAYPOINT_SIZE;
+    Waypoint waypoint;
+    waypoint.time = ReadDouble (offset);
+    waypoint.position = Vector (ReadDouble (offset + 8), ReadDouble (offset + 16), ReadDouble (offset + 24));
+    waypoint.speed = ReadDouble (offset + 32);
+    return waypoint;
+  }
+
+private:
+  /// Not copyable, the mapping is owned
+  WaypointStream (const WaypointStream &);
+  /// Not copyable
+  WaypointStream & operator= (const WaypointStream &);
+
+  static const int HEADER_SIZE = 16;   ///< magic, version, nodes, reserved
+  static const int WAYPOINT_SIZE = 40; ///< time, x, y, z, speed
+
+  /**
+   * \param node the node id
+   * \returns the offset of the index entry of the node
+   */
+  uint64_t IndexOffset (uint32_t node) const
+  {
+    return HEADER_SIZE + (uint64_t)m_nNodes * 24 + (uint64_t)node * 16;
+  }
+  /**
+   * \param node the node id
+   * \returns the offset of the first waypoint of the node
+   */
+  uint64_t GetOffset (uint32_t node) const
+  {
+    return ReadUint (IndexOffset (node), 8);
+  }
+  /**
+   * \param offset byte offset in the file
+   * \param size 4 or 8
+   * \returns the little endian unsigned integer at that offset
+   */
+  uint64_t ReadUint (uint64_t offset, int size) const
+  {
+    uint64_t value = 0;
+    for (int i = size - 1; i >= 0; i--)
+      {
+        value = (value << 8) | m_data[offset + i];
+      }
+    return value;
+  }
+  /**
+   * \param offset byte offset in the file
+   * \returns the little endian float64 at that offset
+   */
+  double ReadDouble (uint64_t offset) const
+  {
+    uint64_t bits = ReadUint (offset, 8);
+    double value;
+    std::memcpy (&value, &bits, sizeof (value));
+    return value;
+  }
+
+  const uint8_t *m_data;  ///< the mapped file
+  uint64_t m_size;        ///< size of the mapping
+  uint32_t m_nNodes;      ///< number of nodes
+};
+
+/**
+ * \brief Installs ConstantVelocityMobilityModels driven by a WaypointStream
+ *
+ * Unlike Ns2MobilityHelper, which schedules every movement of the trace at
+ * startup, only the next waypoint of each node is scheduled; applying it
+ * schedules the following one. Memory use therefore does not depend on the
+ * length of the trace. Movements follow the ns2 setdest semantics used by
+ * Ns2MobilityHelper: straight line at constant speed from the current
+ * position, stopping on arrival, a new waypoint overriding a movement in
+ * progress. The installer must outlive the simulation.
+ */
+class WaypointStreamInstaller
+{
+public:
+  /**
+   * Node i of the trace drives the node with id i, as Ns2MobilityHelper does.
+   * \param fileName the waypoint file
+   * \returns an empty string on success, the reason of the failure otherwise
+   */
+  std::string Install (std::string fileName)
+  {
+    std::string error = m_stream.Open (fileName);
+    if (!error.empty ())
+      {
+        return error;
+      }
+    m_nodes.clear ();
+    m_nodes.resize (m_stream.GetNNodes ());
+    for (uint32_t i = 0; i < m_stream.GetNNodes () && i < NodeList::GetNNodes (); i++)
+      {
+        Ptr<Node> node = NodeList::GetNode (i);
+        Ptr<ConstantVelocityMobilityModel> model = node->GetObject<ConstantVelocityMobilityModel> ();
+        if (model == 0)
+          {
+            model = CreateObject<ConstantVelocityMobilityModel> ();
+            node->AggregateObject (model);
+          }
+        model->SetPosition (m_stream.GetInitialPosition (i));
+        m_nodes[i].model = model;
+        ScheduleNext (i);
+      }
+    return "";
+  }
+
+private:
+  /// Progress of a node through its waypoints
+  struct NodeState
+  {
+    NodeState () : next (0) {}
+    Ptr<ConstantVelocityMobilityModel> model; ///< the mobility model of the node
+    uint64_t next;                            ///< index of the next waypoint
+    EventId arrival;                          ///< stops the node at its destination
+  };
+
+  /**
+   * Schedule the next waypoint of a node, if any
+   * \param node the node id
+   */
+  void ScheduleNext (uint32_t node)
+  {
+    NodeState &state = m_nodes[node];
+    if (state.next < m_stream.GetNWaypoints (node))
+      {
+        Time at = Seconds (m_stream.GetWaypoint (node, state.next).time);
+        Simulator::Schedule (std::max (at - Simulator::Now (), Seconds (0)), &WaypointStreamInstaller::Apply, this, node);
+      }
+  }
+  /**
+   * Start moving a node towards its next waypoint
+   * \param node the node id
+   */
+  void Apply (uint32_t node)
+  {
+    NodeState &state = m_nodes[node];
+    WaypointStream::Waypoint waypoint = m_stream.GetWaypoint (node, state.next++);
+    state.arrival.Cancel ();
+    Vector from = state.model->GetPosition ();
+    Vector to = waypoint.position;
+    if (std::isnan (to.z))
+      {
+        to.z = from.z;
+      }
+    double distance = CalculateDistance (from, to);
+    if (waypoint.speed > 0 && distance > 0)
+      {
+        double time = distance / waypoint.speed;
+        state.model->SetVelocity (Vector ((to.x - from.x) / time, (to.y - from.y) / time, (to.z - from.z) / time));
+        state.arrival = Simulator::Schedule (Seconds (time), &ConstantVelocityMobilityModel::SetVelocity,
+                                             state.model, Vector (0, 0, 0));
+      }
+    else
+      {
+        state.model->SetVelocity (Vector (0, 0, 0));
+      }
+    ScheduleNext (node);
+  }
+
+  WaypointStream m_stream;        ///< the trace
+  std::vector<NodeState> m_nodes; ///< per node progress
+};
+
+} // namespace ns3
+
+#endif /* WAYPOINT_STREAM_H */
@@ -29,8 +29,10 @@
 
 #include "hwmp-neighbor-etx.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
 #include <math.h>
 #include <stdint.h>
+#include <algorithm>
 
 namespace ns3
 {
@@ -40,125 +42,404 @@ NS_LOG_COMPONENT_DEFINE ("HwmpNeighborEtx");
 namespace dot11s
 {
 
-NeighborEtx::NeighborEtx () : m_lppTimeStamp (0) {}
+namespace
+{
+// Largest product of forward and reverse LPP counts kept in the table
+const uint32_t MAX_COUNT_PRODUCT = (NeighborEtx::MAX_WINDOW - 2) * (NeighborEtx::MAX_WINDOW - 2);
+
+// ETX scaled by 100000 for every product of forward and reverse LPP counts,
+// built once so the estimator does not divide per lookup
+class EtxReciprocalTable
+{
+public:
+  EtxReciprocalTable ()
+  {
+    m_etx[0] = ETX_MAX;
+    for (uint32_t product = 1; product <= MAX_COUNT_PRODUCT; product++)
+      {
+        m_etx[product] = (uint32_t) (round (100000.0 / product));
+      }
+  }
+  uint32_t Get (uint32_t product) const
+  {
+    if (product > MAX_COUNT_PRODUCT)
+      {
+        // Only a neighbor with a wider window reports such reverse counts
+        return (uint32_t) (round (100000.0 / product));
+      }
+    return m_etx[product];
+  }
+private:
+  uint32_t m_etx[MAX_COUNT_PRODUCT + 1];
+};
+
+const EtxReciprocalTable &
+GetEtxReciprocalTable ()
+{
+  static const EtxReciprocalTable table;
+  return table;
+}
+} // namespace
+
+NeighborEtx::NeighborEtx ()
+  : m_nextWheelTag (0),
+    m_timeout (Seconds (0)),
+    m_maxSize (0),
+    m_evictedExpired (0),
+    m_evictedOverflow (0),
+    m_evictedIdle (0),
+    m_lppTimeStamp (0),
+    m_version (0)
+{
+  m_wheel.SetExpiryCallback (MakeCallback (&NeighborEtx::Expire, this));
+  SetWindow (12);
+}
+
+void
+NeighborEtx::SetWindow (uint32_t window)
+{
+  NS_ASSERT (window >= 3 && window <= MAX_WINDOW);
+  m_window = window;
+  m_windowMask = (window == 64) ? ~(uint64_t)0 : ((uint64_t)1 << window) - 1;
+  m_lppTimeStamp = 0;
+  m_countMask = m_windowMask & ~((uint64_t)1 << m_lppTimeStamp) & ~((uint64_t)1 << CalculateNextLppTimeStamp (m_lppTimeStamp));
+  for (uint32_t i = 0; i < m_neighbors.size (); i++)
+    {
+      m_lppMyCntMap[i] &= m_windowMask;
+      UpdateEtx (i);
+    }
+}
+
+void
+NeighborEtx::SetEtxChangeCallback (Callback<void, Mac48Address, uint32_t, uint32_t> cb)
+{
+  m_etxChanged = cb;
+}
+
+void
+NeighborEtx::SetLimits (Time timeout, uint32_t maxSize)
+{
+  m_timeout = timeout;
+  m_maxSize = maxSize;
+}
+
+Time
+NeighborEtx::Expire (uint64_t key, uint32_t tag)
+{
+  uint32_t i = FindNeighbor (key);
+  if (i == m_neighbors.size () || m_neighbors[i].m_wheelTag != tag || m_timeout.IsZero ())
+    {
+      return Simulator::Now ();
+    }
+  if (m_neighbors[i].m_lastLpp + m_timeout > Simulator::Now ())
+    {
+      return m_neighbors[i].m_lastLpp + m_timeout;
+    }
+  EraseNeighbor (i);
+  m_evictedExpired++;
+  return Simulator::Now ();
+}
+
+uint32_t
+NeighborEtx::GetHome (uint64_t key) const
+{
+  // Fibonacci hashing spreads the sequential addresses of ns-3 nodes
+  return (key * 0x9E3779B97F4A7C15ULL) >> 32 & (m_index.size () - 1);
+}
+
+uint32_t
+NeighborEtx::FindIndexSlot (uint64_t key) const
+{
+  if (m_neighbors.empty ())
+    {
+      return m_index.size ();
+    }
+  for (uint32_t slot = GetHome (key); ; slot = (slot + 1) & (m_index.size () - 1))
+    {
+      if (m_index[slot].m_key == key)
+        {
+          return slot;
+        }
+      if (m_index[slot].m_key == EMPTY_KEY)
+        {
+          return m_index.size ();
+        }
+    }
+}
 
-// There are 12 different ETX timeslots: [ 0, 1, 2, ..., 11, 0, 1, ...] each with value 0 or 1
+uint32_t
+NeighborEtx::FindNeighbor (uint64_t key) const
+{
+  uint32_t slot = FindIndexSlot (key);
+  if (slot == m_index.size ())
+    {
+      return m_neighbors.size ();
+    }
+  return m_index[slot].m_neighbor;
+}
+
+uint32_t
+NeighborEtx::InsertNeighbor (uint64_t key)
+{
+  NS_ASSERT (FindIndexSlot (key) == m_index.size ());
+  if (2 * (m_neighbors.size () + 1) > m_index.size ())
+    {
+      IndexSlot empty;
+      empty.m_key = EMPTY_KEY;
+      empty.m_neighbor = 0;
+      std::vector<IndexSlot> index (std::max<size_t> (16, 2 * m_index.size ()), empty);
+      m_index.swap (index);
+      for (std::vector<IndexSlot>::const_iterator i = index.begin (); i != index.end (); i++)
+        {
+          if (i->m_key != EMPTY_KEY)
+            {
+              uint32_t home = GetHome (i->m_key);
+              while (m_index[home].m_key != EMPTY_KEY)
+                {
+                  home = (home + 1) & (m_index.size () - 1);
+                }
+              m_index[home] = *i;
+            }
+        }
+    }
+  uint32_t slot;
+  for (slot = GetHome (key); m_index[slot].m_key != EMPTY_KEY; slot = (slot + 1) & (m_index.size () - 1))
+    {
+    }
+  uint32_t neighbor = m_neighbors.size ();
+  m_index[slot].m_key = key;
+  m_index[slot].m_neighbor = neighbor;
+  Neighbor n;
+  n.m_key = key;
+  n.m_wheelTag = 0;
+  n.m_idle = 0;
+  m_neighbors.push_back (n);
+  m_lppMyCntMap.push_back (0);
+  m_lppReverse.push_back (0);
+  m_etx.push_back (ETX_MAX);
+  return neighbor;
+}
+
+void
+NeighborEtx::EraseNeighbor (uint32_t neighbor)
+{
+  uint64_t key = m_neighbors[neighbor].m_key;
+  uint32_t etx = m_etx[neighbor];
+  // Empty the index slot, shifting back the following entries of its probe
+  // sequence so that no tombstones are needed
+  uint32_t slot = FindIndexSlot (key);
+  NS_ASSERT (slot != m_index.size ());
+  uint32_t mask = m_index.size () - 1;
+  uint32_t next = (slot + 1) & mask;
+  while (m_index[next].m_key != EMPTY_KEY)
+    {
+      // Move the entry back if the hole lies between its home and its slot
+      uint32_t home = GetHome (m_index[next].m_key);
+      if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+          m_index[slot] = m_index[next];
+          slot = next;
+        }
+      next = (next + 1) & mask;
+    }
+  m_index[slot].m_key = EMPTY_KEY;
+  // Keep the arrays dense by moving the last neighbor to the freed position
+  uint32_t last = m_neighbors.size () - 1;
+  if (neighbor != last)
+    {
+      m_index[FindIndexSlot (m_neighbors[last].m_key)].m_neighbor = neighbor;
+      m_neighbors[neighbor] = m_neighbors[last];
+      m_lppMyCntMap[neighbor] = m_lppMyCntMap[last];
+      m_lppReverse[neighbor] = m_lppReverse[last];
+      m_etx[neighbor] = m_etx[last];
+    }
+  m_neighbors.pop_back ();
+  m_lppMyCntMap.pop_back ();
+  m_lppReverse.pop_back ();
+  m_etx.pop_back ();
+  ReportEtxChange (MeshTimerWheel::GetAddress (key), etx, ETX_MAX);
+}
+
+// There are m_window different ETX timeslots: [ 0, 1, 2, ..., m_window - 1, 0, 1, ...] each with value 0 or 1
 // but 2 values are not included in etx (lpp count): current and oldest
 
 uint8_t
-NeighborEtx::CalculateNextLppTimeStamp (uint8_t currTimeStamp)
+NeighborEtx::CalculateNextLppTimeStamp (uint8_t currTimeStamp) const
 {
   uint8_t nextTimeStamp = currTimeStamp + 1;
-  if (nextTimeStamp > 11)
+  if (nextTimeStamp >= m_window)
     {
       nextTimeStamp = 0;
     }
   return nextTimeStamp;
 }
 
-void
-NeighborEtx::GotoNextLppTimeStamp ()
-{
-  m_lppTimeStamp = CalculateNextLppTimeStamp (m_lppTimeStamp);
-}
-
-// There are 12 different ETX timeslots: [ 0, 1, 2, ..., 11, 0, 1, ...] each with value 0 or 1
-// but 2 values are not included in etx (lpp count):
+// 2 time slots are not included in etx (lpp count), m_countMask leaves them out:
 // 1. curent time slot because of jitter some nodes have transmited before this node
 //    and some nodes will transmit after current, so packet count would not be fair (nodes that transmitted before
 //    would be having one more lpp count)
 // 2. oldest time slot value will be deleted so it sholud not be included in calculation of lpp count
-uint8_t
-NeighborEtx::Lpp10bMapToCnt (uint16_t lpp10bMap)
+void
+NeighborEtx::GotoNextLppTimeStamp ()
 {
-  uint8_t lpp = 0;
-  for (int j=0; j<12; ++j)
-    {
-      if ((j!=m_lppTimeStamp) && (j!=CalculateNextLppTimeStamp(m_lppTimeStamp)))
-        {
-          lpp += (lpp10bMap & ((uint16_t)0x0001 << j)) ? 1 : 0;
-        }
-    }
-  return lpp;
+  m_lppTimeStamp = CalculateNextLppTimeStamp (m_lppTimeStamp);
+  m_countMask = m_windowMask & ~((uint64_t)1 << m_lppTimeStamp) & ~((uint64_t)1 << CalculateNextLppTimeStamp (m_lppTimeStamp));
 }
 
 void
 NeighborEtx::GotoNextTimeStampAndClearOldest ()
 {
+  m_wheel.Advance ();
   GotoNextLppTimeStamp (); // go to  next times slot which becomes current time slot
   // Clear oldest time slot lpp count values, this is next time slot related to current
 
   // Oldest Time Slot is next bit (cyclically) after current Time Slot
   uint8_t OldestLppTimeSlot = CalculateNextLppTimeStamp (m_lppTimeStamp);
 
-  for (std::map<Mac48Address, Etx>::iterator i = m_neighborEtx.begin (); i != m_neighborEtx.end (); ++i)
+  // Delete oldest times slot lpp count (this is next time slot related to current)
+  // Only the lower m_window bits are used
+  uint64_t keep = m_windowMask & ~((uint64_t)1 << OldestLppTimeSlot);
+  uint64_t * maps = m_lppMyCntMap.data ();
+  uint32_t n = m_lppMyCntMap.size ();
+  for (uint32_t i = 0; i < n; i++)
     {
-      Etx etx = i->second;
-      uint16_t lppMyCnt10bMap = etx.m_lppMyCnt10bMap;
-      // Delete oldest times slot lpp count (this is next time slot related to current)
-      // Only lower 12 bits are used
-      lppMyCnt10bMap &= (uint16_t)(~((uint16_t)0x0001 << OldestLppTimeSlot) & (uint16_t)0x0FFF);
-      etx.m_lppMyCnt10bMap = lppMyCnt10bMap;
-      i->second = etx;
+      maps[i] &= keep;
+    }
+  // The counted time slots moved too, so every ETX may change. Going
+  // backwards, erasing a neighbor moves one already visited to its position.
+  for (uint32_t i = n; i-- > 0; )
+    {
+      if (maps[i] != 0)
+        {
+          m_neighbors[i].m_idle = 0;
+        }
+      else if (++m_neighbors[i].m_idle >= m_window)
+        {
+          // Nothing heard for a whole window, the neighbor is gone
+          EraseNeighbor (i);
+          m_evictedIdle++;
+          continue;
+        }
+      UpdateEtx (i);
     }
 }
 
 void
-NeighborEtx::FillLppCntData (IeLpp &ielpp)
+NeighborEtx::FillLppCntData (std::vector<IeLpp> &ielpp)
 {
-  for (std::map<Mac48Address, Etx>::iterator i = m_neighborEtx.begin (); i != m_neighborEtx.end (); ++i)
+  // IeLpp shares the leading address bytes with the previous neighbor, so
+  // the neighbors are added in address order, which is the order of the keys
+  m_sendOrder.clear ();
+  for (uint32_t i = 0; i < m_neighbors.size (); i++)
+    {
+      if (LppMapToCnt (m_lppMyCntMap[i]) > 0)
+        {
+          m_sendOrder.push_back (std::make_pair (m_neighbors[i].m_key, i));
+        }
+    }
+  std::sort (m_sendOrder.begin (), m_sendOrder.end ());
+  uint32_t used = 1;
+  ielpp.resize (1);
+  ielpp[0].ClearNeighborsList ();
+  for (uint32_t j = 0; j < m_sendOrder.size (); j++)
+    {
+      uint8_t lpp = LppMapToCnt (m_lppMyCntMap[m_sendOrder[j].second]);
+      Mac48Address addr = MeshTimerWheel::GetAddress (m_sendOrder[j].first);
+      if (!ielpp[used - 1].AddToNeighborsList (addr, lpp))
         {
-          uint8_t lpp = Lpp10bMapToCnt (i->second.m_lppMyCnt10bMap);
-          if (lpp > 0)
+          if (used == IeLpp::MAX_FRAGMENTS)
             {
-              ielpp.AddToNeighborsList (i->first, lpp);
-              //NS_LOG_UNCOND ("           MAC=" <", lpp=" << (uint16_t)lpp << ", rev=" << (uint16_t)(i->second.m_lppReverse) << ", ETX-bin-shift=" << CalculateBinaryShiftedEtx (i->second));
+              NS_LOG_DEBUG ("LPP neighbor list full, leaving out " << addr);
+              continue;
             }
+          used++;
+          ielpp.resize (used);
+          ielpp[used - 1].AddToNeighborsList (addr, lpp);
         }
+    }
+  for (uint32_t k = 0; k < used; k++)
+    {
+      ielpp[k].SetFragment (k, used);
+    }
 }
 
 bool
 NeighborEtx::UpdateNeighborEtx (Mac48Address addr, uint8_t lppTimeStamp, uint8_t lppReverse)
 {
-  std::map<Mac48Address, Etx>::iterator i = m_neighborEtx.find (addr);
-  if (i == m_neighborEtx.end ())
+  m_wheel.Advance ();
+  // A time slot outside the window comes from a node configured with a wider one
+  uint64_t lppBit = (lppTimeStamp < m_window) ? (uint64_t)1 << lppTimeStamp : 0;
+  uint64_t key = MeshTimerWheel::GetKey (addr);
+  uint32_t i = FindNeighbor (key);
+  if (i == m_neighbors.size ())
     {
+      if (m_maxSize > 0 && m_neighbors.size () >= m_maxSize)
+        {
+          // Make room by removing the neighbor silent for the longest time
+          uint32_t oldest = 0;
+          for (uint32_t j = 1; j < m_neighbors.size (); j++)
+            {
+              if (m_neighbors[j].m_lastLpp < m_neighbors[oldest].m_lastLpp)
+                {
+                  oldest = j;
+                }
+            }
+          EraseNeighbor (oldest);
+          m_evictedOverflow++;
+        }
       // No address, insert new entry
-      Etx etx;
-      etx.m_lppReverse = lppReverse;
-      etx.m_lppMyCnt10bMap = (uint16_t)0x0001 << lppTimeStamp;
-      std::pair<std::map<Mac48Address, Etx>::iterator, bool> result = m_neighborEtx.insert (std::make_pair (addr, etx));
-      return result.second;
-    }
-  else
-    {
-      // Address found, update existing entry
-      i->second.m_lppReverse = lppReverse;
-      (i->second.m_lppMyCnt10bMap) |= ((uint16_t)0x0001 << lppTimeStamp);
-      return true;
+      i = InsertNeighbor (key);
+      m_neighbors[i].m_wheelTag = m_nextWheelTag++;
+      if (!m_timeout.IsZero ())
+        {
+          m_wheel.Schedule (key, m_neighbors[i].m_wheelTag, Simulator::Now () + m_timeout);
+        }
     }
+  // Update the entry
+  m_lppReverse[i] = lppReverse;
+  m_lppMyCntMap[i] |= lppBit;
+  m_neighbors[i].m_lastLpp = Simulator::Now ();
+  UpdateEtx (i);
+  return true;
 }
 
 uint32_t
-NeighborEtx::CalculateBinaryShiftedEtx (Etx etxStruct)
+NeighborEtx::CalculateBinaryShiftedEtx (uint32_t neighbor) const
 {
   //uint32_t etx = UINT32_MAX;  //This is causing inexplicable and negative behavior in routing table
-  uint32_t etx = ETX_MAX;
-  if ((Lpp10bMapToCnt (etxStruct.m_lppMyCnt10bMap)!=0) && (etxStruct.m_lppReverse!=0))
+  //Multiplier to have resolution of 3 decimal digits shifted to integer position,
+  //a zero product gives ETX_MAX
+  return GetEtxReciprocalTable ().Get ((uint32_t)LppMapToCnt (m_lppMyCntMap[neighbor]) * m_lppReverse[neighbor]);
+}
+
+void
+NeighborEtx::UpdateEtx (uint32_t neighbor)
+{
+  uint32_t previous = m_etx[neighbor];
+  m_etx[neighbor] = CalculateBinaryShiftedEtx (neighbor);
+  ReportEtxChange (MeshTimerWheel::GetAddress (m_neighbors[neighbor].m_key), previous, m_etx[neighbor]);
+}
+
+void
+NeighborEtx::ReportEtxChange (Mac48Address addr, uint32_t previous, uint32_t value)
+{
+  if (value == previous)
     {
-      //Multiplier to have resolution of 3 decimal digits shifted to integer position
-      etx = (uint32_t) (round (100000.0 / (Lpp10bMapToCnt (etxStruct.m_lppMyCnt10bMap) * etxStruct.m_lppReverse)));
+      return;
+    }
+  m_version++;
+  if (!m_etxChanged.IsNull ())
+    {
+      m_etxChanged (addr, previous, value);
     }
-  //NS_LOG_UNCOND ("ETX binary: " << etx);
-  return etx;
 }
 
 uint32_t
-NeighborEtx::GetEtxForNeighbor (Mac48Address addr)
+NeighborEtx::GetEtxForNeighbor (Mac48Address addr) const
 {
   uint32_t etx;
-  std::map<Mac48Address, Etx>::iterator i = m_neighborEtx.find (addr);
-  if (i == m_neighborEtx.end ())
+  uint32_t i = FindNeighbor (MeshTimerWheel::GetKey (addr));
+  if (i == m_neighbors.size ())
     {
       // No address, ETX -> oo (= UINT32_MAX)
       //etx = UINT32_MAX; //This is causing inexplicable and negative behavior in routing table
@@ -167,22 +448,30 @@ NeighborEtx::GetEtxForNeighbor (Mac48Address addr)
     }
   else
     {
-      // Address found, calculate and return current ETX value
-      return CalculateBinaryShiftedEtx (i->second);
+      // Address found, return current ETX value
+      return m_etx[i];
     }
 }
 
 void
 NeighborEtx::Print (std::ostream & os)
 {
-  uint32_t linkMetric;
-  Etx etx;
-  os << "<EtxMetric currentLppTimeSlot=\"" << (uint32_t) m_lppTimeStamp <<"\">" << std::endl;
-  for (std::map<Mac48Address, Etx>::const_iterator i = m_neighborEtx.begin (); i != m_neighborEtx.end (); ++i)
+  m_wheel.Advance ();
+  os << "<EtxMetric currentLppTimeSlot=\"" << (uint32_t) m_lppTimeStamp << "\" evictedExpired=\"" << m_evictedExpired
+     << "\" evictedOverflow=\"" << m_evictedOverflow << "\" evictedIdle=\"" << m_evictedIdle
+     << "\" version=\"" << m_version << "\">" << std::endl;
+  // Neighbors sorted by address, the order in which they used to be stored
+  std::vector<std::pair<uint64_t, uint32_t> > keys;
+  keys.reserve (m_neighbors.size ());
+  for (uint32_t i = 0; i < m_neighbors.size (); i++)
+    {
+      keys.push_back (std::make_pair (m_neighbors[i].m_key, i));
+    }
+  std::sort (keys.begin (), keys.end ());
+  for (std::vector<std::pair<uint64_t, uint32_t> >::const_iterator k = keys.begin (); k != keys.end (); ++k)
     {
-      etx = i->second;
-      linkMetric = CalculateBinaryShiftedEtx (etx);
-      os << "<PeerLink peerAddress=\"" << i->first << "\" metric=\"" << linkMetric << "\" mapCountForward=\"" << (uint32_t) etx.m_lppMyCnt10bMap << "\" lppCountReverse=\"" << (uint32_t) etx.m_lppReverse << "\"/>" << std::endl;
+      uint32_t i = k->second;
+      os << "<PeerLink peerAddress=\"" << MeshTimerWheel::GetAddress (m_neighbors[i].m_key) << "\" metric=\"" << m_etx[i] << "\" mapCountForward=\"" << m_lppMyCntMap[i] << "\" lppCountReverse=\"" << (uint32_t) m_lppReverse[i] << "\"/>" << std::endl;
     }
   os << "</EtxMetric>" << std::endl;
 }
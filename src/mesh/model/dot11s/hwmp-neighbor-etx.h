@@ -30,8 +30,11 @@
 #ifndef HWMPNEIGHBORETX_H
 #define HWMPNEIGHBORETX_H
 
-#include <map>
+#include <vector>
 #include "ns3/mac48-address.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/mesh-timer-wheel.h"
 #include "ie-lpp.h"
 
 namespace ns3
@@ -43,12 +46,25 @@ class NeighborEtx
 {
 public:
   NeighborEtx ();
-  struct Etx
-  {
-    uint16_t m_lppMyCnt10bMap;
-    uint8_t m_lppReverse;
-    Etx () : m_lppMyCnt10bMap (0), m_lppReverse (0) {}
-  };
+  // Largest number of LPP time slots, one bit of the forward map each
+  static const uint32_t MAX_WINDOW = 64;
+
+  // Number of LPP time slots, from 3 to MAX_WINDOW, the same in all the nodes.
+  // Resets the current time slot, so it is set before the first LPP.
+  void SetWindow (uint32_t window);
+  uint32_t GetWindow () const {return m_window; }
+
+  // Called with the neighbor, its previous and its new ETX whenever the ETX of a neighbor changes,
+  // a removed neighbor changes to the ETX of unknown neighbors
+  void SetEtxChangeCallback (Callback<void, Mac48Address, uint32_t, uint32_t> cb);
+
+  // Incremented whenever the ETX of any neighbor changes
+  uint32_t GetVersion () const {return m_version; }
+
+  // Neighbors no LPP was received from for timeout are removed (0 keeps them),
+  // and at most maxSize neighbors are kept (0 means no limit). Independently of
+  // both, a neighbor whose LPP map stayed empty for a whole window is removed.
+  void SetLimits (Time timeout, uint32_t maxSize);
 
   // Returns current time slot (it is needed for sending LPP packet, used as LPP ID)
   uint8_t GetLppTimeStamp () {return m_lppTimeStamp; }
@@ -59,8 +75,11 @@ public:
   // calculation of ETX metrix (previous 10 time slots are used for ETX calculations)
   void GotoNextTimeStampAndClearOldest ();
 
-  // Fills all ETX data from the neighbors map in the IE LPP
-  void FillLppCntData (IeLpp &ielpp);
+  // Fills all ETX data from the neighbors table in the IE LPP, sorted by address as IeLpp
+  // expects, adding elements when one is full (at most IeLpp::MAX_FRAGMENTS). The elements
+  // and the sort order are reused, so after the first periods no memory is allocated. Only
+  // the neighbor lists and the fragment fields are set.
+  void FillLppCntData (std::vector<IeLpp> &ielpp);
 
   // When receive LPP from neighbor node updates my lpp count for that neighbor, and
   // also reads all data from IE LPP and if it finds its MAC address then also
@@ -70,21 +89,83 @@ public:
   // Look for neighbor and return its ETX, return etx ->oo (max of uint32_t) if there
   // is no neighbor in the map (this is unlikely since it will receive at least
   // one LPP packet from this neighbor and therefore neighbor will be in the map).
-  uint32_t GetEtxForNeighbor (Mac48Address addr);
+  // The ETX is computed when LPPs arrive or time slots advance, not here.
+  uint32_t GetEtxForNeighbor (Mac48Address addr) const;
 
   // Print the etx metric for all links to neighbor nodes
   // param os The output stream
   void Print (std::ostream & os);
 
 private:
-  std::map<Mac48Address, Etx> m_neighborEtx;
-  uint8_t m_lppTimeStamp; // has to be incremented every lpp time period; holds last 10 events (slots of 1 second by default)
+  // Neighbor data not needed every LPP period
+  struct Neighbor
+  {
+    uint64_t m_key;       // MAC address of the neighbor, see MeshTimerWheel::GetKey
+    Time m_lastLpp;       // when the last LPP of the neighbor was received
+    uint32_t m_wheelTag;  // tag of the neighbor in the expiry wheel
+    uint8_t m_idle;       // consecutive time slots the LPP map was empty
+  };
+  // Slot of the index from MAC address to neighbor
+  struct IndexSlot
+  {
+    uint64_t m_key;       // EMPTY_KEY if unused
+    uint32_t m_neighbor;  // position of the neighbor in the arrays below
+  };
+  // Key of unused index slots, no MAC address maps to it
+  static const uint64_t EMPTY_KEY = ~(uint64_t)0;
+
+  // Neighbors are stored densely in parallel arrays, in no particular order,
+  // so that the per period work runs over contiguous memory. Removing a
+  // neighbor moves the last one to its position.
+  std::vector<uint64_t> m_lppMyCntMap;  // bit i set if the LPP of time slot i of the neighbor was received
+  std::vector<uint8_t> m_lppReverse;    // LPPs of this node the neighbor received
+  std::vector<uint32_t> m_etx;          // ETX computed from the map and the reverse count when either changed
+  std::vector<Neighbor> m_neighbors;
+  // Open addressing hash table with linear probing, the size is a power of
+  // two and at most half of the slots are used
+  std::vector<IndexSlot> m_index;
+  // Key and position of the neighbors with a nonzero LPP count, sorted by FillLppCntData
+  std::vector<std::pair<uint64_t, uint32_t> > m_sendOrder;
+
+  MeshTimerWheel m_wheel;       // evicts neighbors not heard for m_timeout
+  uint32_t m_nextWheelTag;
+  Time m_timeout;
+  uint32_t m_maxSize;
+  uint32_t m_evictedExpired;    // neighbors evicted because they were silent for m_timeout
+  uint32_t m_evictedOverflow;   // neighbors evicted because the table was full
+  uint32_t m_evictedIdle;       // neighbors evicted because their LPP map was empty for a window
+
+  // Returns the position of the neighbor, m_neighbors.size () if it is unknown
+  uint32_t FindNeighbor (uint64_t key) const;
+  // Adds a neighbor with an empty LPP map and returns its position
+  uint32_t InsertNeighbor (uint64_t key);
+  // Removes a neighbor, reporting its ETX change
+  void EraseNeighbor (uint32_t neighbor);
+  // Index slot where the probe for key starts
+  uint32_t GetHome (uint64_t key) const;
+  // Index slot holding key, m_index.size () if there is none
+  uint32_t FindIndexSlot (uint64_t key) const;
+
+  // Expiry callback of m_wheel, returns when the neighbor becomes stale or now if it was evicted
+  Time Expire (uint64_t key, uint32_t tag);
+  uint8_t m_lppTimeStamp; // has to be incremented every lpp time period; holds last m_window - 2 events (slots of 1 second by default)
+  uint32_t m_window;      // number of time slots
+  uint64_t m_windowMask;  // the bits of the m_window time slots
+  uint64_t m_countMask;   // the time slots counted, all but the current and the oldest ones
+
+  uint32_t m_version;     // incremented on every ETX change
+  Callback<void, Mac48Address, uint32_t, uint32_t> m_etxChanged;
 
-  uint32_t CalculateBinaryShiftedEtx (struct Etx etxStruct);
-  uint8_t Lpp10bMapToCnt (uint16_t lpp10bMap);
+  uint32_t CalculateBinaryShiftedEtx (uint32_t neighbor) const;
+  // Recompute the cached ETX of a neighbor and report a change
+  void UpdateEtx (uint32_t neighbor);
+  // Count a change of the ETX of a neighbor and call the change callback
+  void ReportEtxChange (Mac48Address addr, uint32_t previous, uint32_t value);
+  // Number of LPPs received in the counted time slots
+  uint8_t LppMapToCnt (uint64_t lppMap) const {return (uint8_t)__builtin_popcountll (lppMap & m_countMask); }
 
   void GotoNextLppTimeStamp ();
-  static uint8_t CalculateNextLppTimeStamp (uint8_t currTimeStamp);
+  uint8_t CalculateNextLppTimeStamp (uint8_t currTimeStamp) const;
 };
 
 } // namespace dot11s
@@ -37,6 +37,7 @@
 #include "ie-node-report.h"
 #include "ns3/mesh-point-device.h"
 #include "ns3/mobility-module.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -118,11 +119,25 @@ HwmpProtocolMac::ReceiveAction (Ptr<Packet> packet, const WifiMacHeader & header
   // this is the last header to remove.
   packet->RemoveHeader (elements, packet->GetSize ());
   std::vector<HwmpProtocol::FailedDestination> failedDestinations;
+  std::vector<Ptr<IeLpp> > lppFragments;
   for (MeshInformationElementVector::Iterator i = elements.Begin (); i != elements.End (); i++)
     {
       if ((*i)->ElementId () == IE_RANN)
         {
-          NS_LOG_WARN ("RANN is not supported!");
+          Ptr<IeRann> rann = DynamicCast<IeRann> (*i);
+          NS_ASSERT (rann != 0);
+          m_stats.rxRann++;
+          if (rann->GetOriginatorAddress () == m_protocol->GetAddress ())
+            {
+              continue;
+            }
+          if (rann->GetTtl () == 0)
+            {
+              continue;
+            }
+          rann->DecrementTtl ();
+          m_protocol->ReceiveRann (*rann, header.GetAddr2 (), m_ifIndex,
+                                   m_parent->GetLinkMetric (header.GetAddr2 ()));
         }
       if ((*i)->ElementId () == IE_PREQ)
         {
@@ -159,25 +174,25 @@ HwmpProtocolMac::ReceiveAction (Ptr<Packet> packet, const WifiMacHeader & header
           Ptr<IePerr> perr = DynamicCast<IePerr> (*i);
           NS_ASSERT (perr != 0);
           m_stats.rxPerr++;
-          std::vector<HwmpProtocol::FailedDestination> destinations = perr->GetAddressUnitVector ();
-          for (std::vector<HwmpProtocol::FailedDestination>::const_iterator i = destinations.begin (); i
-               != destinations.end (); i++)
-            {
-              failedDestinations.push_back (*i);
-            }
+          const std::vector<HwmpProtocol::FailedDestination> & destinations = perr->GetAddressUnitVector ();
+          failedDestinations.insert (failedDestinations.end (), destinations.begin (), destinations.end ());
         }
       if ((*i)->ElementId() == IE_LPP)
         {
           Ptr<IeLpp> lpp = DynamicCast<IeLpp>(*i);
           NS_ASSERT(lpp != 0);
-          m_stats.rxLpp++;
-          m_protocol->ReceiveLpp(*lpp, header.GetAddr2(), m_ifIndex, header.GetAddr3());
+          lppFragments.push_back (lpp);
         }
     }
   if (failedDestinations.size () > 0)
     {
       m_protocol->ReceivePerr (failedDestinations, header.GetAddr2 (), m_ifIndex, header.GetAddr3 ());
     }
+  if (lppFragments.size () > 0)
+    {
+      m_stats.rxLpp++;
+      m_protocol->ReceiveLpp (lppFragments, header.GetAddr2 (), m_ifIndex, header.GetAddr3 ());
+    }
   NS_ASSERT (packet->GetSize () == 0);
   return false;
 }
@@ -273,23 +288,38 @@ HwmpProtocolMac::GetWifiActionHeader ()
   return actionHdr;
 }
 void
-HwmpProtocolMac::SendPreq (IePreq preq)
+HwmpProtocolMac::SendPreq (const IePreq & preq)
 {
   NS_LOG_FUNCTION (this);
-  std::vector<IePreq> preq_vector;
-  preq_vector.push_back (preq);
-  SendPreq (preq_vector);
+  MeshInformationElementVector elements;
+  //The element is only serialized here, the Ptr never owns it
+  elements.AddInformationElement (Ptr<IePreq> (const_cast<IePreq *> (&preq)));
+  SendPreqElements (elements, m_protocol->GetPreqReceivers (m_ifIndex));
 }
 void
-HwmpProtocolMac::SendPreq (std::vector<IePreq> preq)
+HwmpProtocolMac::SendPreq (const std::vector<IePreq> & preq)
 {
   NS_LOG_FUNCTION (this);
-  Ptr<Packet> packet = Create<Packet> ();
   MeshInformationElementVector elements;
-  for (std::vector<IePreq>::iterator i = preq.begin (); i != preq.end (); i++)
+  for (std::vector<IePreq>::const_iterator i = preq.begin (); i != preq.end (); i++)
     {
-      elements.AddInformationElement (Ptr<IePreq> (&(*i)));
+      elements.AddInformationElement (Ptr<IePreq> (const_cast<IePreq *> (&(*i))));
     }
+  SendPreqElements (elements, m_protocol->GetPreqReceivers (m_ifIndex));
+}
+void
+HwmpProtocolMac::SendPreq (const IePreq & preq, Mac48Address receiver)
+{
+  NS_LOG_FUNCTION (this << receiver);
+  MeshInformationElementVector elements;
+  elements.AddInformationElement (Ptr<IePreq> (const_cast<IePreq *> (&preq)));
+  SendPreqElements (elements, std::vector<Mac48Address> (1, receiver));
+}
+void
+HwmpProtocolMac::SendPreqElements (const MeshInformationElementVector & elements,
+                                   const std::vector<Mac48Address> & receivers)
+{
+  Ptr<Packet> packet = Create<Packet> ();
   packet->AddHeader (elements);
   packet->AddHeader (GetWifiActionHeader ());
   //create 802.11 header:
@@ -300,7 +330,6 @@ HwmpProtocolMac::SendPreq (std::vector<IePreq> preq)
   hdr.SetAddr2 (m_parent->GetAddress ());
   hdr.SetAddr3 (m_protocol->GetAddress ());
   //Send Management frame
-  std::vector<Mac48Address> receivers = m_protocol->GetPreqReceivers (m_ifIndex);
   for (std::vector<Mac48Address>::const_iterator i = receivers.begin (); i != receivers.end (); i++)
     {
       hdr.SetAddr1 (*i);
@@ -311,12 +340,12 @@ HwmpProtocolMac::SendPreq (std::vector<IePreq> preq)
     }
 }
 void
-HwmpProtocolMac::RequestDestination (Mac48Address dst, uint32_t originator_seqno, uint32_t dst_seqno)
+HwmpProtocolMac::RequestDestination (Mac48Address dst, uint32_t originator_seqno, uint32_t dst_seqno, uint8_t ttl)
 {
-  NS_LOG_FUNCTION (this << dst << originator_seqno << dst_seqno);
+  NS_LOG_FUNCTION (this << dst << originator_seqno << dst_seqno << (uint16_t)ttl);
   for (std::vector<IePreq>::iterator i = m_myPreq.begin (); i != m_myPreq.end (); i++)
     {
-      if (i->IsFull ())
+      if (i->IsFull () || i->GetTtl () < ttl)
         {
           continue;
         }
@@ -325,7 +354,7 @@ HwmpProtocolMac::RequestDestination (Mac48Address dst, uint32_t originator_seqno
     }
   IePreq preq;
   preq.SetHopcount (0);
-  preq.SetTTL (m_protocol->GetMaxTtl ());
+  preq.SetTTL (ttl);
   preq.SetPreqID (m_protocol->GetNextPreqId ());
   preq.SetOriginatorAddress (m_protocol->GetAddress ());
   preq.SetOriginatorSeqNumber (originator_seqno);
@@ -353,13 +382,36 @@ HwmpProtocolMac::SendMyPreq ()
   m_myPreq.clear ();
 }
 void
-HwmpProtocolMac::SendPrep (IePrep prep, Mac48Address receiver)
+HwmpProtocolMac::SendRann (const IeRann & rann)
+{
+  NS_LOG_FUNCTION (this);
+  MeshInformationElementVector elements;
+  //The element is only serialized here, the Ptr never owns it
+  elements.AddInformationElement (Ptr<IeRann> (const_cast<IeRann *> (&rann)));
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (elements);
+  packet->AddHeader (GetWifiActionHeader ());
+  //create 802.11 header:
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_MGT_ACTION);
+  hdr.SetDsNotFrom ();
+  hdr.SetDsNotTo ();
+  hdr.SetAddr1 (Mac48Address::GetBroadcast ());
+  hdr.SetAddr2 (m_parent->GetAddress ());
+  hdr.SetAddr3 (m_protocol->GetAddress ());
+  m_stats.txRann++;
+  m_stats.txMgt++;
+  m_stats.txMgtBytes += packet->GetSize ();
+  m_parent->SendManagementFrame (packet, hdr);
+}
+void
+HwmpProtocolMac::SendPrep (const IePrep & prep, Mac48Address receiver)
 {
   NS_LOG_FUNCTION (this << receiver);
   //Create packet
   Ptr<Packet> packet = Create<Packet> ();
   MeshInformationElementVector elements;
-  elements.AddInformationElement (Ptr<IePrep> (&prep));
+  elements.AddInformationElement (Ptr<IePrep> (const_cast<IePrep *> (&prep)));
   packet->AddHeader (elements);
   packet->AddHeader (GetWifiActionHeader ());
   //create 802.11 header:
@@ -377,34 +429,43 @@ HwmpProtocolMac::SendPrep (IePrep prep, Mac48Address receiver)
   m_parent->SendManagementFrame (packet, hdr);
 }
 void
-HwmpProtocolMac::SendLpp(IeLpp lpp)
+HwmpProtocolMac::SendLpp(std::vector<IeLpp> & lpp)
 {
   NS_LOG_FUNCTION(this);
-  //Create packet
-  Ptr<Packet> packet = Create<Packet>();
-  MeshInformationElementVector elements;
-  //Add Originator Address
-  lpp.SetOriginAddress(m_parent->GetAddress());
-  elements.AddInformationElement(Ptr<IeLpp>(&lpp));
-  packet->AddHeader(elements);
-  packet->AddHeader(GetWifiActionHeader());
-  //create 802.11 header:
-  WifiMacHeader hdr;
-  hdr.SetType(WIFI_MAC_MGT_ACTION);
-  hdr.SetDsNotFrom();
-  hdr.SetDsNotTo();
-  hdr.SetAddr1(Mac48Address::GetBroadcast ());
-  hdr.SetAddr2(m_parent->GetAddress());
-  hdr.SetAddr3(m_protocol->GetAddress());
-  //Send Management frame
-  m_stats.txLpp++;
-  m_stats.txMgt++;
-  m_stats.txMgtBytes += packet->GetSize();
-  m_parent->SendManagementFrame(packet, hdr);
+  //A list split in more elements than one MMPDU holds is sent in several frames
+  for (uint32_t first = 0; first < lpp.size (); first += IeLpp::MAX_FRAGMENTS_PER_FRAME)
+    {
+      uint32_t last = std::min<uint32_t> (first + IeLpp::MAX_FRAGMENTS_PER_FRAME, lpp.size ());
+      //Create packet
+      Ptr<Packet> packet = Create<Packet>();
+      MeshInformationElementVector elements;
+      //The elements are only serialized here, the Ptrs never own them
+      for (uint32_t i = first; i < last; i++)
+        {
+          //Add Originator Address
+          lpp[i].SetOriginAddress(m_parent->GetAddress());
+          elements.AddInformationElement (Ptr<IeLpp> (&lpp[i]));
+        }
+      packet->AddHeader(elements);
+      packet->AddHeader(GetWifiActionHeader());
+      //create 802.11 header:
+      WifiMacHeader hdr;
+      hdr.SetType(WIFI_MAC_MGT_ACTION);
+      hdr.SetDsNotFrom();
+      hdr.SetDsNotTo();
+      hdr.SetAddr1(Mac48Address::GetBroadcast ());
+      hdr.SetAddr2(m_parent->GetAddress());
+      hdr.SetAddr3(m_protocol->GetAddress());
+      //Send Management frame
+      m_stats.txLpp++;
+      m_stats.txMgt++;
+      m_stats.txMgtBytes += packet->GetSize();
+      m_parent->SendManagementFrame(packet, hdr);
+    }
 }
 void
-HwmpProtocolMac::ForwardPerr (std::vector<HwmpProtocol::FailedDestination> failedDestinations, std::vector<
-                                Mac48Address> receivers)
+HwmpProtocolMac::ForwardPerr (const std::vector<HwmpProtocol::FailedDestination> & failedDestinations,
+                              const std::vector<Mac48Address> & receivers)
 {
   NS_LOG_FUNCTION (this);
   Ptr<Packet> packet = Create<Packet> ();
@@ -436,19 +497,16 @@ HwmpProtocolMac::ForwardPerr (std::vector<HwmpProtocol::FailedDestination> faile
   hdr.SetDsNotTo ();
   hdr.SetAddr2 (m_parent->GetAddress ());
   hdr.SetAddr3 (m_protocol->GetAddress ());
-  if (receivers.size () >= m_protocol->GetUnicastPerrThreshold ())
-    {
-      receivers.clear ();
-      receivers.push_back (Mac48Address::GetBroadcast ());
-    }
+  bool broadcast = (receivers.size () >= m_protocol->GetUnicastPerrThreshold ());
+  size_t nReceivers = broadcast ? 1 : receivers.size ();
   //Send Management frame
-  for (std::vector<Mac48Address>::const_iterator i = receivers.begin (); i != receivers.end (); i++)
+  for (size_t i = 0; i < nReceivers; i++)
     {
       //
       // 64-bit Intel valgrind complains about hdr.SetAddr1 (*i).  It likes this
       // just fine.
       //
-      Mac48Address address = *i;
+      Mac48Address address = broadcast ? Mac48Address::GetBroadcast () : receivers[i];
       hdr.SetAddr1 (address);
       m_stats.txPerr++;
       m_stats.txMgt++;
@@ -457,52 +515,27 @@ HwmpProtocolMac::ForwardPerr (std::vector<HwmpProtocol::FailedDestination> faile
     }
 }
 void
-HwmpProtocolMac::InitiatePerr (std::vector<HwmpProtocol::FailedDestination> failedDestinations, std::vector<
-                                 Mac48Address> receivers)
+HwmpProtocolMac::InitiatePerr (const std::vector<HwmpProtocol::FailedDestination> & failedDestinations,
+                               const std::vector<Mac48Address> & receivers)
 {
   NS_LOG_FUNCTION (this);
   //All duplicates in PERR are checked here, and there is no reason to
   //check it at any other place
-  {
-    std::vector<Mac48Address>::const_iterator end = receivers.end ();
-    for (std::vector<Mac48Address>::const_iterator i = receivers.begin (); i != end; i++)
-      {
-        bool should_add = true;
-        for (std::vector<Mac48Address>::const_iterator j = m_myPerr.receivers.begin (); j
-             != m_myPerr.receivers.end (); j++)
-          {
-            if ((*i) == (*j))
-              {
-                should_add = false;
-              }
-          }
-        if (should_add)
-          {
-            m_myPerr.receivers.push_back (*i);
-            NS_LOG_DEBUG ("Initiate PERR:  Adding receiver: " << (*i));
-          }
-      }
-  }
-  {
-    std::vector<HwmpProtocol::FailedDestination>::const_iterator end = failedDestinations.end ();
-    for (std::vector<HwmpProtocol::FailedDestination>::const_iterator i = failedDestinations.begin (); i != end; i++)
-      {
-        bool should_add = true;
-        for (std::vector<HwmpProtocol::FailedDestination>::const_iterator j = m_myPerr.destinations.begin (); j
-             != m_myPerr.destinations.end (); j++)
-          {
-            if (((*i).destination == (*j).destination) && ((*j).seqnum > (*i).seqnum))
-              {
-                should_add = false;
-              }
-          }
-        if (should_add)
-          {
-            m_myPerr.destinations.push_back (*i);
-            NS_LOG_DEBUG ("Initiate PERR:  Adding failed destination: " << (*i).destination);
-          }
-      }
-  }
+  for (std::vector<Mac48Address>::const_iterator i = receivers.begin (); i != receivers.end (); i++)
+    {
+      if (m_myPerr.AddReceiver (*i))
+        {
+          NS_LOG_DEBUG ("Initiate PERR:  Adding receiver: " << (*i));
+        }
+    }
+  for (std::vector<HwmpProtocol::FailedDestination>::const_iterator i = failedDestinations.begin ();
+       i != failedDestinations.end (); i++)
+    {
+      if (m_myPerr.AddDestination (*i))
+        {
+          NS_LOG_DEBUG ("Initiate PERR:  Adding failed destination: " << (*i).destination);
+        }
+    }
   SendMyPerr ();
 }
 void
@@ -515,8 +548,43 @@ HwmpProtocolMac::SendMyPerr ()
     }
   m_perrTimer = Simulator::Schedule (m_protocol->GetPerrMinInterval (), &HwmpProtocolMac::SendMyPerr, this);
   ForwardPerr (m_myPerr.destinations, m_myPerr.receivers);
-  m_myPerr.destinations.clear ();
-  m_myPerr.receivers.clear ();
+  m_myPerr.Clear ();
+}
+bool
+HwmpProtocolMac::MyPerr::AddReceiver (Mac48Address receiver)
+{
+  if (!receiverKeys.insert (MeshTimerWheel::GetKey (receiver)).second)
+    {
+      return false;
+    }
+  receivers.push_back (receiver);
+  return true;
+}
+bool
+HwmpProtocolMac::MyPerr::AddDestination (const HwmpProtocol::FailedDestination &destination)
+{
+  std::pair<std::unordered_map<uint64_t, uint32_t>::iterator, bool> inserted =
+    destinationIndex.insert (std::make_pair (MeshTimerWheel::GetKey (destination.destination),
+                                             (uint32_t) destinations.size ()));
+  if (!inserted.second)
+    {
+      HwmpProtocol::FailedDestination & existing = destinations[inserted.first->second];
+      if ((int32_t)(destination.seqnum - existing.seqnum) > 0)
+        {
+          existing.seqnum = destination.seqnum;
+        }
+      return false;
+    }
+  destinations.push_back (destination);
+  return true;
+}
+void
+HwmpProtocolMac::MyPerr::Clear ()
+{
+  destinations.clear ();
+  receivers.clear ();
+  destinationIndex.clear ();
+  receiverKeys.clear ();
 }
 uint32_t
 HwmpProtocolMac::GetLinkMetric (Mac48Address peerAddress) const
@@ -544,7 +612,8 @@ HwmpProtocolMac::SetUseGeoInfo (bool value)
   m_useGeoInfo = value;
 }
 HwmpProtocolMac::Statistics::Statistics () :
-  txPreq (0), rxPreq (0), txPrep (0), rxPrep (0), txPerr (0), rxPerr (0), txLpp (0), rxLpp (0), txMgt (0),
+  txPreq (0), rxPreq (0), txPrep (0), rxPrep (0), txPerr (0), rxPerr (0), txLpp (0), rxLpp (0), txRann (0),
+  rxRann (0), txMgt (0),
   txMgtBytes (0), rxMgt (0), rxMgtBytes (0), txData (0), txDataBytes (0), rxData (0), rxDataBytes (0)
 {
 }
@@ -560,6 +629,8 @@ HwmpProtocolMac::Statistics::Print (std::ostream & os) const
   "rxPrep=\"" << rxPrep << "\"" << std::endl <<
   "rxPerr=\"" << rxPerr << "\"" << std::endl <<
   "rxLpp=\"" << rxLpp << "\"" << std::endl <<
+  "txRann=\"" << txRann << "\"" << std::endl <<
+  "rxRann=\"" << rxRann << "\"" << std::endl <<
   "txMgt=\"" << txMgt << "\"" << std::endl <<
   "txMgtBytes=\"" << txMgtBytes << "\"" << std::endl <<
   "rxMgt=\"" << rxMgt << "\"" << std::endl <<
@@ -27,11 +27,16 @@
 #include "ns3/mesh-wifi-interface-mac-plugin.h"
 #include "ns3/hwmp-protocol.h"
 #include "ns3/vector.h"
+#include <unordered_map>
+#include <unordered_set>
+
+class HwmpMyPerrTest;
 
 namespace ns3 {
 
 class MeshWifiInterfaceMac;
 class WifiActionHeader;
+class MeshInformationElementVector;
 
 namespace dot11s {
 
@@ -40,6 +45,7 @@ class IePreq;
 class IePrep;
 class IePerr;
 class IeLpp;
+class IeRann;
 
 /**
  * \ingroup dot11s
@@ -90,6 +96,8 @@ public:
 private:
   /// allow HwmpProtocol class friend access
   friend class HwmpProtocol;
+  /// allow HwmpMyPerrTest class friend access
+  friend class ::HwmpMyPerrTest;
   /**
    * \returns a path selection action header
    */
@@ -100,49 +108,69 @@ private:
    * Send PREQ function
    * \param preq the PREQ
    */
-  void SendPreq (IePreq preq);
+  void SendPreq (const IePreq & preq);
   /**
    * Send PREQ function
    * \param preq vector of PREQ information elements
    */
-  void SendPreq (std::vector<IePreq> preq);
+  void SendPreq (const std::vector<IePreq> & preq);
+  /**
+   * Send an individually addressed PREQ
+   * \param preq the PREQ
+   * \param receiver the MAC address of the receiver
+   */
+  void SendPreq (const IePreq & preq, Mac48Address receiver);
+  /**
+   * Broadcast a root announcement
+   * \param rann the RANN
+   */
+  void SendRann (const IeRann & rann);
   /**
    * Send PREP function
    * \param prep the PREP information element
    * \param receiver the MAC address of the receiver
    */
-  void SendPrep (IePrep prep, Mac48Address receiver);
+  void SendPrep (const IePrep & prep, Mac48Address receiver);
   /**
    * Send LPP function
-   * \param lpp the LPP information element
+   * \param lpp the LPP information elements, one per part of the neighbor list, sent
+   * IeLpp::MAX_FRAGMENTS_PER_FRAME per frame; their originator address is set to the
+   * one of this interface
    */
-  void SendLpp(IeLpp lpp);
+  void SendLpp(std::vector<IeLpp> & lpp);
   /**
    * Forward a path error
    * \param destinations vector of failed destinations
    * \param receivers vector of receivers
    */
-  void ForwardPerr (std::vector<HwmpProtocol::FailedDestination> destinations, std::vector<Mac48Address> receivers);
+  void ForwardPerr (const std::vector<HwmpProtocol::FailedDestination> & destinations, const std::vector<Mac48Address> & receivers);
   /**
    * initiate my own path error
    * \param destinations vector of failed destinations
    * \param receivers vector of receivers
    */
-  void InitiatePerr (std::vector<HwmpProtocol::FailedDestination> destinations, std::vector<Mac48Address> receivers);
+  void InitiatePerr (const std::vector<HwmpProtocol::FailedDestination> & destinations, const std::vector<Mac48Address> & receivers);
   /**
    * Request a destination. If cannot send PREQ immediately, add a
    * destination to existing PREQ generated by me and stored in PREQ queue
    * \param dest is the destination to be resolved
    * \param originator_seqno is a sequence number that shall be preq originator sequenece number
    * \param dst_seqno is a sequence number taken from routing table
+   * \param ttl is the TTL of the PREQ, queued PREQs with a smaller TTL don't take the destination
    */
-  void RequestDestination (Mac48Address dest, uint32_t originator_seqno, uint32_t dst_seqno);
+  void RequestDestination (Mac48Address dest, uint32_t originator_seqno, uint32_t dst_seqno, uint8_t ttl);
   //\}
 
   /// Sends one PREQ when PreqMinInterval after last PREQ expires (if any PREQ exists in rhe queue)
   void SendMyPreq ();
   /// Send PERR function
   void SendMyPerr ();
+  /**
+   * Send a frame with PREQ elements
+   * \param elements the PREQ information elements
+   * \param receivers the receivers of the frame
+   */
+  void SendPreqElements (const MeshInformationElementVector & elements, const std::vector<Mac48Address> & receivers);
   /**
    * \param peerAddress peer address
    * \return metric to HWMP protocol, needed only by metrics to add peer as routing entry
@@ -174,10 +202,27 @@ private:
   ///\name PERR timer and stored path error
   //\{
   EventId m_perrTimer;
-  /// MyPerr structure
+  /// MyPerr structure, duplicates are filtered through hash indexes
   struct MyPerr {
     std::vector<HwmpProtocol::FailedDestination> destinations; ///< destinations
     std::vector<Mac48Address> receivers; ///< receivers
+    std::unordered_map<uint64_t, uint32_t> destinationIndex; ///< destination key to position in destinations
+    std::unordered_set<uint64_t> receiverKeys; ///< keys of receivers
+    /**
+     * Add a receiver unless already present
+     * \param receiver the receiver
+     * \returns true if added
+     */
+    bool AddReceiver (Mac48Address receiver);
+    /**
+     * Add a failed destination, or raise the sequence number of the one
+     * already present for the same address
+     * \param destination the failed destination
+     * \returns true if added
+     */
+    bool AddDestination (const HwmpProtocol::FailedDestination &destination);
+    /// Remove all receivers and destinations
+    void Clear ();
   };
   MyPerr m_myPerr; ///< PERR
   ///\name Statistics:
@@ -193,6 +238,8 @@ private:
     uint16_t rxPerr; ///< receive PERR
     uint16_t txLpp; ///< transmit LPP
     uint16_t rxLpp; ///< receive LPP
+    uint16_t txRann; ///< transmit RANN
+    uint16_t rxRann; ///< receive RANN
     uint16_t txMgt; ///< transmit management
     uint32_t txMgtBytes; ///< transmit management bytes
     uint16_t rxMgt; ///< receive management
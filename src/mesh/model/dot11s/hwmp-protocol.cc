@@ -37,8 +37,11 @@
 #include "ie-dot11s-prep.h"
 #include "ns3/trace-source-accessor.h"
 #include "ie-dot11s-perr.h"
+#include "ie-dot11s-rann.h"
 #include "ie-lpp.h"
 #include "ns3/mobility-module.h"
+#include <unordered_set>
+#include <utility>
 
 namespace ns3 {
 
@@ -48,6 +51,30 @@ namespace dot11s {
 
 NS_OBJECT_ENSURE_REGISTERED (HwmpProtocol);
 
+std::string
+ToString (RouteChangeType type)
+{
+  switch (type)
+    {
+    case ROUTE_CHANGE_ADD_REACTIVE:
+      return "Add Reactive";
+    case ROUTE_CHANGE_ADD_PROACTIVE:
+      return "Add Proactive";
+    case ROUTE_CHANGE_DELETE_REACTIVE:
+      return "Delete Reactive";
+    case ROUTE_CHANGE_DELETE_PROACTIVE:
+      return "Delete Proactive";
+    default:
+      return "Unknown";
+    }
+}
+std::ostream &
+operator<< (std::ostream &os, RouteChangeType type)
+{
+  os << ToString (type);
+  return os;
+}
+
 TypeId
 HwmpProtocol::GetTypeId ()
 {
@@ -76,6 +103,29 @@ HwmpProtocol::GetTypeId ()
                       &HwmpProtocol::m_maxQueueSize),
                     MakeUintegerChecker<uint16_t> (1)
                     )
+    .AddAttribute ( "MaxQueueBytes",
+                    "Maximum number of bytes we can store when resolving route (0 means no limit)",
+                    UintegerValue (0),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_maxQueueBytes),
+                    MakeUintegerChecker<uint32_t> ()
+                    )
+    .AddAttribute ( "MaxQueueSizePerDestination",
+                    "Maximum number of packets we can store for a single destination "
+                    "when resolving route (0 means only MaxQueueSize applies)",
+                    UintegerValue (0),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_maxQueueSizePerDst),
+                    MakeUintegerChecker<uint16_t> ()
+                    )
+    .AddAttribute ( "MaxQueueTime",
+                    "Maximum time a packet can wait for a route before being dropped (0 means no limit). "
+                    "The oldest packet is dropped once it waited longer, by an event scheduled for it",
+                    TimeValue (Seconds (0)),
+                    MakeTimeAccessor (
+                      &HwmpProtocol::m_maxQueueTime),
+                    MakeTimeChecker ()
+                    )
     .AddAttribute ( "Dot11MeshHWMPmaxPREQretries",
                     "Maximum number of retries before we suppose the destination to be unreachable",
                     UintegerValue (3),
@@ -131,12 +181,20 @@ HwmpProtocol::GetTypeId ()
                     MakeTimeChecker ()
                     )
     .AddAttribute ( "Dot11MeshHWMPrannInterval",
-                    "Lifetime of proactive routing information",
+                    "Interval between two successive root announcements (RANN)",
                     TimeValue (MicroSeconds (1024*5000)),
                     MakeTimeAccessor (
                       &HwmpProtocol::m_dot11MeshHWMPrannInterval),
                     MakeTimeChecker ()
                     )
+    .AddAttribute ( "RootAnnouncement",
+                    "A root floods RANNs every Dot11MeshHWMPrannInterval instead of proactive PREQs, "
+                    "nodes send a PREQ to the root when they need a path or their metric to it changes",
+                    BooleanValue (false),
+                    MakeBooleanAccessor (
+                      &HwmpProtocol::m_rootAnnouncement),
+                    MakeBooleanChecker ()
+                    )
     .AddAttribute ( "MaxTtl",
                     "Initial value of Time To Live field",
                     UintegerValue (32),
@@ -208,6 +266,133 @@ HwmpProtocol::GetTypeId ()
                       &HwmpProtocol::m_useGeoInfo),
                     MakeBooleanChecker ()
                     )
+    .AddAttribute ( "DataSeqnoTimeout",
+                    "Time after which the broadcast data sequence number of a silent source is forgotten (0 means never)",
+                    TimeValue (Seconds (0)),
+                    MakeTimeAccessor (
+                      &HwmpProtocol::m_dataSeqnoTimeout),
+                    MakeTimeChecker ()
+                    )
+    .AddAttribute ( "DataSeqnoMaxSize",
+                    "Maximum number of sources in the broadcast data sequence number database (0 means no limit)",
+                    UintegerValue (0),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_dataSeqnoMaxSize),
+                    MakeUintegerChecker<uint32_t> ()
+                    )
+    .AddAttribute ( "HwmpSeqnoTimeout",
+                    "Time after which the HWMP sequence number and metric of a silent originator is forgotten (0 means never)",
+                    TimeValue (Seconds (0)),
+                    MakeTimeAccessor (
+                      &HwmpProtocol::m_hwmpSeqnoTimeout),
+                    MakeTimeChecker ()
+                    )
+    .AddAttribute ( "HwmpSeqnoMaxSize",
+                    "Maximum number of originators in the HWMP sequence number database (0 means no limit)",
+                    UintegerValue (0),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_hwmpSeqnoMaxSize),
+                    MakeUintegerChecker<uint32_t> ()
+                    )
+    .AddAttribute ( "NeighborEtxTimeout",
+                    "Time after which a neighbor no LPP was received from is removed from the ETX table (0 disables the timeout, neighbors none of whose LPPs are left in the ETX window are removed anyway)",
+                    TimeValue (Seconds (0)),
+                    MakeTimeAccessor (
+                      &HwmpProtocol::m_neighborEtxTimeout),
+                    MakeTimeChecker ()
+                    )
+    .AddAttribute ( "NeighborEtxMaxSize",
+                    "Maximum number of neighbors in the ETX table (0 means no limit)",
+                    UintegerValue (0),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_neighborEtxMaxSize),
+                    MakeUintegerChecker<uint32_t> ()
+                    )
+    .AddAttribute ( "EtxWindow",
+                    "Number of LPP periods of the ETX window, the current and the oldest ones are "
+                    "not counted. All the nodes must use the same window",
+                    UintegerValue (12),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_etxWindow),
+                    MakeUintegerChecker<uint32_t> (3, NeighborEtx::MAX_WINDOW)
+                    )
+    .AddAttribute ( "MultipathNextHops",
+                    "Number of loop free next hops kept per reactive route, the best one and "
+                    "alternatives learned from PREQ and PREP with the same sequence number. "
+                    "Forwarding moves to an alternative as soon as the best one fails (1 disables multipath)",
+                    UintegerValue (1),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_multipathNextHops),
+                    MakeUintegerChecker<uint32_t> (1, HwmpRtable::MAX_ALTERNATIVES + 1)
+                    )
+    .AddAttribute ( "MultipathFlowHashing",
+                    "Spread flows over the next hops of a route whose metric is within "
+                    "MultipathEqualCostTolerance of the best one, hashing source and destination",
+                    BooleanValue (false),
+                    MakeBooleanAccessor (
+                      &HwmpProtocol::m_multipathFlowHashing),
+                    MakeBooleanChecker ()
+                    )
+    .AddAttribute ( "MultipathEqualCostTolerance",
+                    "How much worse than the best one, relatively, the metric of a next hop "
+                    "may be to carry hashed flows",
+                    DoubleValue (0.1),
+                    MakeDoubleAccessor (
+                      &HwmpProtocol::m_multipathTolerance),
+                    MakeDoubleChecker<double> (0)
+                    )
+    .AddAttribute ( "LocalRepair",
+                    "An intermediate node that can't forward a packet queues it and looks for the "
+                    "destination with a TTL limited PREQ, the path error is sent only if that fails",
+                    BooleanValue (false),
+                    MakeBooleanAccessor (
+                      &HwmpProtocol::m_localRepair),
+                    MakeBooleanChecker ()
+                    )
+    .AddAttribute ( "LocalRepairTtlMargin",
+                    "Hops added to the hop count of the broken path to get the TTL of a local repair PREQ",
+                    UintegerValue (2),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_localRepairTtlMargin),
+                    MakeUintegerChecker<uint8_t> (1)
+                    )
+    .AddAttribute ( "LocalRepairTimeout",
+                    "Time a local repair waits for a path before sending the path error",
+                    TimeValue (MicroSeconds (1024*100)),
+                    MakeTimeAccessor (
+                      &HwmpProtocol::m_localRepairTimeout),
+                    MakeTimeChecker ()
+                    )
+    .AddAttribute ( "PreqSuppression",
+                    "Wait a random jitter before forwarding a PREQ and give up forwarding it when "
+                    "enough neighbors were heard forwarding it, or all the peers already have it",
+                    BooleanValue (false),
+                    MakeBooleanAccessor (
+                      &HwmpProtocol::m_preqSuppression),
+                    MakeBooleanChecker ()
+                    )
+    .AddAttribute ( "PreqSuppressionJitter",
+                    "Most time a PREQ waits before it is forwarded, when PreqSuppression is enabled",
+                    TimeValue (MilliSeconds (5)),
+                    MakeTimeAccessor (
+                      &HwmpProtocol::m_preqSuppressionJitter),
+                    MakeTimeChecker ()
+                    )
+    .AddAttribute ( "PreqSuppressionThreshold",
+                    "Number of copies of a PREQ with an equal or better metric than ours, heard "
+                    "while waiting to forward it, that cancel forwarding (0 disables the counter)",
+                    UintegerValue (3),
+                    MakeUintegerAccessor (
+                      &HwmpProtocol::m_preqSuppressionThreshold),
+                    MakeUintegerChecker<uint32_t> ()
+                    )
+    .AddAttribute ( "PreqSuppressionCoverage",
+                    "Cancel forwarding a PREQ when every peer was heard forwarding it or is its originator",
+                    BooleanValue (true),
+                    MakeBooleanAccessor (
+                      &HwmpProtocol::m_preqSuppressionCoverage),
+                    MakeBooleanChecker ()
+                    )
     .AddTraceSource ( "RouteDiscoveryTime",
                       "The time of route discovery procedure",
                       MakeTraceSourceAccessor (
@@ -215,10 +400,26 @@ HwmpProtocol::GetTypeId ()
                       "ns3::Time::TracedCallback"
                       )
     .AddTraceSource ("RouteChange",
-                     "Routing table changed",
+                     "Routing table changed, paths deleted by a path error are "
+                     "reported by RouteChangeBatch",
                      MakeTraceSourceAccessor (&HwmpProtocol::m_routeChangeTraceSource),
                      "ns3::HwmpProtocol::RouteChangeTracedCallback"
                      )
+    .AddTraceSource ("RouteChangeBatch",
+                     "Paths deleted while handling a path error, one event per kind of path",
+                     MakeTraceSourceAccessor (&HwmpProtocol::m_routeChangeBatchTraceSource),
+                     "ns3::HwmpProtocol::RouteChangeBatchTracedCallback"
+                     )
+    .AddTraceSource ("QueueDrop",
+                     "A packet waiting for a route was dropped",
+                     MakeTraceSourceAccessor (&HwmpProtocol::m_queueDropTrace),
+                     "ns3::HwmpProtocol::QueueDropTracedCallback"
+                     )
+    .AddTraceSource ("NeighborEtxChange",
+                     "The ETX of a neighbor changed",
+                     MakeTraceSourceAccessor (&HwmpProtocol::m_etxChangeTrace),
+                     "ns3::HwmpProtocol::EtxChangeTracedCallback"
+                     )
   ;
   return tid;
 }
@@ -230,7 +431,13 @@ HwmpProtocol::HwmpProtocol () :
   m_rtable (CreateObject<HwmpRtable> ()),
   m_randomStart (Seconds (0.1)),
   m_lppRandomStart (Seconds (0.1)),
+  m_rqueuePackets (0),
+  m_rqueueBytes (0),
+  m_rqueueSeqno (0),
   m_maxQueueSize (255),
+  m_maxQueueBytes (0),
+  m_maxQueueSizePerDst (0),
+  m_maxQueueTime (Seconds (0)),
   m_dot11MeshHWMPmaxPREQretries (3),
   m_dot11MeshHWMPnetDiameterTraversalTime (MicroSeconds (1024*100)),
   m_dot11MeshHWMPpreqMinInterval (MicroSeconds (1024*100)),
@@ -241,6 +448,7 @@ HwmpProtocol::HwmpProtocol () :
   m_dot11MeshHWMPpathToRootInterval (MicroSeconds (1024*2000)),
   m_dot11MeshHWMPrannInterval (MicroSeconds (1024*5000)),
   m_isRoot (false),
+  m_rootAnnouncement (false),
   m_maxTtl (32),
   m_unicastPerrThreshold (32),
   m_unicastPreqThreshold (1),
@@ -250,10 +458,29 @@ HwmpProtocol::HwmpProtocol () :
   m_etxMetric (false),
   m_enableLpp (false),
   m_hopCntMetric (false),
-  m_useGeoInfo (false)
+  m_useGeoInfo (false),
+  m_dataSeqnoTimeout (Seconds (0)),
+  m_dataSeqnoMaxSize (0),
+  m_hwmpSeqnoTimeout (Seconds (0)),
+  m_hwmpSeqnoMaxSize (0),
+  m_neighborEtxTimeout (Seconds (0)),
+  m_neighborEtxMaxSize (0),
+  m_etxWindow (12),
+  m_multipathNextHops (1),
+  m_multipathFlowHashing (false),
+  m_multipathTolerance (0.1),
+  m_localRepair (false),
+  m_localRepairTtlMargin (2),
+  m_localRepairTimeout (MicroSeconds (1024*100)),
+  m_preqSuppression (false),
+  m_preqSuppressionJitter (MilliSeconds (5)),
+  m_preqSuppressionThreshold (3),
+  m_preqSuppressionCoverage (true)
 {
   NS_LOG_FUNCTION (this);
   m_coefficient = CreateObject<UniformRandomVariable> ();
+  m_lastDataSeqno.wheel.SetExpiryCallback (MakeCallback (&HwmpProtocol::ExpireDataSeqno, this));
+  m_hwmpSeqnoMetricDatabase.wheel.SetExpiryCallback (MakeCallback (&HwmpProtocol::ExpireHwmpSeqno, this));
 }
 
 HwmpProtocol::~HwmpProtocol ()
@@ -265,6 +492,17 @@ void
 HwmpProtocol::DoInitialize ()
 {
   NS_LOG_FUNCTION (this);
+  // A neighbor is not forgotten while it still counts in its ETX window
+  Time etxTimeout = m_neighborEtxTimeout;
+  Time window = m_dot11MeshHWMPlppMinInterval * (int64_t)m_etxWindow;
+  if (!etxTimeout.IsZero () && etxTimeout < window)
+    {
+      etxTimeout = window;
+    }
+  m_nbEtx.SetWindow (m_etxWindow);
+  m_nbEtx.SetLimits (etxTimeout, m_neighborEtxMaxSize);
+  m_nbEtx.SetEtxChangeCallback (MakeCallback (&HwmpProtocol::NotifyEtxChange, this));
+  m_rtable->SetMaxAlternatives (m_multipathNextHops - 1);
   if (m_etxMetric)
     m_enableLpp = true;
   if(m_enableLpp)
@@ -274,7 +512,12 @@ HwmpProtocol::DoInitialize ()
     m_lppTimer = Simulator::Schedule(lppRandomStart, &HwmpProtocol::SendLpp, this);
   }
   m_coefficient->SetAttribute ("Max", DoubleValue (m_randomStart.GetSeconds ()));
-  if (m_isRoot)
+  if (m_isRoot && m_rootAnnouncement)
+    {
+      Time randomStart = Seconds (m_coefficient->GetValue ());
+      m_rannTimer = Simulator::Schedule (randomStart, &HwmpProtocol::SendRann, this);
+    }
+  else if (m_isRoot)
     {
       Time randomStart = Seconds (m_coefficient->GetValue ());
       m_proactivePreqTimer = Simulator::Schedule (randomStart, &HwmpProtocol::SendProactivePreq, this);
@@ -289,13 +532,34 @@ HwmpProtocol::DoDispose ()
     {
       i->second.preqTimeout.Cancel ();
     }
+  for (std::map<Mac48Address, LocalRepair>::iterator i = m_localRepairs.begin (); i != m_localRepairs.end (); i++)
+    {
+      i->second.timeout.Cancel ();
+    }
+  m_localRepairs.clear ();
+  for (std::map<Mac48Address, PendingPreq>::iterator i = m_pendingPreqs.begin (); i != m_pendingPreqs.end (); i++)
+    {
+      i->second.timer.Cancel ();
+    }
+  m_pendingPreqs.clear ();
+  m_rannRoots.clear ();
+  m_lppParts.clear ();
   m_proactivePreqTimer.Cancel ();
+  m_rannTimer.Cancel ();
   if (m_enableLpp) m_lppTimer.Cancel();
   m_preqTimeouts.clear ();
-  m_lastDataSeqno.clear ();
-  m_hwmpSeqnoMetricDatabase.clear ();
+  m_lastDataSeqno.entries.clear ();
+  m_lastDataSeqno.lru.clear ();
+  m_lastDataSeqno.wheel.Clear ();
+  m_hwmpSeqnoMetricDatabase.entries.clear ();
+  m_hwmpSeqnoMetricDatabase.lru.clear ();
+  m_hwmpSeqnoMetricDatabase.wheel.Clear ();
   m_interfaces.clear ();
+  m_rqueuePurgeEvent.Cancel ();
   m_rqueue.clear ();
+  m_rqueueOrder.clear ();
+  m_rqueuePackets = 0;
+  m_rqueueBytes = 0;
   m_rtable = 0;
   m_mp = 0;
 }
@@ -399,7 +663,35 @@ HwmpProtocol::ForwardUnicast (uint32_t  sourceIface, const Mac48Address source,
 {
   NS_LOG_FUNCTION (this << sourceIface << source << destination << packet << protocolType << ttl);
   NS_ASSERT (destination != Mac48Address::GetBroadcast ());
-  HwmpRtable::LookupResult result = m_rtable->LookupReactive (destination);
+  //A single probe serves the valid and the expired reactive path lookups
+  const HwmpRtable::ReactiveRoute * route = m_rtable->FindReactive (destination);
+  if (!m_rannRoots.empty () && sourceIface == GetMeshPoint ()->GetIfIndex ())
+    {
+      std::map<Mac48Address, RannState>::iterator rann = m_rannRoots.find (destination);
+      if (rann != m_rannRoots.end ())
+        {
+          rann->second.lastUse = Simulator::Now ();
+        }
+    }
+  if (route != 0 && route->IsExpired () && route->nAlternatives > 0 && m_rtable->RenewFromAlternative (destination))
+    {
+      NotifyFailOver (destination);
+      route = m_rtable->FindReactive (destination);
+    }
+  HwmpRtable::LookupResult result;
+  if (route != 0 && !route->IsExpired ())
+    {
+      if (m_multipathFlowHashing && route->nAlternatives > 0)
+        {
+          double maxMetric = route->metric * (1 + m_multipathTolerance);
+          result = route->GetLookupResult (GetFlowHash (source, destination, protocolType),
+                                           (maxMetric < HwmpRtable::MAX_METRIC) ? (uint32_t)maxMetric : HwmpRtable::MAX_METRIC);
+        }
+      else
+        {
+          result = route->GetLookupResult ();
+        }
+    }
   NS_LOG_DEBUG ("Requested src = "<<source<<", dst = "<<destination<<", I am "<<GetAddress ()<<", RA = "<<result.retransmitter);
   if (result.retransmitter == Mac48Address::GetBroadcast ())
     {
@@ -418,11 +710,31 @@ HwmpProtocol::ForwardUnicast (uint32_t  sourceIface, const Mac48Address source,
       m_stats.txBytes += packet->GetSize ();
       return true;
     }
+  if (sourceIface != GetMeshPoint ()->GetIfIndex () && m_localRepair && route != 0)
+    {
+      //Look for the destination nearby, the path error waits for the result
+      StartLocalRepair (destination);
+      QueuedPacket pkt;
+      pkt.pkt = packet;
+      pkt.dst = destination;
+      pkt.src = source;
+      pkt.protocol = protocolType;
+      pkt.reply = routeReply;
+      pkt.inInterface = sourceIface;
+      if (QueuePacket (pkt))
+        {
+          m_stats.totalQueued++;
+          return true;
+        }
+      m_stats.totalDropped++;
+      NS_LOG_DEBUG ("Dropping packet from " << source << " to " << destination << " due to queue overflow");
+      return false;
+    }
   if (sourceIface != GetMeshPoint ()->GetIfIndex ())
     {
       //Start path error procedure:
       NS_LOG_DEBUG ("Must Send PERR");
-      result = m_rtable->LookupReactiveExpired (destination);
+      result = (route != 0) ? route->GetLookupResult () : HwmpRtable::LookupResult ();
       NS_LOG_DEBUG ("Path error " << result.retransmitter);
       //1.  Lookup expired reactive path. If exists - start path error
       //    procedure towards a next hop of this path
@@ -438,14 +750,21 @@ HwmpProtocol::ForwardUnicast (uint32_t  sourceIface, const Mac48Address source,
         {
           NS_LOG_DEBUG ("Path error, initiate reactive path error");
           std::vector<FailedDestination> destinations = m_rtable->GetUnreachableDestinations (result.retransmitter);
-          InitiatePathError (MakePathError (destinations));
+          InitiatePathError (MakePathError (std::move (destinations)));
         }
       m_stats.totalDropped++;
       return false;
     }
   //Request a destination:
-  result = m_rtable->LookupReactiveExpired (destination);
-  if (ShouldSendPreq (destination))
+  result = (route != 0) ? route->GetLookupResult () : HwmpRtable::LookupResult ();
+  if (FindRann (destination) != 0)
+    {
+      if (ShouldSendPreq (destination))
+        {
+          SendRootPreq (destination);
+        }
+    }
+  else if (ShouldSendPreq (destination))
     {
       uint32_t originator_seqno = GetNextHwmpSeqno ();
       uint32_t dst_seqno = 0;
@@ -456,7 +775,7 @@ HwmpProtocol::ForwardUnicast (uint32_t  sourceIface, const Mac48Address source,
       m_stats.initiatedPreq++;
       for (HwmpProtocolMacMap::const_iterator i = m_interfaces.begin (); i != m_interfaces.end (); i++)
         {
-          i->second->RequestDestination (destination, originator_seqno, dst_seqno);
+          i->second->RequestDestination (destination, originator_seqno, dst_seqno, m_maxTtl);
         }
     }
   QueuedPacket pkt;
@@ -479,7 +798,7 @@ HwmpProtocol::ForwardUnicast (uint32_t  sourceIface, const Mac48Address source,
     }
 }
 void
-HwmpProtocol::ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, Mac48Address fromMp, uint32_t metric)
+HwmpProtocol::ReceivePreq (IePreq & preq, Mac48Address from, uint32_t interface, Mac48Address fromMp, uint32_t metric)
 {
   if(m_etxMetric)
   {
@@ -493,36 +812,36 @@ HwmpProtocol::ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, M
   NS_LOG_FUNCTION (this << from << interface << fromMp << metric);
   preq.IncrementMetric (metric);
   //acceptance criteria:
-  std::map<Mac48Address, std::pair<uint32_t, uint32_t> >::const_iterator i = m_hwmpSeqnoMetricDatabase.find (
-      preq.GetOriginatorAddress ());
+  const SeqnoEntry * i = FindSeqno (m_hwmpSeqnoMetricDatabase, preq.GetOriginatorAddress ());
   bool freshInfo (true);
-  if (i != m_hwmpSeqnoMetricDatabase.end ())
+  if (i != 0)
     {
-      if ((int32_t)(i->second.first - preq.GetOriginatorSeqNumber ())  > 0)
+      if ((int32_t)(i->seqno - preq.GetOriginatorSeqNumber ())  > 0)
         {
           return;
         }
-      if (i->second.first == preq.GetOriginatorSeqNumber ())
+      if (i->seqno == preq.GetOriginatorSeqNumber ())
         {
           freshInfo = false;
-          if (i->second.second <= preq.GetMetric ())
+          if (i->metric <= preq.GetMetric ())
             {
+              //Not forwarded, but the path may still serve as an alternative
+              m_rtable->AddAlternativePath (preq.GetOriginatorAddress (), from, interface, preq.GetMetric (),
+                                            preq.GetMetric () - metric, MicroSeconds (preq.GetLifetime () * 1024),
+                                            preq.GetOriginatorSeqNumber ());
+              if (m_preqSuppression)
+                {
+                  OverhearPreq (preq, from, preq.GetMetric () - metric);
+                }
               return;
             }
         }
     }
-  m_hwmpSeqnoMetricDatabase[preq.GetOriginatorAddress ()] =
-    std::make_pair (preq.GetOriginatorSeqNumber (), preq.GetMetric ());
+  WriteSeqno (m_hwmpSeqnoMetricDatabase, m_hwmpSeqnoTimeout, m_hwmpSeqnoMaxSize, preq.GetOriginatorAddress (),
+              preq.GetOriginatorSeqNumber (), preq.GetMetric ());
   NS_LOG_DEBUG ("I am " << GetAddress () << ", Accepted preq from address" << from << ", preq:" << preq);
-  std::vector<Ptr<DestinationAddressUnit> > destinations = preq.GetDestinationList ();
   //Add reactive path to originator:
-  if (
-    (freshInfo) ||
-    (
-      (m_rtable->LookupReactive (preq.GetOriginatorAddress ()).retransmitter == Mac48Address::GetBroadcast ()) ||
-      (m_rtable->LookupReactive (preq.GetOriginatorAddress ()).metric > preq.GetMetric ())
-    )
-    )
+  if ((freshInfo) || IsBetterReactivePath (preq.GetOriginatorAddress (), preq.GetMetric ()))
     {
       m_rtable->AddReactivePath (
         preq.GetOriginatorAddress (),
@@ -530,24 +849,21 @@ HwmpProtocol::ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, M
         interface,
         preq.GetMetric (),
         MicroSeconds (preq.GetLifetime () * 1024),
-        preq.GetOriginatorSeqNumber ()
+        preq.GetOriginatorSeqNumber (),
+        preq.GetMetric () - metric,
+        preq.GetHopCount ()
         );
-      // Notify trace source of routing change
-      struct RouteChange rChange;
-      rChange.type = "Add Reactive";
-      rChange.destination = preq.GetOriginatorAddress ();
-      rChange.retransmitter = from;
-      rChange.interface = interface;
-      rChange.metric = preq.GetMetric ();
-      rChange.lifetime = MicroSeconds (preq.GetLifetime () * 1024);
-      rChange.seqnum = preq.GetOriginatorSeqNumber ();
-      m_routeChangeTraceSource (rChange);
+      NotifyRouteChange (ROUTE_CHANGE_ADD_REACTIVE, preq.GetOriginatorAddress (), from, interface, preq.GetMetric (),
+                         MicroSeconds (preq.GetLifetime () * 1024), preq.GetOriginatorSeqNumber ());
       ReactivePathResolved (preq.GetOriginatorAddress ());
     }
-  if (
-    (m_rtable->LookupReactive (fromMp).retransmitter == Mac48Address::GetBroadcast ()) ||
-    (m_rtable->LookupReactive (fromMp).metric > metric)
-    )
+  else
+    {
+      m_rtable->AddAlternativePath (preq.GetOriginatorAddress (), from, interface, preq.GetMetric (),
+                                    preq.GetMetric () - metric, MicroSeconds (preq.GetLifetime () * 1024),
+                                    preq.GetOriginatorSeqNumber ());
+    }
+  if (IsBetterReactivePath (fromMp, metric))
     {
       m_rtable->AddReactivePath (
         fromMp,
@@ -557,34 +873,26 @@ HwmpProtocol::ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, M
         MicroSeconds (preq.GetLifetime () * 1024),
         preq.GetOriginatorSeqNumber ()
         );
-      // Notify trace source of routing change
-      struct RouteChange rChange;
-      rChange.type = "Add Reactive";
-      rChange.destination = fromMp;
-      rChange.retransmitter = from;
-      rChange.interface = interface;
-      rChange.metric = metric;
-      rChange.lifetime = MicroSeconds (preq.GetLifetime () * 1024);
-      rChange.seqnum = preq.GetOriginatorSeqNumber ();
-      m_routeChangeTraceSource (rChange);
+      NotifyRouteChange (ROUTE_CHANGE_ADD_REACTIVE, fromMp, from, interface, metric,
+                         MicroSeconds (preq.GetLifetime () * 1024), preq.GetOriginatorSeqNumber ());
       ReactivePathResolved (fromMp);
     }
-  for (std::vector<Ptr<DestinationAddressUnit> >::const_iterator i = destinations.begin (); i != destinations.end (); i++)
+  //A unit answered here is deleted from preq and the next one takes its index
+  for (uint8_t j = 0; j < preq.GetDestCount (); )
     {
-      if ((*i)->GetDestinationAddress () == Mac48Address::GetBroadcast ())
+      DestinationAddressUnit & unit = preq.GetDestination (j);
+      if (unit.GetDestinationAddress () == Mac48Address::GetBroadcast ())
         {
           //only proactive PREQ contains destination
           //address as broadcast! Proactive preq MUST
           //have destination count equal to 1 and
           //per destination flags DO and RF
           NS_ASSERT (preq.GetDestCount () == 1);
-          NS_ASSERT (((*i)->IsDo ()) && ((*i)->IsRf ()));
+          NS_ASSERT ((unit.IsDo ()) && (unit.IsRf ()));
           //Add proactive path only if it is the better then existed
           //before
-          if (
-            ((m_rtable->LookupProactive ()).retransmitter == Mac48Address::GetBroadcast ()) ||
-            ((m_rtable->LookupProactive ()).metric > preq.GetMetric ())
-            )
+          HwmpRtable::LookupResult root = m_rtable->LookupProactive ();
+          if ((root.retransmitter == Mac48Address::GetBroadcast ()) || (root.metric > preq.GetMetric ()))
             {
               m_rtable->AddProactivePath (
                 preq.GetMetric (),
@@ -594,16 +902,8 @@ HwmpProtocol::ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, M
                 MicroSeconds (preq.GetLifetime () * 1024),
                 preq.GetOriginatorSeqNumber ()
                 );
-              // Notify trace source of routing change
-              struct RouteChange rChange;
-              rChange.type = "Add Proactive";
-              rChange.destination = preq.GetOriginatorAddress ();
-              rChange.retransmitter = from;
-              rChange.interface = interface;
-              rChange.metric = preq.GetMetric ();
-              rChange.lifetime = MicroSeconds (preq.GetLifetime () * 1024);
-              rChange.seqnum = preq.GetOriginatorSeqNumber ();
-              m_routeChangeTraceSource (rChange);
+              NotifyRouteChange (ROUTE_CHANGE_ADD_PROACTIVE, preq.GetOriginatorAddress (), from, interface, preq.GetMetric (),
+                                 MicroSeconds (preq.GetLifetime () * 1024), preq.GetOriginatorSeqNumber ());
               ProactivePathResolved ();
             }
           if (!preq.IsNeedNotPrep ())
@@ -621,7 +921,7 @@ HwmpProtocol::ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, M
             }
           break;
         }
-      if ((*i)->GetDestinationAddress () == GetAddress ())
+      if (unit.GetDestinationAddress () == GetAddress ())
         {
           SendPrep (
             GetAddress (),
@@ -634,19 +934,19 @@ HwmpProtocol::ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, M
             interface
             );
           NS_ASSERT (m_rtable->LookupReactive (preq.GetOriginatorAddress ()).retransmitter != Mac48Address::GetBroadcast ());
-          preq.DelDestinationAddressElement ((*i)->GetDestinationAddress ());
+          preq.DelDestinationAddressElement (unit.GetDestinationAddress ());
           continue;
         }
       //check if can answer:
-      HwmpRtable::LookupResult result = m_rtable->LookupReactive ((*i)->GetDestinationAddress ());
-      if ((!((*i)->IsDo ())) && (result.retransmitter != Mac48Address::GetBroadcast ()))
+      HwmpRtable::LookupResult result = m_rtable->LookupReactive (unit.GetDestinationAddress ());
+      if ((!(unit.IsDo ())) && (result.retransmitter != Mac48Address::GetBroadcast ()))
         {
           //have a valid information and can answer
           uint32_t lifetime = result.lifetime.GetMicroSeconds () / 1024;
-          if ((lifetime > 0) && ((int32_t)(result.seqnum - (*i)->GetDestSeqNumber ()) >= 0))
+          if ((lifetime > 0) && ((int32_t)(result.seqnum - unit.GetDestSeqNumber ()) >= 0))
             {
               SendPrep (
-                (*i)->GetDestinationAddress (),
+                unit.GetDestinationAddress (),
                 preq.GetOriginatorAddress (),
                 from,
                 result.metric,
@@ -655,34 +955,137 @@ HwmpProtocol::ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, M
                 lifetime,
                 interface
                 );
-              m_rtable->AddPrecursor ((*i)->GetDestinationAddress (), interface, from,
+              m_rtable->AddPrecursor (unit.GetDestinationAddress (), interface, from,
                                       MicroSeconds (preq.GetLifetime () * 1024));
-              if ((*i)->IsRf ())
+              if (unit.IsRf ())
                 {
-                  (*i)->SetFlags (true, false, (*i)->IsUsn ()); //DO = 1, RF = 0
+                  unit.SetFlags (true, false, unit.IsUsn ()); //DO = 1, RF = 0
                 }
               else
                 {
-                  preq.DelDestinationAddressElement ((*i)->GetDestinationAddress ());
+                  preq.DelDestinationAddressElement (unit.GetDestinationAddress ());
                   continue;
                 }
             }
         }
+      j++;
     }
   //check if must retransmit:
   if (preq.GetDestCount () == 0)
     {
       return;
     }
+  //A PREQ for an announced root follows the announcements back to it
+  const RannState * rann = (preq.GetDestCount () == 1) ? FindRann (preq.GetDestination (0).GetDestinationAddress ()) : 0;
+  if (rann != 0)
+    {
+      NS_LOG_DEBUG ("I am " << GetAddress () << ", forwarding PREQ to root through " << rann->retransmitter);
+      m_stats.forwardedPreq++;
+      m_interfaces[rann->interface]->SendPreq (preq, rann->retransmitter);
+      return;
+    }
+  if (m_preqSuppression)
+    {
+      SchedulePreqForward (preq, from);
+      return;
+    }
   //Forward PREQ to all interfaces:
   NS_LOG_DEBUG ("I am " << GetAddress () << "retransmitting PREQ:" << preq);
+  m_stats.forwardedPreq++;
   for (HwmpProtocolMacMap::const_iterator i = m_interfaces.begin (); i != m_interfaces.end (); i++)
     {
       i->second->SendPreq (preq);
     }
 }
 void
-HwmpProtocol::ReceivePrep (IePrep prep, Mac48Address from, uint32_t interface, Mac48Address fromMp, uint32_t metric)
+HwmpProtocol::SchedulePreqForward (const IePreq & preq, Mac48Address from)
+{
+  NS_LOG_FUNCTION (this << preq.GetOriginatorAddress () << from);
+  PendingPreq & pending = m_pendingPreqs[preq.GetOriginatorAddress ()];
+  if (pending.timer.IsRunning () && pending.preq.GetOriginatorSeqNumber () == preq.GetOriginatorSeqNumber ())
+    {
+      //A better copy replaces the one waiting, copies heard so far were not better than it
+      pending.copies = 0;
+    }
+  else
+    {
+      pending.timer.Cancel ();
+      pending.copies = 0;
+      pending.heardFrom.clear ();
+      pending.timer = Simulator::Schedule (Seconds (m_coefficient->GetValue (0, m_preqSuppressionJitter.GetSeconds ())),
+                                           &HwmpProtocol::ForwardPendingPreq, this, preq.GetOriginatorAddress ());
+    }
+  pending.preq = preq;
+  pending.heardFrom.insert (MeshTimerWheel::GetKey (from));
+}
+void
+HwmpProtocol::OverhearPreq (const IePreq & preq, Mac48Address from, uint32_t advertisedMetric)
+{
+  std::map<Mac48Address, PendingPreq>::iterator i = m_pendingPreqs.find (preq.GetOriginatorAddress ());
+  if (i == m_pendingPreqs.end () || i->second.preq.GetOriginatorSeqNumber () != preq.GetOriginatorSeqNumber ())
+    {
+      return;
+    }
+  i->second.heardFrom.insert (MeshTimerWheel::GetKey (from));
+  if (advertisedMetric <= i->second.preq.GetMetric ())
+    {
+      i->second.copies++;
+    }
+}
+void
+HwmpProtocol::ForwardPendingPreq (Mac48Address originator)
+{
+  NS_LOG_FUNCTION (this << originator);
+  std::map<Mac48Address, PendingPreq>::iterator i = m_pendingPreqs.find (originator);
+  NS_ASSERT (i != m_pendingPreqs.end ());
+  PendingPreq & pending = i->second;
+  bool suppress = (m_preqSuppressionThreshold > 0 && pending.copies >= m_preqSuppressionThreshold);
+  if (!suppress && m_preqSuppressionCoverage && !m_neighboursCallback.IsNull ())
+    {
+      //Suppressed if no peer on any interface would hear it for the first time
+      bool anyPeer = false;
+      suppress = true;
+      for (HwmpProtocolMacMap::const_iterator j = m_interfaces.begin (); j != m_interfaces.end () && suppress; j++)
+        {
+          std::vector<Mac48Address> peers = m_neighboursCallback (j->first);
+          for (std::vector<Mac48Address>::const_iterator peer = peers.begin (); peer != peers.end (); peer++)
+            {
+              anyPeer = true;
+              if (*peer != originator && pending.heardFrom.count (MeshTimerWheel::GetKey (*peer)) == 0)
+                {
+                  suppress = false;
+                  break;
+                }
+            }
+        }
+      suppress = suppress && anyPeer;
+    }
+  if (suppress)
+    {
+      NS_LOG_DEBUG ("I am " << GetAddress () << ", suppressed PREQ from " << originator << " after "
+                            << pending.copies << " copies from " << pending.heardFrom.size () << " neighbors");
+      m_stats.suppressedPreq++;
+    }
+  else
+    {
+      NS_LOG_DEBUG ("I am " << GetAddress () << "retransmitting PREQ:" << pending.preq);
+      m_stats.forwardedPreq++;
+      for (HwmpProtocolMacMap::const_iterator j = m_interfaces.begin (); j != m_interfaces.end (); j++)
+        {
+          j->second->SendPreq (pending.preq);
+        }
+    }
+  m_pendingPreqs.erase (i);
+}
+bool
+HwmpProtocol::IsBetterReactivePath (Mac48Address destination, uint32_t metric) const
+{
+  const HwmpRtable::ReactiveRoute * route = m_rtable->FindReactive (destination);
+  return (route == 0) || route->IsExpired () || (route->retransmitter == Mac48Address::GetBroadcast ())
+         || (route->metric > metric);
+}
+void
+HwmpProtocol::ReceivePrep (IePrep & prep, Mac48Address from, uint32_t interface, Mac48Address fromMp, uint32_t metric)
 {
   if(m_etxMetric)
   {
@@ -696,35 +1099,29 @@ HwmpProtocol::ReceivePrep (IePrep prep, Mac48Address from, uint32_t interface, M
   NS_LOG_FUNCTION (this << from << interface << fromMp << metric);
   prep.IncrementMetric (metric);
   //acceptance criteria:
-  std::map<Mac48Address, std::pair<uint32_t, uint32_t> >::const_iterator i = m_hwmpSeqnoMetricDatabase.find (
-      prep.GetOriginatorAddress ());
+  const SeqnoEntry * i = FindSeqno (m_hwmpSeqnoMetricDatabase, prep.GetOriginatorAddress ());
   bool freshInfo (true);
   uint32_t sequence = prep.GetDestinationSeqNumber ();
-  if (i != m_hwmpSeqnoMetricDatabase.end ())
+  if (i != 0)
     {
-      if ((int32_t)(i->second.first - sequence) > 0)
+      if ((int32_t)(i->seqno - sequence) > 0)
         {
           return;
         }
-      if (i->second.first == sequence)
+      if (i->seqno == sequence)
         {
           freshInfo = false;
         }
     }
-  m_hwmpSeqnoMetricDatabase[prep.GetOriginatorAddress ()] = std::make_pair (sequence, prep.GetMetric ());
+  WriteSeqno (m_hwmpSeqnoMetricDatabase, m_hwmpSeqnoTimeout, m_hwmpSeqnoMaxSize, prep.GetOriginatorAddress (),
+              sequence, prep.GetMetric ());
   //update routing info
   //Now add a path to destination and add precursor to source
   NS_LOG_DEBUG ("I am " << GetAddress () << ", received prep from " << prep.GetOriginatorAddress () << ", receiver was:" << from);
   HwmpRtable::LookupResult result = m_rtable->LookupReactive (prep.GetDestinationAddress ());
   //Add a reactive path only if seqno is fresher or it improves the
   //metric
-  if (
-    (freshInfo) ||
-    (
-      ((m_rtable->LookupReactive (prep.GetOriginatorAddress ())).retransmitter == Mac48Address::GetBroadcast ()) ||
-      ((m_rtable->LookupReactive (prep.GetOriginatorAddress ())).metric > prep.GetMetric ())
-    )
-    )
+  if ((freshInfo) || IsBetterReactivePath (prep.GetOriginatorAddress (), prep.GetMetric ()))
     {
       m_rtable->AddReactivePath (
         prep.GetOriginatorAddress (),
@@ -732,17 +1129,11 @@ HwmpProtocol::ReceivePrep (IePrep prep, Mac48Address from, uint32_t interface, M
         interface,
         prep.GetMetric (),
         MicroSeconds (prep.GetLifetime () * 1024),
-        sequence);
-      // Notify trace source of routing change
-      struct RouteChange rChange;
-      rChange.type = "Add Reactive";
-      rChange.destination = prep.GetOriginatorAddress ();
-      rChange.retransmitter = from;
-      rChange.interface = interface;
-      rChange.metric = prep.GetMetric ();
-      rChange.lifetime = MicroSeconds (prep.GetLifetime () * 1024);
-      rChange.seqnum = sequence;
-      m_routeChangeTraceSource (rChange);
+        sequence,
+        prep.GetMetric () - metric,
+        prep.GetHopcount ());
+      NotifyRouteChange (ROUTE_CHANGE_ADD_REACTIVE, prep.GetOriginatorAddress (), from, interface, prep.GetMetric (),
+                         MicroSeconds (prep.GetLifetime () * 1024), sequence);
       m_rtable->AddPrecursor (prep.GetDestinationAddress (), interface, from,
                               MicroSeconds (prep.GetLifetime () * 1024));
       if (result.retransmitter != Mac48Address::GetBroadcast ())
@@ -752,10 +1143,12 @@ HwmpProtocol::ReceivePrep (IePrep prep, Mac48Address from, uint32_t interface, M
         }
       ReactivePathResolved (prep.GetOriginatorAddress ());
     }
-  if (
-    ((m_rtable->LookupReactive (fromMp)).retransmitter == Mac48Address::GetBroadcast ()) ||
-    ((m_rtable->LookupReactive (fromMp)).metric > metric)
-    )
+  else
+    {
+      m_rtable->AddAlternativePath (prep.GetOriginatorAddress (), from, interface, prep.GetMetric (),
+                                    prep.GetMetric () - metric, MicroSeconds (prep.GetLifetime () * 1024), sequence);
+    }
+  if (IsBetterReactivePath (fromMp, metric))
     {
       m_rtable->AddReactivePath (
         fromMp,
@@ -764,16 +1157,8 @@ HwmpProtocol::ReceivePrep (IePrep prep, Mac48Address from, uint32_t interface, M
         metric,
         MicroSeconds (prep.GetLifetime () * 1024),
         sequence);
-      // Notify trace source of routing change
-      struct RouteChange rChange;
-      rChange.type = "Add Reactive";
-      rChange.destination = fromMp;
-      rChange.retransmitter = from;
-      rChange.interface = interface;
-      rChange.metric = metric;
-      rChange.lifetime = MicroSeconds (prep.GetLifetime () * 1024);
-      rChange.seqnum = sequence;
-      m_routeChangeTraceSource (rChange);
+      NotifyRouteChange (ROUTE_CHANGE_ADD_REACTIVE, fromMp, from, interface, metric,
+                         MicroSeconds (prep.GetLifetime () * 1024), sequence);
       ReactivePathResolved (fromMp);
     }
   if (prep.GetDestinationAddress () == GetAddress ())
@@ -791,25 +1176,69 @@ HwmpProtocol::ReceivePrep (IePrep prep, Mac48Address from, uint32_t interface, M
   prep_sender->second->SendPrep (prep, result.retransmitter);
 }
 void
-HwmpProtocol::ReceiveLpp(IeLpp lpp, Mac48Address from, uint32_t interface, Mac48Address fromMp)
+HwmpProtocol::ReceiveLpp (const std::vector<Ptr<IeLpp> > & lpp, Mac48Address from, uint32_t interface, Mac48Address fromMp)
 {
   NS_LOG_FUNCTION(this << from << interface);
-  Mac48Address origin = lpp.GetOriginAddress();
+  Mac48Address origin = lpp.front ()->GetOriginAddress();
   NS_ASSERT(origin == from); // Neighbor from which the packet is received is always originator of LPP packet
-  uint8_t lppTimeStamp = lpp.GetLppId();
-  uint8_t numNeighbors = lpp.GetNumberNeighbors();
-  std::pair<Mac48Address, uint8_t> nb_lppreverse;
+  uint8_t lppTimeStamp = lpp.front ()->GetLppId();
+  uint32_t seqno = lpp.front ()->GetOriginSeqno ();
+  uint8_t count = lpp.front ()->GetFragmentCount ();
 
-  // Search for my MAC address in LPP packet
-  uint8_t lppReverse = 0; // if my address is not found i n the packet, lpp reverse should be 0
-  for (uint8_t j = 0; j<numNeighbors; ++j)
+  // Parts of the neighbor list in this frame, and my LPP count if found in them
+  uint32_t received = 0;
+  uint8_t lppReverse = 0; // 0 if my address is not found in the packet
+  for (uint32_t i = 0; i < lpp.size (); i++)
     {
-      lpp.RemoveFromNeighborsList(nb_lppreverse);
-      if (nb_lppreverse.first == GetAddress()) // is it my MAC address?
+      uint32_t part = (uint32_t)1 << lpp[i]->GetFragmentIndex ();
+      if (lpp[i]->GetFragmentCount () != count || lpp[i]->GetFragmentIndex () >= count
+          || lpp[i]->GetLppId () != lppTimeStamp
+          || lpp[i]->GetOriginSeqno () != seqno || (received & part) != 0)
         {
-          lppReverse = nb_lppreverse.second;
-          break;
+          NS_LOG_DEBUG ("I am " << GetAddress () << ", ignoring inconsistent LPP from " << from);
+          return;
+        }
+      received |= part;
+      if (lppReverse == 0)
+        {
+          // Search for my MAC address in LPP packet
+          lppReverse = lpp[i]->FindReverseCount (GetAddress ());
+        }
+    }
+  uint32_t all = ((uint32_t)1 << count) - 1;
+  if (received != all)
+    {
+      // The rest of the list comes in other frames of the same LPP
+      std::map<Mac48Address, LppParts>::iterator parts = m_lppParts.find (origin);
+      if (parts == m_lppParts.end ())
+        {
+          parts = m_lppParts.insert (std::make_pair (origin, LppParts ())).first;
+        }
+      if (parts->second.lppId != lppTimeStamp || parts->second.seqno != seqno || parts->second.count != count)
+        {
+          // Parts of an older list that was not completed are dropped
+          parts->second.lppId = lppTimeStamp;
+          parts->second.seqno = seqno;
+          parts->second.count = count;
+          parts->second.received = 0;
+          parts->second.lppReverse = 0;
+        }
+      if ((parts->second.received & received) != 0)
+        {
+          NS_LOG_DEBUG ("I am " << GetAddress () << ", ignoring repeated LPP parts from " << from);
+          return;
+        }
+      parts->second.received |= received;
+      if (parts->second.lppReverse == 0)
+        {
+          parts->second.lppReverse = lppReverse;
         }
+      if (parts->second.received != all)
+        {
+          return;
+        }
+      lppReverse = parts->second.lppReverse;
+      m_lppParts.erase (parts);
     }
   // Add new or udate existing etx entry for neighbor with MAC address "from".
   // LPP count is updated based on lpp Time Slot indicated in packet.
@@ -817,7 +1246,7 @@ HwmpProtocol::ReceiveLpp(IeLpp lpp, Mac48Address from, uint32_t interface, Mac48
   m_nbEtx.UpdateNeighborEtx(from, lppTimeStamp, lppReverse);
 }
 void
-HwmpProtocol::ReceivePerr (std::vector<FailedDestination> destinations, Mac48Address from, uint32_t interface, Mac48Address fromMp)
+HwmpProtocol::ReceivePerr (const std::vector<FailedDestination> & destinations, Mac48Address from, uint32_t interface, Mac48Address fromMp)
 {
   NS_LOG_FUNCTION (this << from << interface << fromMp);
   //Acceptance criteria:
@@ -833,6 +1262,12 @@ HwmpProtocol::ReceivePerr (std::vector<FailedDestination> destinations, Mac48Add
             ((int32_t)(result.seqnum - destinations[i].seqnum) > 0)
             ))
         {
+          //With multipath the path moves to an alternative instead of failing
+          if (m_multipathNextHops > 1 && m_rtable->FailOverDestination (destinations[i].destination, from))
+            {
+              NotifyFailOver (destinations[i].destination);
+              continue;
+            }
           retval.push_back (destinations[i]);
         }
     }
@@ -840,7 +1275,7 @@ HwmpProtocol::ReceivePerr (std::vector<FailedDestination> destinations, Mac48Add
     {
       return;
     }
-  ForwardPathError (MakePathError (retval));
+  ForwardPathError (MakePathError (std::move (retval)));
 }
 void
 HwmpProtocol::SendPrep (
@@ -870,15 +1305,18 @@ HwmpProtocol::SendPrep (
 void
 HwmpProtocol::SendLpp()
 {
-  IeLpp lpp;
   m_nbEtx.GotoNextTimeStampAndClearOldest ();
-  lpp.SetLppId(m_nbEtx.GetLppTimeStamp());
-  //Origin Address to be filled by HwmpProtocolMac::SendLpp function
-  lpp.SetOriginSeqno(GetNextHwmpSeqno());
-  m_nbEtx.FillLppCntData(lpp);
+  m_nbEtx.FillLppCntData(m_lpp);
+  uint32_t seqno = GetNextHwmpSeqno();
+  for (std::vector<IeLpp>::iterator i = m_lpp.begin (); i != m_lpp.end (); i++)
+    {
+      i->SetLppId(m_nbEtx.GetLppTimeStamp());
+      //Origin Address to be filled by HwmpProtocolMac::SendLpp function
+      i->SetOriginSeqno(seqno);
+    }
   for (HwmpProtocolMacMap::const_iterator lpp_sender = m_interfaces.begin(); lpp_sender != m_interfaces.end(); lpp_sender++)
     {
-      lpp_sender->second->SendLpp(lpp);
+      lpp_sender->second->SendLpp(m_lpp);
     }
   m_stats.initiatedLpp++;
   m_lppTimer = Simulator::Schedule(m_dot11MeshHWMPlppMinInterval, &HwmpProtocol::SendLpp, this);
@@ -929,9 +1367,25 @@ HwmpProtocol::PeerLinkStatus (Mac48Address meshPointAddress, Mac48Address peerAd
     {
       return;
     }
+  std::vector<Mac48Address> failedOver = m_rtable->FailOverPeer (peerAddress);
+  for (std::vector<Mac48Address>::const_iterator i = failedOver.begin (); i != failedOver.end (); i++)
+    {
+      NotifyFailOver (*i);
+    }
+  if (m_localRepair)
+    {
+      //Reactive paths through the peer are repaired, or reported, when a
+      //packet needs them. A broken path to the root is reported right away.
+      uint32_t expired = m_rtable->ExpireReactivePaths (peerAddress);
+      NS_LOG_DEBUG (expired << " paths through " << peerAddress << " left for local repair");
+      if (m_rtable->LookupProactive ().retransmitter != peerAddress)
+        {
+          return;
+        }
+    }
   std::vector<FailedDestination> destinations = m_rtable->GetUnreachableDestinations (peerAddress);
   NS_LOG_DEBUG (destinations.size () << " failed destinations for peer address " << peerAddress);
-  InitiatePathError (MakePathError (destinations));
+  InitiatePathError (MakePathError (std::move (destinations)));
 }
 void
 HwmpProtocol::SetNeighboursCallback (Callback<std::vector<Mac48Address>, uint32_t> cb)
@@ -946,20 +1400,82 @@ HwmpProtocol::DropDataFrame (uint32_t seqno, Mac48Address source)
     {
       return true;
     }
-  std::map<Mac48Address, uint32_t,std::less<Mac48Address> >::const_iterator i = m_lastDataSeqno.find (source);
-  if (i == m_lastDataSeqno.end ())
+  const SeqnoEntry * i = FindSeqno (m_lastDataSeqno, source);
+  if (i != 0 && (int32_t)(i->seqno - seqno) >= 0)
     {
-      m_lastDataSeqno[source] = seqno;
+      return true;
     }
-  else
+  WriteSeqno (m_lastDataSeqno, m_dataSeqnoTimeout, m_dataSeqnoMaxSize, source, seqno, 0);
+  return false;
+}
+const HwmpProtocol::SeqnoEntry *
+HwmpProtocol::FindSeqno (SeqnoDatabase & db, Mac48Address address)
+{
+  db.wheel.Advance ();
+  std::map<Mac48Address, SeqnoEntry>::const_iterator i = db.entries.find (address);
+  if (i == db.entries.end ())
+    {
+      return 0;
+    }
+  return &i->second;
+}
+void
+HwmpProtocol::WriteSeqno (SeqnoDatabase & db, Time timeout, uint32_t maxSize, Mac48Address address,
+                          uint32_t seqno, uint32_t metric)
+{
+  db.wheel.Advance ();
+  std::map<Mac48Address, SeqnoEntry>::iterator i = db.entries.find (address);
+  if (i == db.entries.end ())
     {
-      if ((int32_t)(i->second - seqno)  >= 0)
+      if (maxSize > 0 && db.entries.size () >= maxSize)
         {
-          return true;
+          // Make room by forgetting the address silent for the longest time
+          db.entries.erase (db.lru.front ());
+          db.lru.pop_front ();
+          db.evictedOverflow++;
+        }
+      i = db.entries.insert (std::make_pair (address, SeqnoEntry ())).first;
+      i->second.lruPosition = db.lru.insert (db.lru.end (), address);
+      i->second.wheelTag = db.nextWheelTag++;
+      if (!timeout.IsZero ())
+        {
+          db.wheel.Schedule (MeshTimerWheel::GetKey (address), i->second.wheelTag, Simulator::Now () + timeout);
         }
-      m_lastDataSeqno[source] = seqno;
     }
-  return false;
+  else
+    {
+      db.lru.splice (db.lru.end (), db.lru, i->second.lruPosition);
+    }
+  i->second.seqno = seqno;
+  i->second.metric = metric;
+  i->second.lastUpdate = Simulator::Now ();
+}
+Time
+HwmpProtocol::ExpireSeqno (SeqnoDatabase & db, Time timeout, uint64_t key, uint32_t tag)
+{
+  std::map<Mac48Address, SeqnoEntry>::iterator i = db.entries.find (MeshTimerWheel::GetAddress (key));
+  if (i == db.entries.end () || i->second.wheelTag != tag || timeout.IsZero ())
+    {
+      return Simulator::Now ();
+    }
+  if (i->second.lastUpdate + timeout > Simulator::Now ())
+    {
+      return i->second.lastUpdate + timeout;
+    }
+  db.lru.erase (i->second.lruPosition);
+  db.entries.erase (i);
+  db.evictedExpired++;
+  return Simulator::Now ();
+}
+Time
+HwmpProtocol::ExpireDataSeqno (uint64_t key, uint32_t tag)
+{
+  return ExpireSeqno (m_lastDataSeqno, m_dataSeqnoTimeout, key, tag);
+}
+Time
+HwmpProtocol::ExpireHwmpSeqno (uint64_t key, uint32_t tag)
+{
+  return ExpireSeqno (m_hwmpSeqnoMetricDatabase, m_hwmpSeqnoTimeout, key, tag);
 }
 HwmpProtocol::PathError
 HwmpProtocol::MakePathError (std::vector<FailedDestination> destinations)
@@ -975,24 +1491,20 @@ HwmpProtocol::MakePathError (std::vector<FailedDestination> destinations)
   m_stats.initiatedPerr++;
   for (unsigned int i = 0; i < destinations.size (); i++)
     {
-      retval.destinations.push_back (destinations[i]);
       m_rtable->DeleteReactivePath (destinations[i].destination);
-      // Notify trace source of routing change
-      struct RouteChange rChange;
-      rChange.type = "Delete Reactive";
-      rChange.destination = destinations[i].destination;
-      rChange.seqnum = destinations[i].seqnum;
-      m_routeChangeTraceSource (rChange);
     }
+  NotifyRouteChangeBatch (ROUTE_CHANGE_DELETE_REACTIVE, destinations);
+  retval.destinations = std::move (destinations);
   return retval;
 }
 void
-HwmpProtocol::InitiatePathError (PathError perr)
+HwmpProtocol::InitiatePathError (const PathError & perr)
 {
   NS_LOG_FUNCTION (this);
+  std::vector<Mac48Address> receivers_for_interface;
   for (HwmpProtocolMacMap::const_iterator i = m_interfaces.begin (); i != m_interfaces.end (); i++)
     {
-      std::vector<Mac48Address> receivers_for_interface;
+      receivers_for_interface.clear ();
       for (unsigned int j = 0; j < perr.receivers.size (); j++)
         {
           if (i->first == perr.receivers[j].first)
@@ -1004,12 +1516,13 @@ HwmpProtocol::InitiatePathError (PathError perr)
     }
 }
 void
-HwmpProtocol::ForwardPathError (PathError perr)
+HwmpProtocol::ForwardPathError (const PathError & perr)
 {
   NS_LOG_FUNCTION (this);
+  std::vector<Mac48Address> receivers_for_interface;
   for (HwmpProtocolMacMap::const_iterator i = m_interfaces.begin (); i != m_interfaces.end (); i++)
     {
-      std::vector<Mac48Address> receivers_for_interface;
+      receivers_for_interface.clear ();
       for (unsigned int j = 0; j < perr.receivers.size (); j++)
         {
           if (i->first == perr.receivers[j].first)
@@ -1022,43 +1535,28 @@ HwmpProtocol::ForwardPathError (PathError perr)
 }
 
 std::vector<std::pair<uint32_t, Mac48Address> >
-HwmpProtocol::GetPerrReceivers (std::vector<FailedDestination> failedDest)
+HwmpProtocol::GetPerrReceivers (const std::vector<FailedDestination> & failedDest)
 {
   NS_LOG_FUNCTION (this);
   HwmpRtable::PrecursorList retval;
+  //A precursor of several failed destinations is a receiver once, on the
+  //interface it was first seen on:
+  std::unordered_set<uint64_t> receivers;
   for (unsigned int i = 0; i < failedDest.size (); i++)
     {
       HwmpRtable::PrecursorList precursors = m_rtable->GetPrecursors (failedDest[i].destination);
       m_rtable->DeleteReactivePath (failedDest[i].destination);
-      // Notify trace source of routing change
-      struct RouteChange rChange;
-      rChange.type = "Delete Reactive";
-      rChange.destination = failedDest[i].destination;
-      rChange.seqnum = failedDest[i].seqnum;
-      m_routeChangeTraceSource (rChange);
       m_rtable->DeleteProactivePath (failedDest[i].destination);
-      // Notify trace source of routing change
-      struct RouteChange rChangePro;
-      rChangePro.type = "Delete Proactive";
-      rChangePro.destination = failedDest[i].destination;
-      rChangePro.seqnum = failedDest[i].seqnum;
-      m_routeChangeTraceSource (rChangePro);
       for (unsigned int j = 0; j < precursors.size (); j++)
         {
-          retval.push_back (precursors[j]);
-        }
-    }
-  //Check if we have duplicates in retval and precursors:
-  for (unsigned int i = 0; i < retval.size (); i++)
-    {
-      for (unsigned int j = i+1; j < retval.size (); j++)
-        {
-          if (retval[i].second == retval[j].second)
+          if (receivers.insert (MeshTimerWheel::GetKey (precursors[j].second)).second)
             {
-              retval.erase (retval.begin () + j);
+              retval.push_back (precursors[j]);
             }
         }
     }
+  NotifyRouteChangeBatch (ROUTE_CHANGE_DELETE_REACTIVE, failedDest);
+  NotifyRouteChangeBatch (ROUTE_CHANGE_DELETE_PROACTIVE, failedDest);
   return retval;
 }
 std::vector<Mac48Address>
@@ -1098,11 +1596,47 @@ bool
 HwmpProtocol::QueuePacket (QueuedPacket packet)
 {
   NS_LOG_FUNCTION (this);
-  if (m_rqueue.size () > m_maxQueueSize)
+  PurgeExpiredPackets ();
+  uint32_t size = packet.pkt->GetSize ();
+  if (m_rqueuePackets > m_maxQueueSize
+      || (m_maxQueueBytes > 0 && m_rqueueBytes + size > m_maxQueueBytes))
     {
+      m_stats.droppedQueueFull++;
+      m_queueDropTrace (packet.pkt, packet.dst, QUEUE_OVERFLOW);
       return false;
     }
-  m_rqueue.push_back (packet);
+  RouteQueue::iterator fifo = m_rqueue.find (packet.dst);
+  if (fifo != m_rqueue.end () && m_maxQueueSizePerDst > 0 && fifo->second.size () >= m_maxQueueSizePerDst)
+    {
+      m_stats.droppedQueueFull++;
+      m_queueDropTrace (packet.pkt, packet.dst, DESTINATION_OVERFLOW);
+      return false;
+    }
+  if (m_rqueueOrder.size () > 2 * (size_t)m_rqueuePackets + 64)
+    {
+      // Too many entries of packets dequeued by destination, drop them
+      std::deque<std::pair<Mac48Address, uint64_t> > order;
+      for (std::deque<std::pair<Mac48Address, uint64_t> >::const_iterator i = m_rqueueOrder.begin ();
+           i != m_rqueueOrder.end (); i++)
+        {
+          if (FindQueuedPacket (i->first, i->second) != m_rqueue.end ())
+            {
+              order.push_back (*i);
+            }
+        }
+      m_rqueueOrder.swap (order);
+    }
+  packet.whenQueued = Simulator::Now ();
+  packet.queueSeqno = m_rqueueSeqno++;
+  m_rqueueOrder.push_back (std::make_pair (packet.dst, packet.queueSeqno));
+  m_rqueue[packet.dst].push_back (packet);
+  m_rqueuePackets++;
+  m_rqueueBytes += size;
+  if (!m_maxQueueTime.IsZero () && !m_rqueuePurgeEvent.IsRunning ())
+    {
+      // The queue was empty, this is the oldest packet
+      m_rqueuePurgeEvent = Simulator::Schedule (m_maxQueueTime + TimeStep (1), &HwmpProtocol::PurgeExpiredPackets, this);
+    }
   return true;
 }
 
@@ -1110,16 +1644,13 @@ HwmpProtocol::QueuedPacket
 HwmpProtocol::DequeueFirstPacketByDst (Mac48Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
+  PurgeExpiredPackets ();
   QueuedPacket retval;
   retval.pkt = 0;
-  for (std::vector<QueuedPacket>::iterator i = m_rqueue.begin (); i != m_rqueue.end (); i++)
+  RouteQueue::iterator fifo = m_rqueue.find (dst);
+  if (fifo != m_rqueue.end ())
     {
-      if ((*i).dst == dst)
-        {
-          retval = (*i);
-          m_rqueue.erase (i);
-          break;
-        }
+      retval = PopQueuedPacket (fifo);
     }
   return retval;
 }
@@ -1128,16 +1659,165 @@ HwmpProtocol::QueuedPacket
 HwmpProtocol::DequeueFirstPacket ()
 {
   NS_LOG_FUNCTION (this);
+  // Leaves the entry of the oldest queued packet at the head of m_rqueueOrder
+  PurgeExpiredPackets ();
   QueuedPacket retval;
   retval.pkt = 0;
-  if (m_rqueue.size () != 0)
+  if (!m_rqueueOrder.empty ())
+    {
+      RouteQueue::iterator fifo = m_rqueue.find (m_rqueueOrder.front ().first);
+      NS_ASSERT (fifo != m_rqueue.end () && fifo->second.front ().queueSeqno == m_rqueueOrder.front ().second);
+      m_rqueueOrder.pop_front ();
+      retval = PopQueuedPacket (fifo);
+    }
+  return retval;
+}
+
+HwmpProtocol::QueuedPacket
+HwmpProtocol::PopQueuedPacket (RouteQueue::iterator fifo)
+{
+  QueuedPacket retval = fifo->second.front ();
+  fifo->second.pop_front ();
+  if (fifo->second.empty ())
     {
-      retval = m_rqueue[0];
-      m_rqueue.erase (m_rqueue.begin ());
+      m_rqueue.erase (fifo);
     }
+  NS_ASSERT (m_rqueuePackets > 0 && m_rqueueBytes >= retval.pkt->GetSize ());
+  m_rqueuePackets--;
+  m_rqueueBytes -= retval.pkt->GetSize ();
   return retval;
 }
 
+HwmpProtocol::RouteQueue::iterator
+HwmpProtocol::FindQueuedPacket (Mac48Address dst, uint64_t seqno)
+{
+  // Packets leave a FIFO from its head only, so a packet is still queued
+  // as long as the head of its FIFO is not younger
+  RouteQueue::iterator fifo = m_rqueue.find (dst);
+  if (fifo != m_rqueue.end () && fifo->second.front ().queueSeqno <= seqno)
+    {
+      return fifo;
+    }
+  return m_rqueue.end ();
+}
+
+void
+HwmpProtocol::PurgeExpiredPackets ()
+{
+  while (!m_rqueueOrder.empty ())
+    {
+      RouteQueue::iterator fifo = FindQueuedPacket (m_rqueueOrder.front ().first, m_rqueueOrder.front ().second);
+      if (fifo != m_rqueue.end ())
+        {
+          // The oldest queued packet, the others are younger
+          if (m_maxQueueTime.IsZero ())
+            {
+              return;
+            }
+          Time age = Simulator::Now () - fifo->second.front ().whenQueued;
+          if (age <= m_maxQueueTime)
+            {
+              if (!m_rqueuePurgeEvent.IsRunning ())
+                {
+                  m_rqueuePurgeEvent = Simulator::Schedule (m_maxQueueTime - age + TimeStep (1),
+                                                            &HwmpProtocol::PurgeExpiredPackets, this);
+                }
+              return;
+            }
+          m_rqueueOrder.pop_front ();
+          QueuedPacket packet = PopQueuedPacket (fifo);
+          NS_LOG_DEBUG ("Dropping packet from " << packet.src << " to " << packet.dst << " after waiting "
+                        << (Simulator::Now () - packet.whenQueued).GetSeconds () << "s for a route");
+          m_stats.droppedQueueTimeout++;
+          DropQueuedPacket (packet, QUEUE_TIMEOUT);
+        }
+      else
+        {
+          m_rqueueOrder.pop_front ();
+        }
+    }
+}
+
+void
+HwmpProtocol::DropQueuedPacket (QueuedPacket packet, QueueDropReason reason)
+{
+  m_stats.totalDropped++;
+  m_queueDropTrace (packet.pkt, packet.dst, reason);
+  packet.reply (false, packet.pkt, packet.src, packet.dst, packet.protocol, HwmpRtable::MAX_METRIC);
+}
+
+void
+HwmpProtocol::DropQueuedPackets (Mac48Address dst, QueueDropReason reason)
+{
+  RouteQueue::iterator fifo = m_rqueue.find (dst);
+  if (fifo == m_rqueue.end ())
+    {
+      return;
+    }
+  std::deque<QueuedPacket> packets;
+  packets.swap (fifo->second);
+  m_rqueue.erase (fifo);
+  for (std::deque<QueuedPacket>::iterator packet = packets.begin (); packet != packets.end (); packet++)
+    {
+      m_rqueuePackets--;
+      m_rqueueBytes -= packet->pkt->GetSize ();
+      DropQueuedPacket (*packet, reason);
+    }
+}
+
+void
+HwmpProtocol::NotifyFailOver (Mac48Address destination)
+{
+  m_stats.failovers++;
+  const HwmpRtable::ReactiveRoute * route = m_rtable->FindReactive (destination);
+  NS_ASSERT (route != 0);
+  NS_LOG_DEBUG ("I am " << GetAddress () << ", path to " << destination << " moved to " << route->retransmitter);
+  NotifyRouteChange (ROUTE_CHANGE_ADD_REACTIVE, destination, route->retransmitter, route->interface, route->metric,
+                     route->whenExpire - Simulator::Now (), route->seqnum);
+}
+
+void
+HwmpProtocol::NotifyEtxChange (Mac48Address neighbor, uint32_t oldEtx, uint32_t newEtx)
+{
+  NS_LOG_DEBUG ("I am " << GetAddress () << ", ETX of " << neighbor << " changed from " << oldEtx << " to " << newEtx);
+  m_etxChangeTrace (neighbor, oldEtx, newEtx);
+}
+
+uint32_t
+HwmpProtocol::GetFlowHash (Mac48Address source, Mac48Address destination, uint16_t protocolType)
+{
+  uint64_t key = MeshTimerWheel::GetKey (source) * 0x9E3779B97F4A7C15ULL;
+  key ^= MeshTimerWheel::GetKey (destination) + ((uint64_t)protocolType << 48);
+  key *= 0x9E3779B97F4A7C15ULL;
+  return (uint32_t)(key >> 32);
+}
+void
+HwmpProtocol::NotifyRouteChange (RouteChangeType type, Mac48Address destination, Mac48Address retransmitter,
+                                 uint32_t interface, uint32_t metric, Time lifetime, uint32_t seqnum)
+{
+  if (m_routeChangeTraceSource.IsEmpty ())
+    {
+      return;
+    }
+  struct RouteChange rChange;
+  rChange.type = type;
+  rChange.destination = destination;
+  rChange.retransmitter = retransmitter;
+  rChange.interface = interface;
+  rChange.metric = metric;
+  rChange.lifetime = lifetime;
+  rChange.seqnum = seqnum;
+  m_routeChangeTraceSource (rChange);
+}
+void
+HwmpProtocol::NotifyRouteChangeBatch (RouteChangeType type, const std::vector<FailedDestination> &destinations)
+{
+  if (m_routeChangeBatchTraceSource.IsEmpty () || destinations.empty ())
+    {
+      return;
+    }
+  m_routeChangeBatchTraceSource (type, &destinations[0], destinations.size ());
+}
 void
 HwmpProtocol::ReactivePathResolved (Mac48Address dst)
 {
@@ -1147,6 +1827,14 @@ HwmpProtocol::ReactivePathResolved (Mac48Address dst)
     {
       m_routeDiscoveryTimeCallback (Simulator::Now () - i->second.whenScheduled);
     }
+  std::map<Mac48Address, LocalRepair>::iterator repair = m_localRepairs.find (dst);
+  if (repair != m_localRepairs.end ())
+    {
+      NS_LOG_DEBUG ("I am " << GetAddress () << ", repaired path to " << dst);
+      repair->second.timeout.Cancel ();
+      m_localRepairs.erase (repair);
+      m_stats.repairedPaths++;
+    }
 
   HwmpRtable::LookupResult result = m_rtable->LookupReactive (dst);
   NS_ASSERT (result.retransmitter != Mac48Address::GetBroadcast ());
@@ -1225,14 +1913,8 @@ HwmpProtocol::RetryPathDiscovery (Mac48Address dst, uint8_t numOfRetry)
     }
   if (numOfRetry > m_dot11MeshHWMPmaxPREQretries)
     {
-      QueuedPacket packet = DequeueFirstPacketByDst (dst);
       //purge queue and delete entry from retryDatabase
-      while (packet.pkt != 0)
-        {
-          m_stats.totalDropped++;
-          packet.reply (false, packet.pkt, packet.src, packet.dst, packet.protocol, HwmpRtable::MAX_METRIC);
-          packet = DequeueFirstPacketByDst (dst);
-        }
+      DropQueuedPackets (dst, DISCOVERY_FAILED);
       std::map<Mac48Address, PreqEvent>::iterator i = m_preqTimeouts.find (dst);
       NS_ASSERT (i != m_preqTimeouts.end ());
       m_routeDiscoveryTimeCallback (Simulator::Now () - i->second.whenScheduled);
@@ -1244,12 +1926,59 @@ HwmpProtocol::RetryPathDiscovery (Mac48Address dst, uint8_t numOfRetry)
   uint32_t dst_seqno = m_rtable->LookupReactiveExpired (dst).seqnum;
   for (HwmpProtocolMacMap::const_iterator i = m_interfaces.begin (); i != m_interfaces.end (); i++)
     {
-      i->second->RequestDestination (dst, originator_seqno, dst_seqno);
+      i->second->RequestDestination (dst, originator_seqno, dst_seqno, m_maxTtl);
     }
   m_preqTimeouts[dst].preqTimeout = Simulator::Schedule (
       Time ((2 * (numOfRetry + 1)) *  m_dot11MeshHWMPnetDiameterTraversalTime),
       &HwmpProtocol::RetryPathDiscovery, this, dst, numOfRetry);
 }
+void
+HwmpProtocol::StartLocalRepair (Mac48Address dst)
+{
+  NS_LOG_FUNCTION (this << dst);
+  if (m_localRepairs.find (dst) != m_localRepairs.end ())
+    {
+      return;
+    }
+  const HwmpRtable::ReactiveRoute * route = m_rtable->FindReactive (dst);
+  NS_ASSERT (route != 0);
+  //Most breaks are close to this node, the PREQ goes a little further than the destination was
+  uint32_t ttl = route->hopCount + m_localRepairTtlMargin;
+  if (ttl > m_maxTtl)
+    {
+      ttl = m_maxTtl;
+    }
+  NS_LOG_DEBUG ("I am " << GetAddress () << ", local repair of the path to " << dst
+                        << " through " << route->retransmitter << ", TTL " << ttl);
+  LocalRepair & repair = m_localRepairs[dst];
+  repair.brokenHop = route->retransmitter;
+  repair.timeout = Simulator::Schedule (m_localRepairTimeout, &HwmpProtocol::LocalRepairFailed, this, dst);
+  m_stats.initiatedLocalRepair++;
+  m_stats.initiatedPreq++;
+  uint32_t originator_seqno = GetNextHwmpSeqno ();
+  for (HwmpProtocolMacMap::const_iterator i = m_interfaces.begin (); i != m_interfaces.end (); i++)
+    {
+      i->second->RequestDestination (dst, originator_seqno, route->seqnum, ttl);
+    }
+}
+void
+HwmpProtocol::LocalRepairFailed (Mac48Address dst)
+{
+  NS_LOG_FUNCTION (this << dst);
+  std::map<Mac48Address, LocalRepair>::iterator repair = m_localRepairs.find (dst);
+  NS_ASSERT (repair != m_localRepairs.end ());
+  if (m_rtable->LookupReactive (dst).retransmitter != Mac48Address::GetBroadcast ())
+    {
+      ReactivePathResolved (dst);
+      return;
+    }
+  Mac48Address brokenHop = repair->second.brokenHop;
+  m_localRepairs.erase (repair);
+  NS_LOG_DEBUG ("I am " << GetAddress () << ", local repair of the path to " << dst << " failed");
+  DropQueuedPackets (dst, DISCOVERY_FAILED);
+  std::vector<FailedDestination> destinations = m_rtable->GetUnreachableDestinations (brokenHop);
+  InitiatePathError (MakePathError (std::move (destinations)));
+}
 //Proactive PREQ routines:
 void
 HwmpProtocol::SetRoot ()
@@ -1263,6 +1992,7 @@ HwmpProtocol::UnsetRoot ()
 {
   NS_LOG_FUNCTION (this);
   m_proactivePreqTimer.Cancel ();
+  m_rannTimer.Cancel ();
 }
 void
 HwmpProtocol::SendProactivePreq ()
@@ -1285,6 +2015,114 @@ HwmpProtocol::SendProactivePreq ()
     }
   m_proactivePreqTimer = Simulator::Schedule (m_dot11MeshHWMPpathToRootInterval, &HwmpProtocol::SendProactivePreq, this);
 }
+void
+HwmpProtocol::SendRann ()
+{
+  NS_LOG_FUNCTION (this);
+  IeRann rann;
+  rann.SetFlags (0);
+  rann.SetHopcount (0);
+  rann.SetTTL (m_maxTtl);
+  rann.SetOriginatorAddress (GetAddress ());
+  rann.SetDestSeqNumber (GetNextHwmpSeqno ());
+  rann.SetMetric (0);
+  m_stats.initiatedRann++;
+  for (HwmpProtocolMacMap::const_iterator i = m_interfaces.begin (); i != m_interfaces.end (); i++)
+    {
+      i->second->SendRann (rann);
+    }
+  m_rannTimer = Simulator::Schedule (m_dot11MeshHWMPrannInterval, &HwmpProtocol::SendRann, this);
+}
+void
+HwmpProtocol::ReceiveRann (IeRann & rann, Mac48Address from, uint32_t interface, uint32_t metric)
+{
+  if (m_etxMetric)
+    {
+      metric = m_nbEtx.GetEtxForNeighbor (from);
+    }
+  else if (m_hopCntMetric)
+    {
+      metric = 1;
+    }
+  NS_LOG_FUNCTION (this << from << interface << metric);
+  rann.IncrementMetric (metric);
+  Mac48Address root = rann.GetOriginatorAddress ();
+  //acceptance criteria: a fresher announcement, or a better metric for the same one
+  std::map<Mac48Address, RannState>::iterator i = m_rannRoots.find (root);
+  bool changed = true;
+  if (i != m_rannRoots.end ())
+    {
+      int32_t age = (int32_t)(rann.GetDestSeqNumber () - i->second.seqno);
+      if (age < 0 || (age == 0 && i->second.metric <= rann.GetMetric ()))
+        {
+          return;
+        }
+      changed = (i->second.metric != rann.GetMetric ()) || (i->second.retransmitter != from);
+    }
+  else
+    {
+      i = m_rannRoots.insert (std::make_pair (root, RannState ())).first;
+      i->second.preqSeqno = rann.GetDestSeqNumber () - 1;
+    }
+  RannState & state = i->second;
+  state.seqno = rann.GetDestSeqNumber ();
+  state.metric = rann.GetMetric ();
+  state.retransmitter = from;
+  state.interface = interface;
+  state.whenAccepted = Simulator::Now ();
+  NS_LOG_DEBUG ("I am " << GetAddress () << ", accepted RANN from " << root << " through " << from
+                        << ", metric " << state.metric);
+  for (HwmpProtocolMacMap::const_iterator j = m_interfaces.begin (); j != m_interfaces.end (); j++)
+    {
+      j->second->SendRann (rann);
+    }
+  //Only a node that sends to the root keeps its path fresh, once per announcement
+  if (state.lastUse.IsZero () || Simulator::Now () - state.lastUse > m_dot11MeshHWMPactivePathTimeout
+      || state.preqSeqno == state.seqno)
+    {
+      return;
+    }
+  HwmpRtable::LookupResult result = m_rtable->LookupReactive (root);
+  if (changed || result.retransmitter == Mac48Address::GetBroadcast ()
+      || result.lifetime < m_dot11MeshHWMPrannInterval)
+    {
+      SendRootPreq (root);
+    }
+}
+void
+HwmpProtocol::SendRootPreq (Mac48Address root)
+{
+  NS_LOG_FUNCTION (this << root);
+  std::map<Mac48Address, RannState>::iterator rann = m_rannRoots.find (root);
+  NS_ASSERT (rann != m_rannRoots.end ());
+  rann->second.preqSeqno = rann->second.seqno;
+  IePreq preq;
+  preq.SetHopcount (0);
+  preq.SetTTL (m_maxTtl);
+  preq.SetPreqID (GetNextPreqId ());
+  preq.SetOriginatorAddress (GetAddress ());
+  preq.SetOriginatorSeqNumber (GetNextHwmpSeqno ());
+  preq.SetLifetime (GetActivePathLifetime ());
+  //Only the root answers, so the reply carries the current metric
+  preq.AddDestinationAddressElement (true, false, root, m_rtable->LookupReactiveExpired (root).seqnum);
+  m_stats.initiatedPreq++;
+  m_stats.initiatedRootPreq++;
+  m_interfaces[rann->second.interface]->SendPreq (preq, rann->second.retransmitter);
+}
+const HwmpProtocol::RannState *
+HwmpProtocol::FindRann (Mac48Address root) const
+{
+  if (m_rannRoots.empty ())
+    {
+      return 0;
+    }
+  std::map<Mac48Address, RannState>::const_iterator i = m_rannRoots.find (root);
+  if (i == m_rannRoots.end () || Simulator::Now () - i->second.whenAccepted > m_dot11MeshHWMPrannInterval * 2)
+    {
+      return 0;
+    }
+  return &i->second;
+}
 bool
 HwmpProtocol::GetDoFlag ()
 {
@@ -1345,10 +2183,25 @@ HwmpProtocol::Statistics::Statistics () :
   droppedTtl (0),
   totalQueued (0),
   totalDropped (0),
+  droppedQueueFull (0),
+  droppedQueueTimeout (0),
   initiatedPreq (0),
   initiatedPrep (0),
   initiatedPerr (0),
-  initiatedLpp (0)
+  initiatedLpp (0),
+  failovers (0),
+  initiatedLocalRepair (0),
+  repairedPaths (0),
+  forwardedPreq (0),
+  suppressedPreq (0),
+  initiatedRann (0),
+  initiatedRootPreq (0)
+{
+}
+HwmpProtocol::SeqnoDatabase::SeqnoDatabase () :
+  nextWheelTag (0),
+  evictedExpired (0),
+  evictedOverflow (0)
 {
 }
 void HwmpProtocol::Statistics::Print (std::ostream & os) const
@@ -1360,10 +2213,19 @@ void HwmpProtocol::Statistics::Print (std::ostream & os) const
   "droppedTtl=\"" << droppedTtl << "\" "
   "totalQueued=\"" << totalQueued << "\" "
   "totalDropped=\"" << totalDropped << "\" "
+  "droppedQueueFull=\"" << droppedQueueFull << "\" "
+  "droppedQueueTimeout=\"" << droppedQueueTimeout << "\" "
   "initiatedPreq=\"" << initiatedPreq << "\" "
   "initiatedPrep=\"" << initiatedPrep << "\" "
   "initiatedPerr=\"" << initiatedPerr << "\" "
-  "initiatedLpp=\"" << initiatedLpp << "\"/>" << std::endl;
+  "initiatedLpp=\"" << initiatedLpp << "\" "
+  "failovers=\"" << failovers << "\" "
+  "initiatedLocalRepair=\"" << initiatedLocalRepair << "\" "
+  "repairedPaths=\"" << repairedPaths << "\" "
+  "forwardedPreq=\"" << forwardedPreq << "\" "
+  "suppressedPreq=\"" << suppressedPreq << "\" "
+  "initiatedRann=\"" << initiatedRann << "\" "
+  "initiatedRootPreq=\"" << initiatedRootPreq << "\"/>" << std::endl;
 }
 void
 HwmpProtocol::Report (std::ostream & os)
@@ -1371,6 +2233,9 @@ HwmpProtocol::Report (std::ostream & os)
   os << "<Hwmp "
   "address=\"" << m_address << "\"" << std::endl <<
   "maxQueueSize=\"" << m_maxQueueSize << "\"" << std::endl <<
+  "maxQueueBytes=\"" << m_maxQueueBytes << "\"" << std::endl <<
+  "maxQueueSizePerDestination=\"" << m_maxQueueSizePerDst << "\"" << std::endl <<
+  "maxQueueTime=\"" << m_maxQueueTime.GetSeconds () << "\"" << std::endl <<
   "Dot11MeshHWMPmaxPREQretries=\"" << (uint16_t)m_dot11MeshHWMPmaxPREQretries << "\"" << std::endl <<
   "Dot11MeshHWMPnetDiameterTraversalTime=\"" << m_dot11MeshHWMPnetDiameterTraversalTime.GetSeconds () << "\"" << std::endl <<
   "Dot11MeshHWMPpreqMinInterval=\"" << m_dot11MeshHWMPpreqMinInterval.GetSeconds () << "\"" << std::endl <<
@@ -1381,13 +2246,27 @@ HwmpProtocol::Report (std::ostream & os)
   "Dot11MeshHWMPpathToRootInterval=\"" << m_dot11MeshHWMPpathToRootInterval.GetSeconds () << "\"" << std::endl <<
   "Dot11MeshHWMPrannInterval=\"" << m_dot11MeshHWMPrannInterval.GetSeconds () << "\"" << std::endl <<
   "isRoot=\"" << m_isRoot << "\"" << std::endl <<
+  "rootAnnouncement=\"" << m_rootAnnouncement << "\"" << std::endl <<
   "maxTtl=\"" << (uint16_t)m_maxTtl << "\"" << std::endl <<
   "unicastPerrThreshold=\"" << (uint16_t)m_unicastPerrThreshold << "\"" << std::endl <<
   "unicastPreqThreshold=\"" << (uint16_t)m_unicastPreqThreshold << "\"" << std::endl <<
   "unicastDataThreshold=\"" << (uint16_t)m_unicastDataThreshold << "\"" << std::endl <<
   "doFlag=\"" << m_doFlag << "\"" << std::endl <<
-  "rfFlag=\"" << m_rfFlag << "\">" << std::endl;
+  "rfFlag=\"" << m_rfFlag << "\"" << std::endl <<
+  "multipathNextHops=\"" << m_multipathNextHops << "\"" << std::endl <<
+  "multipathFlowHashing=\"" << m_multipathFlowHashing << "\"" << std::endl <<
+  "localRepair=\"" << m_localRepair << "\"" << std::endl <<
+  "preqSuppression=\"" << m_preqSuppression << "\">" << std::endl;
   m_stats.Print (os);
+  m_lastDataSeqno.wheel.Advance ();
+  m_hwmpSeqnoMetricDatabase.wheel.Advance ();
+  os << "<SeqnoDatabases "
+  "dataSize=\"" << m_lastDataSeqno.entries.size () << "\" "
+  "dataEvictedExpired=\"" << m_lastDataSeqno.evictedExpired << "\" "
+  "dataEvictedOverflow=\"" << m_lastDataSeqno.evictedOverflow << "\" "
+  "hwmpSize=\"" << m_hwmpSeqnoMetricDatabase.entries.size () << "\" "
+  "hwmpEvictedExpired=\"" << m_hwmpSeqnoMetricDatabase.evictedExpired << "\" "
+  "hwmpEvictedOverflow=\"" << m_hwmpSeqnoMetricDatabase.evictedOverflow << "\"/>" << std::endl;
   m_nbEtx.Print (os);
   m_rtable->Print (os);
   for (HwmpProtocolMacMap::const_iterator plugin = m_interfaces.begin (); plugin != m_interfaces.end (); plugin++)
@@ -1424,7 +2303,8 @@ HwmpProtocol::GetRoutingTable (void) const
 HwmpProtocol::QueuedPacket::QueuedPacket () :
   pkt (0),
   protocol (0),
-  inInterface (0)
+  inInterface (0),
+  queueSeqno (0)
 {
 }
 } // namespace dot11s
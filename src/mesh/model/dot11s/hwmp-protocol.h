@@ -30,8 +30,21 @@
 #include "ns3/traced-value.h"
 #include <vector>
 #include <map>
+#include <list>
+#include <deque>
+#include <unordered_set>
 #include "hwmp-neighbor-etx.h"
+#include "ie-dot11s-preq.h"
 #include "ns3/vector.h"
+#include "ns3/mesh-timer-wheel.h"
+
+class HwmpPerrReceiversTest;
+class HwmpLppReassemblyTest;
+class HwmpPreqAllocationBenchmark;
+class HwmpQueueLimitsTest;
+class HwmpQueueTimeoutTest;
+class HwmpRannAcceptanceTest;
+class HwmpRannChainTest;
 
 namespace ns3 {
 class MeshPointDevice;
@@ -42,16 +55,47 @@ namespace dot11s {
 class HwmpProtocolMac;
 class HwmpRtable;
 class IePerr;
-class IePreq;
 class IePrep;
 class IeLpp;
+class IeRann;
 
+/**
+ * Kind of routing table change. The values are stable, droneMesh writes
+ * them to its binary traces.
+ */
+enum RouteChangeType
+{
+  ROUTE_CHANGE_UNKNOWN = 0,     ///< not set
+  ROUTE_CHANGE_ADD_REACTIVE,    ///< reactive path added or updated
+  ROUTE_CHANGE_ADD_PROACTIVE,   ///< proactive path added or updated
+  ROUTE_CHANGE_DELETE_REACTIVE, ///< reactive path deleted
+  ROUTE_CHANGE_DELETE_PROACTIVE ///< proactive path deleted
+};
+/**
+ * \param type the kind of change
+ * \returns the text used by earlier traces, e.g. "Add Reactive"
+ */
+std::string ToString (RouteChangeType type);
+/**
+ * \brief Stream insertion operator, prints ToString (type)
+ * \param os the output stream
+ * \param type the kind of change
+ * \returns the output stream
+ */
+std::ostream & operator<< (std::ostream &os, RouteChangeType type);
 /**
  * Structure to encapsulate route change information
  */
 struct RouteChange
 {
-  std::string type;             ///< type of change
+  RouteChange ()
+    : type (ROUTE_CHANGE_UNKNOWN),
+      interface (0),
+      metric (0),
+      seqnum (0)
+  {
+  }
+  RouteChangeType type;         ///< type of change
   Mac48Address destination;     ///< route destination
   Mac48Address retransmitter;   ///< route source
   uint32_t interface;           ///< interface index
@@ -162,9 +206,41 @@ public:
   /// ETX for neighbors
   NeighborEtx m_nbEtx;
 
+  /// Reason why a packet waiting for its routing information was dropped
+  enum QueueDropReason
+  {
+    QUEUE_OVERFLOW,        ///< the packet or byte budget of the queue is exhausted
+    DESTINATION_OVERFLOW,  ///< the destination already has MaxQueueSizePerDestination packets queued
+    QUEUE_TIMEOUT,         ///< the packet waited longer than MaxQueueTime
+    DISCOVERY_FAILED       ///< path discovery gave up on the destination
+  };
+  /**
+   * TracedCallback signature for packets dropped from the route discovery queue
+   *
+   * \param [in] packet the dropped packet
+   * \param [in] destination the destination the packet was waiting a route to
+   * \param [in] reason why the packet was dropped
+   */
+  typedef void (* QueueDropTracedCallback)
+    (Ptr<const Packet> packet, Mac48Address destination, QueueDropReason reason);
+
 private:
   /// allow HwmpProtocolMac class friend access
   friend class HwmpProtocolMac;
+  /// allow HwmpPerrReceiversTest class friend access
+  friend class ::HwmpPerrReceiversTest;
+  /// allow HwmpLppReassemblyTest class friend access
+  friend class ::HwmpLppReassemblyTest;
+  /// allow HwmpPreqAllocationBenchmark class friend access
+  friend class ::HwmpPreqAllocationBenchmark;
+  /// allow HwmpQueueLimitsTest class friend access
+  friend class ::HwmpQueueLimitsTest;
+  /// allow HwmpQueueTimeoutTest class friend access
+  friend class ::HwmpQueueTimeoutTest;
+  /// allow HwmpRannAcceptanceTest class friend access
+  friend class ::HwmpRannAcceptanceTest;
+  /// allow HwmpRannChainTest class friend access
+  friend class ::HwmpRannChainTest;
 
   virtual void DoInitialize ();
 
@@ -198,6 +274,8 @@ private:
     uint16_t protocol; ///< protocol number
     uint32_t inInterface; ///< incoming device interface ID. (if packet has come from upper layers, this is Mesh point ID)
     RouteReplyCallback reply; ///< how to reply
+    Time whenQueued; ///< when the packet entered the route discovery queue
+    uint64_t queueSeqno; ///< arrival order in the route discovery queue
 
     QueuedPacket ();
   };
@@ -222,32 +300,42 @@ private:
   /**
    * \brief Handler for receiving Path Request
    *
-   * \param preq the IE preq
+   * \param preq the IE preq, updated in place before being forwarded
    * \param from the from address
    * \param interface the interface
    * \param fromMp the 'from MP' address
    * \param metric the metric
    */
-  void ReceivePreq (IePreq preq, Mac48Address from, uint32_t interface, Mac48Address fromMp, uint32_t metric);
+  void ReceivePreq (IePreq & preq, Mac48Address from, uint32_t interface, Mac48Address fromMp, uint32_t metric);
   /**
    * \brief Handler for receiving Path Reply
    *
-   * \param prep the IE prep
+   * \param prep the IE prep, updated in place before being forwarded
    * \param from the from address
    * \param interface the interface
    * \param fromMp the 'from MP' address
    * \param metric the metric
    */
-  void ReceivePrep (IePrep prep, Mac48Address from, uint32_t interface, Mac48Address fromMp, uint32_t metric);
+  void ReceivePrep (IePrep & prep, Mac48Address from, uint32_t interface, Mac48Address fromMp, uint32_t metric);
   /**
    * \brief Handler for receiving Link Probe Packet
    *
-   * \param lpp the IE lpp
+   * \param lpp the IE lpp of the frame, one per part of the neighbor list it carries;
+   * the parts of a list sent in several frames are joined by LPP ID and originator seqno
    * \param from the from address
    * \param interface the interface
    * \param fromMp the 'from MP' address
    */
-  void ReceiveLpp(IeLpp lpp, Mac48Address from, uint32_t interface, Mac48Address fromMp);
+  void ReceiveLpp (const std::vector<Ptr<IeLpp> > & lpp, Mac48Address from, uint32_t interface, Mac48Address fromMp);
+  /**
+   * \brief Handler for receiving Root Announcement
+   *
+   * \param rann the IE rann, updated in place before being forwarded
+   * \param from the from address
+   * \param interface the interface
+   * \param metric the metric
+   */
+  void ReceiveRann (IeRann & rann, Mac48Address from, uint32_t interface, uint32_t metric);
   /**
    * \brief Handler for receiving Path Error
    *
@@ -256,7 +344,7 @@ private:
    * \param interface the interface
    * \param fromMp the from MP address
    */
-  void ReceivePerr (std::vector<FailedDestination> destinations, Mac48Address from, uint32_t interface, Mac48Address fromMp);
+  void ReceivePerr (const std::vector<FailedDestination> & destinations, Mac48Address from, uint32_t interface, Mac48Address fromMp);
    /**
     * \brief Send Path Reply
     * \param src the source address
@@ -285,7 +373,7 @@ private:
    * \brief forms a path error information element when list of destination fails on a given interface
    * \attention removes all entries from routing table!
    *
-   * \param destinations vector of failed destinations
+   * \param destinations vector of failed destinations, moved into the PathError
    * \return PathError
    */
   PathError MakePathError (std::vector<FailedDestination> destinations);
@@ -293,19 +381,19 @@ private:
    * \brief Forwards a received path error
    * \param perr the path error
    */
-  void ForwardPathError (PathError perr);
+  void ForwardPathError (const PathError & perr);
   /**
    * \brief Passes a self-generated PERR to interface-plugin
    * \param perr the path error
    */
-  void InitiatePathError (PathError perr);
+  void InitiatePathError (const PathError & perr);
   /**
    * Get PERR receivers
    *
    * \param failedDest
    * \return list of addresses where a PERR should be sent to
    */
-  std::vector<std::pair<uint32_t, Mac48Address> > GetPerrReceivers (std::vector<FailedDestination> failedDest);
+  std::vector<std::pair<uint32_t, Mac48Address> > GetPerrReceivers (const std::vector<FailedDestination> & failedDest);
 
   /**
    * Get PREQ receivers
@@ -336,10 +424,83 @@ private:
   typedef TracedCallback <struct RouteChange> RouteChangeTracedCallback;
   /// Route change trace source
   TracedCallback<struct RouteChange> m_routeChangeTraceSource;
+  /**
+   * TracedCallback signature for the paths deleted while handling a path error
+   *
+   * \param [in] type ROUTE_CHANGE_DELETE_REACTIVE or ROUTE_CHANGE_DELETE_PROACTIVE
+   * \param [in] destinations the first deleted destination and its sequence number
+   * \param [in] n the number of destinations
+   */
+  typedef void (* RouteChangeBatchTracedCallback)
+    (RouteChangeType type, const FailedDestination *destinations, uint32_t n);
+  /// Route change batch trace source
+  TracedCallback<RouteChangeType, const FailedDestination *, uint32_t> m_routeChangeBatchTraceSource;
+  /**
+   * Fire the route change trace source, if anything is connected to it
+   *
+   * \param type the kind of change
+   * \param destination the route destination
+   * \param retransmitter the next hop
+   * \param interface the interface index
+   * \param metric the metric of the route
+   * \param lifetime the lifetime of the route
+   * \param seqnum the sequence number of the route
+   */
+  void NotifyRouteChange (RouteChangeType type, Mac48Address destination, Mac48Address retransmitter,
+                          uint32_t interface, uint32_t metric, Time lifetime, uint32_t seqnum);
+  /**
+   * Fire the route change batch trace source, if anything is connected to it
+   *
+   * \param type the kind of change
+   * \param destinations the deleted destinations
+   */
+  void NotifyRouteChangeBatch (RouteChangeType type, const std::vector<FailedDestination> &destinations);
+  /**
+   * Count and trace a reactive path that moved to an alternative next hop
+   * \param destination the destination of the path
+   */
+  void NotifyFailOver (Mac48Address destination);
+  /**
+   * Trace a change of the ETX of a neighbor
+   * \param neighbor the neighbor
+   * \param oldEtx the previous ETX
+   * \param newEtx the new ETX
+   */
+  void NotifyEtxChange (Mac48Address neighbor, uint32_t oldEtx, uint32_t newEtx);
+  /**
+   * \param source the source address
+   * \param destination the destination address
+   * \param protocolType the protocol type
+   * \returns the hash of the flow, used to spread flows over next hops
+   */
+  static uint32_t GetFlowHash (Mac48Address source, Mac48Address destination, uint16_t protocolType);
+  /// Route discovery queue drop trace source
+  TracedCallback<Ptr<const Packet>, Mac48Address, QueueDropReason> m_queueDropTrace;
+  /**
+   * TracedCallback signature for ETX changes of a neighbor
+   *
+   * \param [in] neighbor the neighbor
+   * \param [in] oldEtx the previous ETX
+   * \param [in] newEtx the new ETX, the ETX of unknown neighbors if the neighbor was removed
+   */
+  typedef void (* EtxChangeTracedCallback)
+    (Mac48Address neighbor, uint32_t oldEtx, uint32_t newEtx);
+  /// Neighbor ETX change trace source
+  TracedCallback<Mac48Address, uint32_t, uint32_t> m_etxChangeTrace;
   ///\name Methods related to Queue/Dequeue procedures
   ///\{
+  /**
+   * Append a packet to the queue of its destination
+   * \param packet the packet waiting for a route
+   * \returns false if the packet does not fit in the queue
+   */
   bool QueuePacket (QueuedPacket packet);
+  /**
+   * \param dst the destination
+   * \returns the oldest packet queued for dst, a packet with a null pkt if none
+   */
   QueuedPacket  DequeueFirstPacketByDst (Mac48Address dst);
+  /// \returns the oldest queued packet, a packet with a null pkt if none
   QueuedPacket  DequeueFirstPacket ();
   void ReactivePathResolved (Mac48Address dst);
   void ProactivePathResolved ();
@@ -363,8 +524,51 @@ private:
    * When PREQ retry has achieved the maximum level - retry mechanism should be canceled
    */
   void  RetryPathDiscovery (Mac48Address dst, uint8_t numOfRetry);
+  /**
+   * \brief Look for a broken path near this node with a TTL limited PREQ
+   * \param dst is the destination of an expired path, its hop count bounds the TTL
+   *
+   * Packets for the destination are queued meanwhile, nothing is done if
+   * a repair of the destination is already running
+   */
+  void StartLocalRepair (Mac48Address dst);
+  /**
+   * \brief Drop the packets of a local repair that found no path in time
+   * and send the path error it held back
+   * \param dst is the destination address
+   */
+  void LocalRepairFailed (Mac48Address dst);
   /// Proactive Preq routines:
   void SendProactivePreq ();
+  /// Flood a root announcement and schedule the next one
+  void SendRann ();
+  /**
+   * \brief Send an individually addressed PREQ to an announced root,
+   * towards the neighbor its announcement came from
+   * \param root the root address
+   */
+  void SendRootPreq (Mac48Address root);
+  ///\}
+  ///\name PREQ suppression
+  ///\{
+  /**
+   * \brief Forward an accepted PREQ after a random jitter, unless suppressed meanwhile
+   * \param preq the PREQ to forward
+   * \param from the neighbor it was received from
+   */
+  void SchedulePreqForward (const IePreq & preq, Mac48Address from);
+  /**
+   * \brief Count a copy of a PREQ waiting to be forwarded
+   * \param preq the copy, not accepted
+   * \param from the neighbor that forwarded it
+   * \param advertisedMetric the metric of that neighbor to the originator
+   */
+  void OverhearPreq (const IePreq & preq, Mac48Address from, uint32_t advertisedMetric);
+  /**
+   * \brief Forward or suppress the PREQ of an originator once its jitter is over
+   * \param originator the originator of the PREQ
+   */
+  void ForwardPendingPreq (Mac48Address originator);
   ///\}
   ///\return address of MeshPointDevice
   Mac48Address GetAddress ();
@@ -415,6 +619,12 @@ private:
    */
   uint8_t GetUnicastPerrThreshold ();
 private:
+  /**
+   * \param destination a destination
+   * \param metric the metric of a new path to destination
+   * \returns true if there is no valid reactive path to destination or its metric is worse
+   */
+  bool IsBetterReactivePath (Mac48Address destination, uint32_t metric) const;
   /// Statistics structure
   struct Statistics
   {
@@ -424,10 +634,19 @@ private:
     uint16_t droppedTtl; ///< dropped TTL
     uint16_t totalQueued; ///< total queued
     uint16_t totalDropped; ///< total dropped
+    uint16_t droppedQueueFull; ///< dropped because the route discovery queue was full
+    uint16_t droppedQueueTimeout; ///< dropped after waiting MaxQueueTime for a route
     uint16_t initiatedPreq; ///< initiated PREQ
     uint16_t initiatedPrep; ///< initiated PREP
     uint16_t initiatedPerr; ///< initiated PERR
     uint16_t initiatedLpp; ///< initiated LPP
+    uint16_t failovers; ///< reactive paths moved to an alternative next hop
+    uint16_t initiatedLocalRepair; ///< local repairs started
+    uint16_t repairedPaths; ///< local repairs that found a path
+    uint16_t forwardedPreq; ///< PREQs of other nodes forwarded
+    uint16_t suppressedPreq; ///< PREQs of other nodes not forwarded by PreqSuppression
+    uint16_t initiatedRann; ///< initiated RANN
+    uint16_t initiatedRootPreq; ///< PREQs sent to an announced root
 
     /**
      * Print function
@@ -446,10 +665,70 @@ private:
   uint32_t m_preqId; ///< PREQ ID
   ///\name Sequence number filters
   ///\{
+  /// Entry of a sequence number database
+  struct SeqnoEntry
+  {
+    uint32_t seqno; ///< last sequence number
+    uint32_t metric; ///< HWMP metric of the last accepted PREQ or PREP, unused for data
+    Time lastUpdate; ///< when the entry was last written
+    uint32_t wheelTag; ///< tag of the entry in the expiry wheel
+    std::list<Mac48Address>::iterator lruPosition; ///< position of the entry in SeqnoDatabase::lru
+  };
+  /// Sequence number database, entries not written for a while are evicted
+  struct SeqnoDatabase
+  {
+    SeqnoDatabase ();
+    std::map<Mac48Address, SeqnoEntry> entries; ///< entries by address
+    std::list<Mac48Address> lru; ///< addresses of the entries, least recently written first
+    MeshTimerWheel wheel; ///< expiry of the entries
+    uint32_t nextWheelTag; ///< wheel tag of the next new entry
+    uint32_t evictedExpired; ///< entries evicted because of their age
+    uint32_t evictedOverflow; ///< entries evicted because the database was full
+  };
+  /**
+   * \param db a sequence number database
+   * \param address the address
+   * \returns the entry of address, 0 if there is none
+   */
+  const SeqnoEntry * FindSeqno (SeqnoDatabase & db, Mac48Address address);
+  /**
+   * Write the entry of an address, creating it if needed
+   * \param db a sequence number database
+   * \param timeout age limit of the entries of db, 0 for none
+   * \param maxSize size limit of db, 0 for none
+   * \param address the address
+   * \param seqno the sequence number
+   * \param metric the metric
+   */
+  void WriteSeqno (SeqnoDatabase & db, Time timeout, uint32_t maxSize, Mac48Address address,
+                   uint32_t seqno, uint32_t metric);
+  /**
+   * Expiry callback of the wheel of a sequence number database
+   * \param db the database
+   * \param timeout age limit of the entries of db, 0 for none
+   * \param key the address key
+   * \param tag the wheel tag of the entry
+   * \returns the time the entry becomes stale, or now if it was evicted
+   */
+  Time ExpireSeqno (SeqnoDatabase & db, Time timeout, uint64_t key, uint32_t tag);
+  /**
+   * Expiry callback of m_lastDataSeqno
+   * \param key the address key
+   * \param tag the wheel tag of the entry
+   * \returns see ExpireSeqno
+   */
+  Time ExpireDataSeqno (uint64_t key, uint32_t tag);
+  /**
+   * Expiry callback of m_hwmpSeqnoMetricDatabase
+   * \param key the address key
+   * \param tag the wheel tag of the entry
+   * \returns see ExpireSeqno
+   */
+  Time ExpireHwmpSeqno (uint64_t key, uint32_t tag);
   /// Data sequence number database
-  std::map<Mac48Address, uint32_t> m_lastDataSeqno;
-  /// keeps HWMP seqno (first in pair) and HWMP metric (second in pair) for each address
-  std::map<Mac48Address, std::pair<uint32_t, uint32_t> > m_hwmpSeqnoMetricDatabase;
+  SeqnoDatabase m_lastDataSeqno;
+  /// keeps HWMP seqno and HWMP metric for each address
+  SeqnoDatabase m_hwmpSeqnoMetricDatabase;
   ///\}
 
   /// Routing table
@@ -462,20 +741,113 @@ private:
   };
 
   std::map<Mac48Address, PreqEvent> m_preqTimeouts; ///< PREQ timeouts
+  /// Local repair in progress
+  struct LocalRepair {
+    EventId timeout; ///< gives up the repair
+    Mac48Address brokenHop; ///< next hop of the broken path
+  };
+  std::map<Mac48Address, LocalRepair> m_localRepairs; ///< local repairs by destination
+  /// PREQ waiting for its jitter to be forwarded
+  struct PendingPreq {
+    IePreq preq; ///< the PREQ, as it will be forwarded
+    EventId timer; ///< forwards or suppresses it
+    uint32_t copies; ///< copies heard with an equal or better metric
+    std::unordered_set<uint64_t> heardFrom; ///< neighbors that forwarded it, as MeshTimerWheel keys
+  };
+  std::map<Mac48Address, PendingPreq> m_pendingPreqs; ///< PREQs waiting, by originator
   EventId m_proactivePreqTimer; ///< proactive PREQ timer
+  EventId m_rannTimer; ///< root announcement timer
+  /// Last root announcement accepted from a root
+  struct RannState {
+    uint32_t seqno; ///< sequence number of the announcement
+    uint32_t metric; ///< metric to the root through retransmitter
+    Mac48Address retransmitter; ///< neighbor the announcement came from, next hop towards the root
+    uint32_t interface; ///< interface of the retransmitter
+    Time whenAccepted; ///< when the announcement was accepted
+    Time lastUse; ///< when a packet was last forwarded to the root, zero if never
+    uint32_t preqSeqno; ///< announcement the last PREQ to the root was sent for
+  };
+  std::map<Mac48Address, RannState> m_rannRoots; ///< announcements by root
+  /**
+   * \param root the root address
+   * \returns the announcement of the root, 0 if none was accepted within
+   * two announcement intervals
+   */
+  const RannState * FindRann (Mac48Address root) const;
   /// Random start in Proactive PREQ propagation
   Time m_randomStart;
 
   EventId m_lppTimer; ///< LPP timer
   /// Random start in LPP propagation
   Time m_lppRandomStart;
-  /// Packet Queue
-  std::vector<QueuedPacket> m_rqueue;
+  /// LPP elements reused every period, one per part of the neighbor list
+  std::vector<IeLpp> m_lpp;
+  /// Parts received of a neighbor list sent in several frames
+  struct LppParts
+  {
+    uint8_t lppId; ///< LPP ID of the list
+    uint32_t seqno; ///< originator sequence number of the list
+    uint8_t count; ///< number of parts of the list
+    uint32_t received; ///< bit i set when part i was received
+    uint8_t lppReverse; ///< LPP count reported for this node, 0 if not found yet
+  };
+  std::map<Mac48Address, LppParts> m_lppParts; ///< incomplete neighbor list by originator
+  /// FIFO of packets waiting for a route, per destination
+  typedef std::map<Mac48Address, std::deque<QueuedPacket> > RouteQueue;
+  /**
+   * Remove the packet at the head of a destination FIFO, the FIFO itself
+   * is removed when it becomes empty
+   * \param fifo the destination FIFO
+   * \returns the packet
+   */
+  QueuedPacket PopQueuedPacket (RouteQueue::iterator fifo);
+  /**
+   * \param dst the destination of a packet
+   * \param seqno the queue sequence number of the packet
+   * \returns the FIFO of dst if the packet is still queued, m_rqueue.end () otherwise
+   */
+  RouteQueue::iterator FindQueuedPacket (Mac48Address dst, uint64_t seqno);
+  /**
+   * Drop the packets that waited longer than MaxQueueTime and the arrival
+   * order entries of packets already dequeued, from the head of m_rqueueOrder.
+   * Called before every queue operation, and by m_rqueuePurgeEvent once the
+   * oldest queued packet waited longer than MaxQueueTime, so packets are
+   * dropped on time even if the queue is not used anymore.
+   */
+  void PurgeExpiredPackets ();
+  /**
+   * Drop a packet taken out of the queue and tell its sender
+   * \param packet the packet
+   * \param reason why it is dropped
+   */
+  void DropQueuedPacket (QueuedPacket packet, QueueDropReason reason);
+  /**
+   * Drop all the packets queued for a destination
+   * \param dst the destination
+   * \param reason why they are dropped
+   */
+  void DropQueuedPackets (Mac48Address dst, QueueDropReason reason);
+
+  /// Packets waiting for a route
+  RouteQueue m_rqueue;
+  /**
+   * Destination and queue sequence number of the queued packets in arrival
+   * order. Entries of packets dequeued by destination are skipped when they
+   * reach the head, or compacted once they outnumber the queued packets.
+   */
+  std::deque<std::pair<Mac48Address, uint64_t> > m_rqueueOrder;
+  uint32_t m_rqueuePackets; ///< number of packets in m_rqueue
+  uint32_t m_rqueueBytes; ///< bytes in m_rqueue
+  uint64_t m_rqueueSeqno; ///< queue sequence number of the next queued packet
+  EventId m_rqueuePurgeEvent; ///< purges the queue when its oldest packet exceeds MaxQueueTime
 
   /// \name HWMP-protocol parameters
   /// These are all Attributes
   /// \{
   uint16_t m_maxQueueSize;
+  uint32_t m_maxQueueBytes;
+  uint16_t m_maxQueueSizePerDst;
+  Time m_maxQueueTime;
   uint8_t m_dot11MeshHWMPmaxPREQretries;
   Time m_dot11MeshHWMPnetDiameterTraversalTime;
   Time m_dot11MeshHWMPpreqMinInterval;
@@ -486,6 +858,7 @@ private:
   Time m_dot11MeshHWMPpathToRootInterval;
   Time m_dot11MeshHWMPrannInterval;
   bool m_isRoot;
+  bool m_rootAnnouncement; ///< a root floods RANNs instead of proactive PREQs
   uint8_t m_maxTtl;
   uint8_t m_unicastPerrThreshold;
   uint8_t m_unicastPreqThreshold;
@@ -498,6 +871,37 @@ private:
   bool m_enableLpp;
   bool m_hopCntMetric;
   bool m_useGeoInfo;
+
+  // Limits of the state tables, see HwmpRtable for the routing table
+  Time m_dataSeqnoTimeout;
+  uint32_t m_dataSeqnoMaxSize;
+  Time m_hwmpSeqnoTimeout;
+  uint32_t m_hwmpSeqnoMaxSize;
+  Time m_neighborEtxTimeout;
+  uint32_t m_neighborEtxMaxSize;
+  uint32_t m_etxWindow; ///< LPP periods of the ETX window
+  ///\}
+
+  ///\name Multipath
+  ///\{
+  uint32_t m_multipathNextHops; ///< next hops kept per reactive route, 1 for a single path
+  bool m_multipathFlowHashing; ///< spread flows over near equal cost next hops
+  double m_multipathTolerance; ///< relative metric difference of near equal cost next hops
+  ///\}
+
+  ///\name Local repair
+  ///\{
+  bool m_localRepair; ///< repair broken paths before sending a path error
+  uint8_t m_localRepairTtlMargin; ///< hops added to the hop count of the broken path
+  Time m_localRepairTimeout; ///< time given to a local repair
+  ///\}
+
+  ///\name PREQ suppression
+  ///\{
+  bool m_preqSuppression; ///< forward PREQs after a jitter, unless suppressed
+  Time m_preqSuppressionJitter; ///< most time a PREQ waits
+  uint32_t m_preqSuppressionThreshold; ///< copies that suppress a PREQ, 0 to disable
+  bool m_preqSuppressionCoverage; ///< suppress PREQs every peer already has
   ///\}
 
   /// Random variable for random start time
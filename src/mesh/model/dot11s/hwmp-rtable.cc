@@ -23,6 +23,8 @@
 #include "ns3/simulator.h"
 #include "ns3/test.h"
 #include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
 
 #include "hwmp-rtable.h"
 
@@ -40,12 +42,37 @@ HwmpRtable::GetTypeId ()
   static TypeId tid = TypeId ("ns3::dot11s::HwmpRtable")
     .SetParent<Object> ()
     .SetGroupName ("Mesh")
-    .AddConstructor<HwmpRtable> ();
+    .AddConstructor<HwmpRtable> ()
+    .AddAttribute ( "MaxExpiredAge",
+                    "How long an expired reactive route is kept for path errors and destination "
+                    "sequence numbers before it is evicted (0 keeps it until a PERR removes it)",
+                    TimeValue (Seconds (0)),
+                    MakeTimeAccessor (
+                      &HwmpRtable::m_maxExpiredAge),
+                    MakeTimeChecker ()
+                    )
+    .AddAttribute ( "MaxSize",
+                    "Maximum number of reactive routes, the route expiring first is evicted "
+                    "to make room for a new one (0 means no limit)",
+                    UintegerValue (0),
+                    MakeUintegerAccessor (
+                      &HwmpRtable::m_maxRoutes),
+                    MakeUintegerChecker<uint32_t> ()
+                    )
+  ;
   return tid;
 }
 HwmpRtable::HwmpRtable ()
+  : m_nRoutes (0),
+    m_nextWheelTag (0),
+    m_maxExpiredAge (Seconds (0)),
+    m_maxRoutes (0),
+    m_evictedExpired (0),
+    m_evictedOverflow (0),
+    m_maxAlternatives (0)
 {
   DeleteProactivePath ();
+  m_wheel.SetExpiryCallback (MakeCallback (&HwmpRtable::ExpireRoute, this));
 }
 HwmpRtable::~HwmpRtable ()
 {
@@ -53,26 +80,314 @@ HwmpRtable::~HwmpRtable ()
 void
 HwmpRtable::DoDispose ()
 {
-  m_routes.clear ();
+  m_slots.clear ();
+  m_nRoutes = 0;
+  m_wheel.Clear ();
+}
+uint64_t
+HwmpRtable::GetKey (Mac48Address address)
+{
+  return MeshTimerWheel::GetKey (address);
+}
+Time
+HwmpRtable::ExpireRoute (uint64_t key, uint32_t tag)
+{
+  uint32_t slot = FindSlot (key);
+  if (slot == m_slots.size () || m_slots[slot].route.wheelTag != tag || m_maxExpiredAge.IsZero ()
+      || m_slots[slot].route.whenExpire == Seconds (0))
+    {
+      return Simulator::Now ();
+    }
+  Time deadline = m_slots[slot].route.whenExpire + m_maxExpiredAge;
+  if (deadline > Simulator::Now ())
+    {
+      return deadline;
+    }
+  NS_LOG_DEBUG ("Evicting reactive route to " << m_slots[slot].route.destination);
+  EraseSlot (slot);
+  m_evictedExpired++;
+  return Simulator::Now ();
+}
+bool
+HwmpRtable::PromoteAlternative (ReactiveRoute & route)
+{
+  for (uint32_t i = 0; i < route.nAlternatives; i++)
+    {
+      const NextHop & nextHop = route.alternatives[i];
+      if (nextHop.whenExpire >= Simulator::Now ())
+        {
+          route.retransmitter = nextHop.retransmitter;
+          route.interface = nextHop.interface;
+          route.metric = nextHop.metric;
+          route.advertisedMetric = nextHop.advertisedMetric;
+          route.whenExpire = nextHop.whenExpire;
+          // The expired alternatives before it are worse than nothing
+          std::copy (route.alternatives + i + 1, route.alternatives + route.nAlternatives, route.alternatives);
+          route.nAlternatives -= i + 1;
+          return true;
+        }
+    }
+  return false;
+}
+void
+HwmpRtable::RemoveAlternative (ReactiveRoute & route, Mac48Address retransmitter)
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < route.nAlternatives; i++)
+    {
+      if (route.alternatives[i].retransmitter != retransmitter)
+        {
+          route.alternatives[n++] = route.alternatives[i];
+        }
+    }
+  route.nAlternatives = n;
+}
+bool
+HwmpRtable::InsertAlternative (ReactiveRoute & route, const NextHop & nextHop, uint32_t maxAlternatives)
+{
+  uint32_t i = 0;
+  while (i < route.nAlternatives && route.alternatives[i].metric <= nextHop.metric)
+    {
+      i++;
+    }
+  if (i >= maxAlternatives)
+    {
+      return false;
+    }
+  if (route.nAlternatives == maxAlternatives)
+    {
+      route.nAlternatives--;
+    }
+  std::copy_backward (route.alternatives + i, route.alternatives + route.nAlternatives,
+                      route.alternatives + route.nAlternatives + 1);
+  route.alternatives[i] = nextHop;
+  route.nAlternatives++;
+  return true;
+}
+void
+HwmpRtable::EvictOldestRoute ()
+{
+  uint32_t oldest = m_slots.size ();
+  for (uint32_t slot = 0; slot < m_slots.size (); slot++)
+    {
+      if (m_slots[slot].key != EMPTY_KEY
+          && (oldest == m_slots.size () || m_slots[slot].route.whenExpire < m_slots[oldest].route.whenExpire))
+        {
+          oldest = slot;
+        }
+    }
+  if (oldest != m_slots.size ())
+    {
+      NS_LOG_DEBUG ("Routing table full, evicting reactive route to " << m_slots[oldest].route.destination);
+      EraseSlot (oldest);
+      m_evictedOverflow++;
+    }
+}
+uint32_t
+HwmpRtable::GetHome (uint64_t key) const
+{
+  // Fibonacci hashing spreads the sequential addresses of ns-3 nodes
+  return (key * 0x9E3779B97F4A7C15ULL) >> 32 & (m_slots.size () - 1);
+}
+uint32_t
+HwmpRtable::FindSlot (uint64_t key) const
+{
+  if (m_nRoutes == 0)
+    {
+      return m_slots.size ();
+    }
+  for (uint32_t slot = GetHome (key); ; slot = (slot + 1) & (m_slots.size () - 1))
+    {
+      if (m_slots[slot].key == key)
+        {
+          return slot;
+        }
+      if (m_slots[slot].key == EMPTY_KEY)
+        {
+          return m_slots.size ();
+        }
+    }
+}
+uint32_t
+HwmpRtable::InsertSlot (uint64_t key)
+{
+  uint32_t slot = FindSlot (key);
+  if (slot != m_slots.size ())
+    {
+      return slot;
+    }
+  if (2 * (m_nRoutes + 1) > m_slots.size ())
+    {
+      std::vector<Slot> slots (std::max<size_t> (16, 2 * m_slots.size ()));
+      for (std::vector<Slot>::iterator i = slots.begin (); i != slots.end (); i++)
+        {
+          i->key = EMPTY_KEY;
+        }
+      m_slots.swap (slots);
+      for (std::vector<Slot>::const_iterator i = slots.begin (); i != slots.end (); i++)
+        {
+          if (i->key != EMPTY_KEY)
+            {
+              uint32_t home = GetHome (i->key);
+              while (m_slots[home].key != EMPTY_KEY)
+                {
+                  home = (home + 1) & (m_slots.size () - 1);
+                }
+              m_slots[home] = *i;
+            }
+        }
+    }
+  for (slot = GetHome (key); m_slots[slot].key != EMPTY_KEY; slot = (slot + 1) & (m_slots.size () - 1))
+    {
+    }
+  m_slots[slot].key = key;
+  m_slots[slot].route = ReactiveRoute ();
+  m_nRoutes++;
+  return slot;
+}
+void
+HwmpRtable::EraseSlot (uint32_t slot)
+{
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t next = (slot + 1) & mask;
+  while (m_slots[next].key != EMPTY_KEY)
+    {
+      // Move the entry back if the hole lies between its home and its slot
+      uint32_t home = GetHome (m_slots[next].key);
+      if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+          m_slots[slot] = m_slots[next];
+          slot = next;
+        }
+      next = (next + 1) & mask;
+    }
+  m_slots[slot].key = EMPTY_KEY;
+  m_slots[slot].route = ReactiveRoute ();
+  m_nRoutes--;
+}
+std::vector<uint32_t>
+HwmpRtable::GetSortedSlots () const
+{
+  std::vector<std::pair<uint64_t, uint32_t> > keys;
+  keys.reserve (m_nRoutes);
+  for (uint32_t slot = 0; slot < m_slots.size (); slot++)
+    {
+      if (m_slots[slot].key != EMPTY_KEY)
+        {
+          keys.push_back (std::make_pair (m_slots[slot].key, slot));
+        }
+    }
+  std::sort (keys.begin (), keys.end ());
+  std::vector<uint32_t> retval;
+  retval.reserve (keys.size ());
+  for (std::vector<std::pair<uint64_t, uint32_t> >::const_iterator i = keys.begin (); i != keys.end (); i++)
+    {
+      retval.push_back (i->second);
+    }
+  return retval;
+}
+void
+HwmpRtable::SetMaxAlternatives (uint32_t maxAlternatives)
+{
+  m_maxAlternatives = (maxAlternatives < MAX_ALTERNATIVES) ? maxAlternatives : MAX_ALTERNATIVES;
 }
 void
 HwmpRtable::AddReactivePath (Mac48Address destination, Mac48Address retransmitter, uint32_t interface,
-                             uint32_t metric, Time lifetime, uint32_t seqnum)
+                             uint32_t metric, Time lifetime, uint32_t seqnum, uint32_t advertisedMetric,
+                             uint8_t hopCount)
 {
   NS_LOG_FUNCTION (this << destination << retransmitter << interface << metric << lifetime.GetSeconds () << seqnum);
-  std::map<Mac48Address, ReactiveRoute>::iterator i = m_routes.find (destination);
-  if (i == m_routes.end ())
+  m_wheel.Advance ();
+  uint64_t key = GetKey (destination);
+  bool isNew = (FindSlot (key) == m_slots.size ());
+  if (isNew && m_maxRoutes > 0 && m_nRoutes >= m_maxRoutes)
+    {
+      EvictOldestRoute ();
+    }
+  ReactiveRoute & route = m_slots[InsertSlot (key)].route;
+  if (isNew)
+    {
+      route.wheelTag = m_nextWheelTag++;
+      if (!m_maxExpiredAge.IsZero ())
+        {
+          // Refreshing the route later only moves the deadline forward, the
+          // wheel finds out when this one passes
+          m_wheel.Schedule (key, route.wheelTag, Simulator::Now () + lifetime + m_maxExpiredAge);
+        }
+    }
+  NextHop previous;
+  bool keepPrevious = false;
+  if (!isNew && m_maxAlternatives > 0)
     {
-      ReactiveRoute newroute;
-      m_routes[destination] = newroute;
+      if (route.seqnum != seqnum)
+        {
+          route.nAlternatives = 0;
+        }
+      else if (route.retransmitter != retransmitter && !route.IsExpired ())
+        {
+          previous.retransmitter = route.retransmitter;
+          previous.interface = route.interface;
+          previous.metric = route.metric;
+          previous.advertisedMetric = route.advertisedMetric;
+          previous.whenExpire = route.whenExpire;
+          keepPrevious = true;
+        }
+    }
+  route.destination = destination;
+  route.retransmitter = retransmitter;
+  route.interface = interface;
+  route.metric = metric;
+  route.advertisedMetric = advertisedMetric;
+  route.whenExpire = Simulator::Now () + lifetime;
+  route.seqnum = seqnum;
+  route.hopCount = hopCount;
+  if (route.nAlternatives > 0 || keepPrevious)
+    {
+      // Alternatives must stay closer to the destination than this node
+      uint32_t n = 0;
+      for (uint32_t i = 0; i < route.nAlternatives; i++)
+        {
+          if (route.alternatives[i].retransmitter != retransmitter && route.alternatives[i].advertisedMetric < metric)
+            {
+              route.alternatives[n++] = route.alternatives[i];
+            }
+        }
+      route.nAlternatives = n;
+      if (keepPrevious && previous.advertisedMetric < metric)
+        {
+          RemoveAlternative (route, previous.retransmitter);
+          InsertAlternative (route, previous, m_maxAlternatives);
+        }
     }
-  i = m_routes.find (destination);
-  NS_ASSERT (i != m_routes.end ());
-  i->second.retransmitter = retransmitter;
-  i->second.interface = interface;
-  i->second.metric = metric;
-  i->second.whenExpire = Simulator::Now () + lifetime;
-  i->second.seqnum = seqnum;
+}
+bool
+HwmpRtable::AddAlternativePath (Mac48Address destination, Mac48Address retransmitter, uint32_t interface,
+                                uint32_t metric, uint32_t advertisedMetric, Time lifetime, uint32_t seqnum)
+{
+  NS_LOG_FUNCTION (this << destination << retransmitter << interface << metric << advertisedMetric << seqnum);
+  if (m_maxAlternatives == 0)
+    {
+      return false;
+    }
+  uint32_t slot = FindSlot (GetKey (destination));
+  if (slot == m_slots.size ())
+    {
+      return false;
+    }
+  ReactiveRoute & route = m_slots[slot].route;
+  if (route.seqnum != seqnum || route.IsExpired () || route.retransmitter == retransmitter
+      || advertisedMetric >= route.metric)
+    {
+      return false;
+    }
+  NextHop nextHop;
+  nextHop.retransmitter = retransmitter;
+  nextHop.interface = interface;
+  nextHop.metric = metric;
+  nextHop.advertisedMetric = advertisedMetric;
+  nextHop.whenExpire = Simulator::Now () + lifetime;
+  RemoveAlternative (route, retransmitter);
+  return InsertAlternative (route, nextHop, m_maxAlternatives);
 }
 void
 HwmpRtable::AddProactivePath (uint32_t metric, Mac48Address root, Mac48Address retransmitter,
@@ -95,24 +410,25 @@ HwmpRtable::AddPrecursor (Mac48Address destination, uint32_t precursorInterface,
   precursor.interface = precursorInterface;
   precursor.address = precursorAddress;
   precursor.whenExpire = Simulator::Now () + lifetime;
-  std::map<Mac48Address, ReactiveRoute>::iterator i = m_routes.find (destination);
-  if (i != m_routes.end ())
+  uint32_t slot = FindSlot (GetKey (destination));
+  if (slot != m_slots.size ())
     {
+      Precursors & precursors = m_slots[slot].route.precursors;
       bool should_add = true;
-      for (unsigned int j = 0; j < i->second.precursors.size (); j++)
+      for (uint32_t j = 0; j < precursors.GetN (); j++)
         {
           //NB: Only one active route may exist, so do not check
           //interface ID, just address
-          if (i->second.precursors[j].address == precursorAddress)
+          if (precursors.Get (j).address == precursorAddress)
             {
               should_add = false;
-              i->second.precursors[j].whenExpire = precursor.whenExpire;
+              precursors.Get (j).whenExpire = precursor.whenExpire;
               break;
             }
         }
       if (should_add)
         {
-          i->second.precursors.push_back (precursor);
+          precursors.Add (precursor);
         }
     }
 }
@@ -120,7 +436,7 @@ void
 HwmpRtable::DeleteProactivePath ()
 {
   NS_LOG_FUNCTION (this);
-  m_root.precursors.clear ();
+  m_root.precursors.Clear ();
   m_root.interface = INTERFACE_ANY;
   m_root.metric = MAX_METRIC;
   m_root.retransmitter = Mac48Address::GetBroadcast ();
@@ -140,40 +456,51 @@ void
 HwmpRtable::DeleteReactivePath (Mac48Address destination)
 {
   NS_LOG_FUNCTION (this << destination);
-  std::map<Mac48Address, ReactiveRoute>::iterator i = m_routes.find (destination);
-  if (i != m_routes.end ())
+  m_wheel.Advance ();
+  uint32_t slot = FindSlot (GetKey (destination));
+  if (slot != m_slots.size ())
     {
-      m_routes.erase (i);
+      EraseSlot (slot);
     }
 }
+const HwmpRtable::ReactiveRoute *
+HwmpRtable::FindReactive (Mac48Address destination) const
+{
+  uint32_t slot = FindSlot (GetKey (destination));
+  if (slot == m_slots.size ())
+    {
+      return 0;
+    }
+  return &m_slots[slot].route;
+}
 HwmpRtable::LookupResult
 HwmpRtable::LookupReactive (Mac48Address destination)
 {
   NS_LOG_FUNCTION (this << destination);
-  std::map<Mac48Address, ReactiveRoute>::iterator i = m_routes.find (destination);
-  if (i == m_routes.end ())
+  const ReactiveRoute * route = FindReactive (destination);
+  if (route == 0)
     {
       return LookupResult ();
     }
-  if ((i->second.whenExpire < Simulator::Now ()) && (i->second.whenExpire != Seconds (0)))
+  if (route->IsExpired ())
     {
       NS_LOG_DEBUG ("Reactive route has expired, sorry.");
       return LookupResult ();
     }
-  return LookupReactiveExpired (destination);
+  NS_LOG_DEBUG ("Returning reactive route to " << destination);
+  return route->GetLookupResult ();
 }
 HwmpRtable::LookupResult
 HwmpRtable::LookupReactiveExpired (Mac48Address destination)
 {
   NS_LOG_FUNCTION (this << destination);
-  std::map<Mac48Address, ReactiveRoute>::iterator i = m_routes.find (destination);
-  if (i == m_routes.end ())
+  const ReactiveRoute * route = FindReactive (destination);
+  if (route == 0)
     {
       return LookupResult ();
     }
   NS_LOG_DEBUG ("Returning reactive route to " << destination);
-  return LookupResult (i->second.retransmitter, i->second.interface, i->second.metric, i->second.seqnum,
-                       i->second.whenExpire - Simulator::Now ());
+  return route->GetLookupResult ();
 }
 HwmpRtable::LookupResult
 HwmpRtable::LookupProactive ()
@@ -200,13 +527,16 @@ HwmpRtable::GetUnreachableDestinations (Mac48Address peerAddress)
   NS_LOG_FUNCTION (this << peerAddress);
   HwmpProtocol::FailedDestination dst;
   std::vector<HwmpProtocol::FailedDestination> retval;
-  for (std::map<Mac48Address, ReactiveRoute>::iterator i = m_routes.begin (); i != m_routes.end (); i++)
+  m_wheel.Advance ();
+  std::vector<uint32_t> slots = GetSortedSlots ();
+  for (std::vector<uint32_t>::const_iterator i = slots.begin (); i != slots.end (); i++)
     {
-      if (i->second.retransmitter == peerAddress)
+      ReactiveRoute & route = m_slots[*i].route;
+      if (route.retransmitter == peerAddress)
         {
-          dst.destination = i->first;
-          i->second.seqnum++;
-          dst.seqnum = i->second.seqnum;
+          dst.destination = route.destination;
+          route.seqnum++;
+          dst.seqnum = route.seqnum;
           retval.push_back (dst);
         }
     }
@@ -225,20 +555,155 @@ HwmpRtable::GetPrecursors (Mac48Address destination)
   NS_LOG_FUNCTION (this << destination);
   //We suppose that no duplicates here can be
   PrecursorList retval;
-  std::map<Mac48Address, ReactiveRoute>::iterator route = m_routes.find (destination);
-  if (route != m_routes.end ())
+  const ReactiveRoute * route = FindReactive (destination);
+  if (route != 0)
     {
-      for (std::vector<Precursor>::const_iterator i = route->second.precursors.begin ();
-           i != route->second.precursors.end (); i++)
+      for (uint32_t i = 0; i < route->precursors.GetN (); i++)
         {
-          if (i->whenExpire > Simulator::Now ())
+          const Precursor & precursor = route->precursors.Get (i);
+          if (precursor.whenExpire > Simulator::Now ())
             {
-              retval.push_back (std::make_pair (i->interface, i->address));
+              retval.push_back (std::make_pair (precursor.interface, precursor.address));
             }
         }
     }
   return retval;
 }
+std::vector<Mac48Address>
+HwmpRtable::FailOverPeer (Mac48Address peerAddress)
+{
+  NS_LOG_FUNCTION (this << peerAddress);
+  std::vector<Mac48Address> retval;
+  if (m_maxAlternatives == 0)
+    {
+      return retval;
+    }
+  m_wheel.Advance ();
+  std::vector<uint32_t> slots = GetSortedSlots ();
+  for (std::vector<uint32_t>::const_iterator i = slots.begin (); i != slots.end (); i++)
+    {
+      ReactiveRoute & route = m_slots[*i].route;
+      RemoveAlternative (route, peerAddress);
+      if (route.retransmitter == peerAddress && PromoteAlternative (route))
+        {
+          NS_LOG_DEBUG ("Reactive route to " << route.destination << " moved to " << route.retransmitter);
+          retval.push_back (route.destination);
+        }
+    }
+  return retval;
+}
+bool
+HwmpRtable::FailOverDestination (Mac48Address destination, Mac48Address peerAddress)
+{
+  NS_LOG_FUNCTION (this << destination << peerAddress);
+  uint32_t slot = FindSlot (GetKey (destination));
+  if (slot == m_slots.size ())
+    {
+      return false;
+    }
+  ReactiveRoute & route = m_slots[slot].route;
+  RemoveAlternative (route, peerAddress);
+  return (route.retransmitter == peerAddress) && PromoteAlternative (route);
+}
+bool
+HwmpRtable::RenewFromAlternative (Mac48Address destination)
+{
+  NS_LOG_FUNCTION (this << destination);
+  uint32_t slot = FindSlot (GetKey (destination));
+  if (slot == m_slots.size () || !m_slots[slot].route.IsExpired ())
+    {
+      return false;
+    }
+  return PromoteAlternative (m_slots[slot].route);
+}
+uint32_t
+HwmpRtable::ExpireReactivePaths (Mac48Address peerAddress)
+{
+  NS_LOG_FUNCTION (this << peerAddress);
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < m_slots.size (); i++)
+    {
+      ReactiveRoute & route = m_slots[i].route;
+      if (m_slots[i].key != EMPTY_KEY && route.retransmitter == peerAddress && !route.IsExpired ())
+        {
+          // Expired from now on, whenExpire equal to now would not be
+          route.whenExpire = Simulator::Now () - TimeStep (1);
+          n++;
+        }
+    }
+  return n;
+}
+bool
+HwmpRtable::ReactiveRoute::IsExpired () const
+{
+  return (whenExpire < Simulator::Now ()) && (whenExpire != Seconds (0));
+}
+HwmpRtable::LookupResult
+HwmpRtable::ReactiveRoute::GetLookupResult () const
+{
+  return LookupResult (retransmitter, interface, metric, seqnum, whenExpire - Simulator::Now ());
+}
+HwmpRtable::LookupResult
+HwmpRtable::ReactiveRoute::GetLookupResult (uint32_t flowHash, uint32_t maxMetric) const
+{
+  const NextHop * candidates[MAX_ALTERNATIVES];
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < nAlternatives; i++)
+    {
+      if (alternatives[i].metric <= maxMetric && alternatives[i].whenExpire >= Simulator::Now ())
+        {
+          candidates[n++] = &alternatives[i];
+        }
+    }
+  uint32_t choice = flowHash % (n + 1);
+  if (choice == 0)
+    {
+      return GetLookupResult ();
+    }
+  const NextHop & nextHop = *candidates[choice - 1];
+  return LookupResult (nextHop.retransmitter, nextHop.interface, nextHop.metric, seqnum,
+                       nextHop.whenExpire - Simulator::Now ());
+}
+HwmpRtable::Precursors::Precursors ()
+  : m_n (0)
+{
+}
+uint32_t
+HwmpRtable::Precursors::GetN () const
+{
+  return m_n;
+}
+HwmpRtable::Precursor &
+HwmpRtable::Precursors::Get (uint32_t i)
+{
+  NS_ASSERT (i < m_n);
+  return i < INLINE_PRECURSORS ? m_inline[i] : m_overflow[i - INLINE_PRECURSORS];
+}
+const HwmpRtable::Precursor &
+HwmpRtable::Precursors::Get (uint32_t i) const
+{
+  NS_ASSERT (i < m_n);
+  return i < INLINE_PRECURSORS ? m_inline[i] : m_overflow[i - INLINE_PRECURSORS];
+}
+void
+HwmpRtable::Precursors::Add (const Precursor & precursor)
+{
+  if (m_n < INLINE_PRECURSORS)
+    {
+      m_inline[m_n] = precursor;
+    }
+  else
+    {
+      m_overflow.push_back (precursor);
+    }
+  m_n++;
+}
+void
+HwmpRtable::Precursors::Clear ()
+{
+  m_overflow.clear ();
+  m_n = 0;
+}
 bool
 HwmpRtable::LookupResult::operator== (const HwmpRtable::LookupResult & o) const
 {
@@ -258,13 +723,22 @@ HwmpRtable::LookupResult::IsValid () const
 void
 HwmpRtable::Print (std::ostream & os)
 {
-  os << "<RoutingTable>" << std::endl;
+  m_wheel.Advance ();
+  os << "<RoutingTable evictedExpired=\"" << m_evictedExpired << "\" evictedOverflow=\"" << m_evictedOverflow << "\">" << std::endl;
   os << "<ProactiveRoute root=\"" << m_root.root << "\" retransmitter=\"" << m_root.retransmitter << "\" interface=\"" << m_root.interface << "\" metric=\"";
   os << m_root.metric << "\" expiration=\"" << m_root.whenExpire.GetSeconds() << "s\" seqNumber=\"" << m_root.seqnum << "\"/>" << std::endl;
-  for (std::map<Mac48Address, ReactiveRoute>::const_iterator i = m_routes.begin (); i != m_routes.end (); ++i)
+  std::vector<uint32_t> slots = GetSortedSlots ();
+  for (std::vector<uint32_t>::const_iterator i = slots.begin (); i != slots.end (); ++i)
     {
-      os << "<ReactiveRoute destination=\"" << i->first << "\" retransmitter=\"" << i->second.retransmitter << "\" interface=\"" << i->second.interface << "\" metric=\"";
-      os <<  i->second.metric << "\" expiration=\"" << i->second.whenExpire.GetSeconds() << "s\" seqNumber=\"" << i->second.seqnum << "\"/>" << std::endl;
+      const ReactiveRoute & route = m_slots[*i].route;
+      os << "<ReactiveRoute destination=\"" << route.destination << "\" retransmitter=\"" << route.retransmitter << "\" interface=\"" << route.interface << "\" metric=\"";
+      os <<  route.metric << "\" expiration=\"" << route.whenExpire.GetSeconds() << "s\" seqNumber=\"" << route.seqnum << "\"/>" << std::endl;
+      for (uint32_t j = 0; j < route.nAlternatives; j++)
+        {
+          const NextHop & nextHop = route.alternatives[j];
+          os << "<AlternativeRoute destination=\"" << route.destination << "\" retransmitter=\"" << nextHop.retransmitter << "\" interface=\"" << nextHop.interface << "\" metric=\"";
+          os << nextHop.metric << "\" expiration=\"" << nextHop.whenExpire.GetSeconds () << "s\"/>" << std::endl;
+        }
     }
   os << "</RoutingTable>" << std::endl;
 }
@@ -21,10 +21,11 @@
 #ifndef HWMP_RTABLE_H
 #define HWMP_RTABLE_H
 
-#include <map>
+#include <vector>
 #include "ns3/nstime.h"
 #include "ns3/mac48-address.h"
 #include "ns3/hwmp-protocol.h"
+#include "ns3/mesh-timer-wheel.h"
 namespace ns3 {
 namespace dot11s {
 /**
@@ -75,6 +76,87 @@ public:
   };
   /// Path precursor = {MAC, interface ID}
   typedef std::vector<std::pair<uint32_t, Mac48Address> > PrecursorList;
+  /// Precursor of a route
+  struct Precursor
+  {
+    Mac48Address address; ///< address
+    uint32_t interface; ///< interface
+    Time whenExpire; ///< expire time
+  };
+  /**
+   * Precursors of a route. Most routes have a handful of precursors, the
+   * first INLINE_PRECURSORS are stored in place and only the following
+   * ones are allocated.
+   */
+  class Precursors
+  {
+  public:
+    Precursors ();
+    /// \returns the number of precursors
+    uint32_t GetN () const;
+    /**
+     * \param i the index of the precursor, smaller than GetN ()
+     * \returns the precursor
+     */
+    Precursor & Get (uint32_t i);
+    /**
+     * \param i the index of the precursor, smaller than GetN ()
+     * \returns the precursor
+     */
+    const Precursor & Get (uint32_t i) const;
+    /**
+     * \param precursor the precursor to append
+     */
+    void Add (const Precursor & precursor);
+    /// Remove all precursors
+    void Clear ();
+  private:
+    static const uint32_t INLINE_PRECURSORS = 4; ///< precursors stored in place
+    Precursor m_inline[INLINE_PRECURSORS]; ///< the first precursors
+    std::vector<Precursor> m_overflow; ///< the following precursors
+    uint32_t m_n; ///< number of precursors
+  };
+  /// Most alternative next hops kept per reactive route, besides the primary one
+  static const uint32_t MAX_ALTERNATIVES = 3;
+  /// Alternative next hop of a reactive route, learned with the same sequence number
+  struct NextHop
+  {
+    Mac48Address retransmitter; ///< retransmitter
+    uint32_t interface; ///< interface
+    uint32_t metric; ///< metric of the path through the retransmitter
+    uint32_t advertisedMetric; ///< metric of the retransmitter itself to the destination
+    Time whenExpire; ///< expire time
+  };
+  /// Route found in reactive mode
+  struct ReactiveRoute
+  {
+    Mac48Address destination; ///< destination
+    Mac48Address retransmitter; ///< transmitter
+    uint32_t interface; ///< interface
+    uint32_t metric; ///< metric
+    uint32_t advertisedMetric; ///< metric of the retransmitter itself, MAX_METRIC if unknown
+    Time whenExpire; ///< expire time
+    uint32_t seqnum; ///< sequence number
+    uint8_t hopCount; ///< hops to the destination when the path was learned, 0 if unknown
+    Precursors precursors; ///< precursors
+    uint32_t wheelTag; ///< tag of the route in the expiry wheel
+    NextHop alternatives[MAX_ALTERNATIVES]; ///< alternative next hops, best metric first
+    uint32_t nAlternatives; ///< number of alternative next hops
+    /**
+     * \returns true if the lifetime of the route has passed, the route
+     * can still be used to report path errors
+     */
+    bool IsExpired () const;
+    /// \returns the route as LookupReactiveExpired returns it
+    LookupResult GetLookupResult () const;
+    /**
+     * Spread flows over the next hops whose metric is not above maxMetric
+     * \param flowHash the hash of the flow
+     * \param maxMetric the worst metric a next hop may have
+     * \returns the primary next hop or one of the alternatives not expired
+     */
+    LookupResult GetLookupResult (uint32_t flowHash, uint32_t maxMetric) const;
+  };
 
 public:
   /**
@@ -88,14 +170,61 @@ public:
 
   ///\name Add/delete paths
   //\{
+  /**
+   * Add or replace the primary next hop of a reactive path. With
+   * alternatives enabled a new sequence number discards them, and with the
+   * same sequence number the replaced primary next hop is kept as an
+   * alternative when it is still loop free.
+   *
+   * \param destination the destination
+   * \param retransmitter the next hop
+   * \param interface the interface
+   * \param metric the metric of the path
+   * \param lifetime the lifetime of the path
+   * \param seqnum the sequence number of the destination
+   * \param advertisedMetric the metric of the retransmitter itself, MAX_METRIC if unknown
+   * \param hopCount the number of hops to the destination, 0 if unknown
+   */
   void AddReactivePath (
     Mac48Address destination,
     Mac48Address retransmitter,
     uint32_t interface,
     uint32_t metric,
     Time  lifetime,
+    uint32_t seqnum,
+    uint32_t advertisedMetric = MAX_METRIC,
+    uint8_t hopCount = 0
+    );
+  /**
+   * Keep a next hop that is not better than the primary one of a reactive
+   * path as an alternative. It is only kept if the path has the same
+   * sequence number and the retransmitter is closer to the destination
+   * than this node (advertisedMetric below the primary metric), so the
+   * alternative can't lead back here.
+   *
+   * \param destination the destination
+   * \param retransmitter the next hop
+   * \param interface the interface
+   * \param metric the metric of the path
+   * \param advertisedMetric the metric of the retransmitter itself
+   * \param lifetime the lifetime of the path
+   * \param seqnum the sequence number of the destination
+   * \returns true if the next hop was kept
+   */
+  bool AddAlternativePath (
+    Mac48Address destination,
+    Mac48Address retransmitter,
+    uint32_t interface,
+    uint32_t metric,
+    uint32_t advertisedMetric,
+    Time  lifetime,
     uint32_t seqnum
     );
+  /**
+   * \param maxAlternatives how many alternative next hops are kept per
+   * reactive path, at most MAX_ALTERNATIVES, 0 disables multipath
+   */
+  void SetMaxAlternatives (uint32_t maxAlternatives);
   void AddProactivePath (
     uint32_t metric,
     Mac48Address root,
@@ -113,6 +242,15 @@ public:
 
   ///\name Lookup
   //\{
+  /**
+   * Find the reactive path to a destination with a single probe, callers
+   * test expiry and metric on the route itself.
+   *
+   * \param destination the destination
+   * \returns the route, including an expired one, 0 if there is none. The
+   * pointer is valid until a reactive path is next added or deleted.
+   */
+  const ReactiveRoute * FindReactive (Mac48Address destination) const;
   /// Lookup path to destination
   LookupResult LookupReactive (Mac48Address destination);
   /// Return all reactive paths, including expired
@@ -129,29 +267,42 @@ public:
    * \returns the list of unreachable destinations
    */
   std::vector<HwmpProtocol::FailedDestination> GetUnreachableDestinations (Mac48Address peerAddress);
+  /**
+   * When peer link with a given MAC-address fails, move the reactive paths
+   * through it to their best alternative next hop and forget the
+   * alternatives through it. Call before GetUnreachableDestinations.
+   * \param peerAddress the peer address
+   * \returns the destinations whose path moved to an alternative
+   */
+  std::vector<Mac48Address> FailOverPeer (Mac48Address peerAddress);
+  /**
+   * Forget the alternatives of a reactive path through a peer and, if its
+   * primary next hop is the peer, move it to its best alternative
+   * \param destination the destination
+   * \param peerAddress the peer address
+   * \returns true if the path moved to an alternative
+   */
+  bool FailOverDestination (Mac48Address destination, Mac48Address peerAddress);
+  /**
+   * Move an expired reactive path to an alternative next hop not expired
+   * \param destination the destination
+   * \returns true if the path moved to an alternative
+   */
+  bool RenewFromAlternative (Mac48Address destination);
+  /**
+   * Expire the reactive paths through a peer without deleting them, so
+   * they keep their sequence number, hop count and precursors for a local
+   * repair or a later path error
+   * \param peerAddress the peer whose link failed
+   * \returns the number of paths expired
+   */
+  uint32_t ExpireReactivePaths (Mac48Address peerAddress);
 
   // Print the routing tables
   // param os The output stream
   void Print (std::ostream & os);
 
 private:
-  /// Route found in reactive mode
-  struct Precursor
-  {
-    Mac48Address address; ///< address
-    uint32_t interface; ///< interface
-    Time whenExpire; ///< expire time
-  };
-  /// Route found in reactive mode
-  struct ReactiveRoute
-  {
-    Mac48Address retransmitter; ///< transmitter
-    uint32_t interface; ///< interface
-    uint32_t metric; ///< metric
-    Time whenExpire; ///< expire time
-    uint32_t seqnum; ///< sequence number
-    std::vector<Precursor> precursors; ///< precursors
-  };
   /// Route found in proactive mode
   struct ProactiveRoute
   {
@@ -161,11 +312,94 @@ private:
     uint32_t metric; ///< metric
     Time whenExpire; ///< expire time
     uint32_t seqnum; ///< sequence number
-    std::vector<Precursor> precursors; ///< precursors
+    uint8_t hopCount; ///< hops to the destination when the path was learned, 0 if unknown
+    Precursors precursors; ///< precursors
   };
 
-  /// List of routes
-  std::map<Mac48Address, ReactiveRoute>  m_routes;
+  /// Slot of the reactive route table
+  struct Slot
+  {
+    uint64_t key; ///< the destination as a 48 bit integer, EMPTY_KEY if unused
+    ReactiveRoute route; ///< the route
+  };
+  /// Key of unused slots, no MAC address maps to it
+  static const uint64_t EMPTY_KEY = ~(uint64_t)0;
+  /**
+   * \param address a MAC address
+   * \returns the address as a 48 bit integer, the byte order preserves
+   * the order of Mac48Address
+   */
+  static uint64_t GetKey (Mac48Address address);
+  /**
+   * Expiry callback of m_wheel
+   * \param key the destination key
+   * \param tag the wheel tag of the route
+   * \returns the time the route becomes stale, or now if it was evicted
+   */
+  Time ExpireRoute (uint64_t key, uint32_t tag);
+  /// Evict the reactive route that expires first
+  void EvictOldestRoute ();
+  /**
+   * Replace the primary next hop of a route by its best alternative not expired
+   * \param route the route
+   * \returns true if there was such an alternative
+   */
+  static bool PromoteAlternative (ReactiveRoute & route);
+  /**
+   * Remove the alternatives of a route through a retransmitter
+   * \param route the route
+   * \param retransmitter the retransmitter
+   */
+  static void RemoveAlternative (ReactiveRoute & route, Mac48Address retransmitter);
+  /**
+   * Insert an alternative sorted by metric, dropping the worst one if the
+   * route already has maxAlternatives
+   * \param route the route
+   * \param nextHop the alternative
+   * \param maxAlternatives the most alternatives the route may keep
+   * \returns true if the alternative was kept
+   */
+  static bool InsertAlternative (ReactiveRoute & route, const NextHop & nextHop, uint32_t maxAlternatives);
+  /**
+   * \param key a destination key
+   * \returns the slot where the probe for key starts
+   */
+  uint32_t GetHome (uint64_t key) const;
+  /**
+   * \param key a destination key
+   * \returns the slot holding key, m_slots.size () if there is none
+   */
+  uint32_t FindSlot (uint64_t key) const;
+  /**
+   * \param key a destination key
+   * \returns the slot holding key, a new one if there is none
+   */
+  uint32_t InsertSlot (uint64_t key);
+  /**
+   * Empty a slot, shifting back the following entries of its probe
+   * sequence so that no tombstones are needed
+   * \param slot the slot to empty
+   */
+  void EraseSlot (uint32_t slot);
+  /**
+   * \returns the used slots sorted by destination, the order in which
+   * routes used to be stored
+   */
+  std::vector<uint32_t> GetSortedSlots () const;
+
+  /**
+   * Reactive routes in an open addressing hash table with linear probing,
+   * the size is a power of two and at most half of the slots are used
+   */
+  std::vector<Slot> m_slots;
+  uint32_t m_nRoutes; ///< number of reactive routes
+  MeshTimerWheel m_wheel; ///< evicts reactive routes expired for long
+  uint32_t m_nextWheelTag; ///< wheel tag of the next new route
+  Time m_maxExpiredAge; ///< how long an expired reactive route is kept, 0 for ever
+  uint32_t m_maxRoutes; ///< maximum number of reactive routes, 0 for no limit
+  uint32_t m_evictedExpired; ///< routes evicted because they expired long ago
+  uint32_t m_evictedOverflow; ///< routes evicted because the table was full
+  uint32_t m_maxAlternatives; ///< alternative next hops kept per reactive route
   /// Path to proactive tree root MP
   ProactiveRoute  m_root;
 };
@@ -121,7 +121,7 @@ IePerr::IsFull () const
           -  13// 10 /* Size of Mac48Address + uint32_t (one unit)*/
           );
 }
-std::vector<HwmpProtocol::FailedDestination>
+const std::vector<HwmpProtocol::FailedDestination> &
 IePerr::GetAddressUnitVector () const
 {
   return m_addressUnits;
@@ -55,7 +55,7 @@ public:
    * Get address unit vector function
    * \returns the list of failed destinations
    */
-  std::vector<HwmpProtocol::FailedDestination> GetAddressUnitVector () const;
+  const std::vector<HwmpProtocol::FailedDestination> & GetAddressUnitVector () const;
   /**
    * Delete address unit function
    * \param address the MAC address of the deleted unit
@@ -55,18 +55,18 @@ DestinationAddressUnit::SetDestinationAddress (Mac48Address dest_address)
   m_destinationAddress = dest_address;
 }
 bool
-DestinationAddressUnit::IsDo ()
+DestinationAddressUnit::IsDo () const
 {
   return m_do;
 }
 
 bool
-DestinationAddressUnit::IsRf ()
+DestinationAddressUnit::IsRf () const
 {
   return m_rf;
 }
 bool
-DestinationAddressUnit::IsUsn ()
+DestinationAddressUnit::IsUsn () const
 {
   return m_usn;
 }
@@ -146,6 +146,7 @@ IePreq::SetLifetime (uint32_t lifetime)
 void
 IePreq::SetDestCount (uint8_t dest_count)
 {
+  NS_ASSERT (dest_count <= MAX_DESTINATIONS);
   m_destCount = dest_count;
 }
 bool
@@ -223,25 +224,24 @@ IePreq::SerializeInformationField (Buffer::Iterator i) const
   i.WriteHtolsbU32 (m_metric);
   i.WriteU8 (m_destCount);
   int written = 0;
-  for (std::vector<Ptr<DestinationAddressUnit> >::const_iterator j = m_destinations.begin (); j
-       != m_destinations.end (); j++)
+  for (const DestinationAddressUnit *j = m_destinations; j != m_destinations + m_destCount; j++)
     {
       uint8_t flags = 0;
-      if ((*j)->IsDo ())
+      if (j->IsDo ())
         {
           flags |= 1 << 0;
         }
-      if ((*j)->IsRf ())
+      if (j->IsRf ())
         {
           flags |= 1 << 1;
         }
-      if ((*j)->IsUsn ())
+      if (j->IsUsn ())
         {
           flags |= 1 << 2;
         }
       i.WriteU8 (flags);
-      WriteTo (i, (*j)->GetDestinationAddress ());
-      i.WriteHtolsbU32 ((*j)->GetDestSeqNumber ());
+      WriteTo (i, j->GetDestinationAddress ());
+      i.WriteHtolsbU32 (j->GetDestSeqNumber ());
       written++;
       if (written > m_maxSize)
         {
@@ -262,9 +262,16 @@ IePreq::DeserializeInformationField (Buffer::Iterator start, uint8_t length)
   m_lifetime = i.ReadLsbtohU32 ();
   m_metric = i.ReadLsbtohU32 ();
   m_destCount = i.ReadU8 ();
+  //The count comes off the wire: only read the units the element really holds,
+  //which are never more than MAX_DESTINATIONS
+  uint8_t unitsInElement = (length > 26) ? (length - 26) / 11 : 0;
+  if (m_destCount > unitsInElement)
+    {
+      m_destCount = unitsInElement;
+    }
   for (int j = 0; j < m_destCount; j++)
     {
-      Ptr<DestinationAddressUnit> new_element = Create<DestinationAddressUnit> ();
+      DestinationAddressUnit * new_element = &m_destinations[j];
       bool doFlag = false;
       bool rfFlag = false;
       bool usnFlag = false;
@@ -286,7 +293,6 @@ IePreq::DeserializeInformationField (Buffer::Iterator start, uint8_t length)
       ReadFrom (i, addr);
       new_element->SetDestinationAddress (addr);
       new_element->SetDestSeqNumber (i.ReadLsbtohU32 ());
-      m_destinations.push_back (new_element);
       NS_ASSERT (28 + j * 11 < length);
     }
   return i.GetDistanceFrom (start);
@@ -326,44 +332,54 @@ IePreq::Print (std::ostream &os) const
      << ", Destinations=(";
   for (int j = 0; j < m_destCount; j++)
     {
-      os << m_destinations[j]->GetDestinationAddress ();
+      os << m_destinations[j].GetDestinationAddress ();
     }
   os << ")";
 }
-std::vector<Ptr<DestinationAddressUnit> >
-IePreq::GetDestinationList ()
+const DestinationAddressUnit &
+IePreq::GetDestination (uint8_t i) const
+{
+  NS_ASSERT (i < m_destCount);
+  return m_destinations[i];
+}
+DestinationAddressUnit &
+IePreq::GetDestination (uint8_t i)
 {
-  return m_destinations;
+  NS_ASSERT (i < m_destCount);
+  return m_destinations[i];
 }
 void
 IePreq::AddDestinationAddressElement (bool doFlag, bool rfFlag, Mac48Address dest_address,
                                       uint32_t dest_seq_number)
 {
-  for (std::vector<Ptr<DestinationAddressUnit> >::const_iterator i = m_destinations.begin (); i
-       != m_destinations.end (); i++)
+  for (uint8_t i = 0; i < m_destCount; i++)
     {
-      if ((*i)->GetDestinationAddress () == dest_address)
+      if (m_destinations[i].GetDestinationAddress () == dest_address)
         {
           return;
         }
     }
-  /// \todo check overflow
-  Ptr<DestinationAddressUnit> new_element = Create<DestinationAddressUnit> ();
-  new_element->SetFlags (doFlag, rfFlag, (dest_seq_number == 0));
-  new_element->SetDestinationAddress (dest_address);
-  new_element->SetDestSeqNumber (dest_seq_number);
-  m_destinations.push_back (new_element);
+  if (m_destCount == MAX_DESTINATIONS)
+    {
+      return;
+    }
+  DestinationAddressUnit & new_element = m_destinations[m_destCount];
+  new_element.SetFlags (doFlag, rfFlag, (dest_seq_number == 0));
+  new_element.SetDestinationAddress (dest_address);
+  new_element.SetDestSeqNumber (dest_seq_number);
   m_destCount++;
 }
 void
 IePreq::DelDestinationAddressElement (Mac48Address dest_address)
 {
-  for (std::vector<Ptr<DestinationAddressUnit> >::iterator i = m_destinations.begin (); i
-       != m_destinations.end (); i++)
+  for (uint8_t i = 0; i < m_destCount; i++)
     {
-      if ((*i)->GetDestinationAddress () == dest_address)
+      if (m_destinations[i].GetDestinationAddress () == dest_address)
         {
-          m_destinations.erase (i);
+          for (uint8_t j = i + 1; j < m_destCount; j++)
+            {
+              m_destinations[j - 1] = m_destinations[j];
+            }
           m_destCount--;
           break;
         }
@@ -372,12 +388,6 @@ IePreq::DelDestinationAddressElement (Mac48Address dest_address)
 void
 IePreq::ClearDestinationAddressElements ()
 {
-  for (std::vector<Ptr<DestinationAddressUnit> >::iterator j = m_destinations.begin (); j
-       != m_destinations.end (); j++)
-    {
-      (*j) = 0;
-    }
-  m_destinations.clear ();
   m_destCount = 0;
 }
 bool
@@ -398,13 +408,9 @@ operator== (const IePreq & a, const IePreq & b)
     {
       return false;
     }
-  if (a.m_destinations.size () != b.m_destinations.size ())
-    {
-      return false;
-    }
-  for (size_t i = 0; i < a.m_destinations.size (); ++i)
+  for (uint8_t i = 0; i < a.m_destCount; ++i)
     {
-      if (!(*(PeekPointer (a.m_destinations[i])) == *(PeekPointer (b.m_destinations[i]))))
+      if (!(a.m_destinations[i] == b.m_destinations[i]))
         {
           return false;
         }
@@ -418,7 +424,7 @@ IePreq::MayAddAddress (Mac48Address originator)
     {
       return false;
     }
-  if (m_destinations[0]->GetDestinationAddress () == Mac48Address::GetBroadcast ())
+  if (m_destinations[0].GetDestinationAddress () == Mac48Address::GetBroadcast ())
     {
       return false;
     }
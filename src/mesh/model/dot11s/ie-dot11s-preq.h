@@ -33,7 +33,7 @@ namespace dot11s {
  * \brief Describes an address unit in PREQ information element
  * See 7.3.2.96 for more details
  */
-class DestinationAddressUnit : public SimpleRefCount<DestinationAddressUnit>
+class DestinationAddressUnit
 {
 public:
   DestinationAddressUnit ();
@@ -58,17 +58,17 @@ public:
    * Is do function
    * \returns true if DO flag is set
    */
-  bool IsDo ();
+  bool IsDo () const;
   /**
    * is RF function
    * \returns true if RF flag is set
    */
-  bool IsRf ();
+  bool IsRf () const;
   /**
    * Is USN function
    * \returns true if USN flag set
    */
-  bool IsUsn ();
+  bool IsUsn () const;
   /**
    * Get destination address function
    * \returns the MAC address
@@ -127,10 +127,17 @@ public:
   /// Clear PREQ: remove all destinations
   void ClearDestinationAddressElements ();
   /**
-   * Get all destinations, which are stored in PREQ:
-   * \returns the list of destination addresses
+   * Get a destination stored in PREQ
+   * \param i the index of the destination, less than GetDestCount ()
+   * \returns the destination address unit
    */
-  std::vector<Ptr<DestinationAddressUnit> > GetDestinationList ();
+  const DestinationAddressUnit & GetDestination (uint8_t i) const;
+  /**
+   * Get a destination stored in PREQ
+   * \param i the index of the destination, less than GetDestCount ()
+   * \returns the destination address unit, to update its flags
+   */
+  DestinationAddressUnit & GetDestination (uint8_t i);
   /// Set flag indicating that PREQ is unicast
   void SetUnicastPreq ();
   /**
@@ -276,7 +283,9 @@ private:
   uint32_t m_lifetime; ///< lifetime
   uint32_t m_metric; ///< metric
   uint8_t  m_destCount; ///< destination count
-  std::vector<Ptr<DestinationAddressUnit> >  m_destinations; ///< the destinations
+  /// The most destinations that fit in the 255 byte information field
+  static const uint8_t MAX_DESTINATIONS = (255 - 26) / 11;
+  DestinationAddressUnit m_destinations[MAX_DESTINATIONS]; ///< the destinations, m_destCount of them are used
 
   /**
    * equality operator
@@ -26,15 +26,30 @@
 #include "ns3/address-utils.h"
 #include "ns3/assert.h"
 #include "ns3/packet.h"
+#include <algorithm>
 
 namespace ns3 {
 namespace dot11s {
+namespace {
+// LPP ID, originator address, originator seqno and fragment
+const uint8_t LPP_HEADER_SIZE = 12;
+// Trailing address bytes serialized for each value of the 2 bit suffix code
+const uint8_t SUFFIX_LENGTH[4] = { 6, 3, 2, 1 };
+} // namespace
 /*******************************
 * IeLpp
 *******************************/
 IeLpp::~IeLpp() {}
 
-IeLpp::IeLpp() {}
+IeLpp::IeLpp() :
+	m_lppId(0),
+	m_originSeqno(0),
+	m_fragmentIndex(0),
+	m_fragmentCount(1),
+	m_recordsSize(0),
+	m_nNeighbors(0)
+{
+}
 
 WifiInformationElementId
 IeLpp::ElementId() const
@@ -42,19 +57,22 @@ IeLpp::ElementId() const
 	return IE_LPP;
 }
 
+void
+IeLpp::SetFragment(uint8_t index, uint8_t count)
+{
+	NS_ASSERT(index < count && count <= MAX_FRAGMENTS);
+	m_fragmentIndex = index;
+	m_fragmentCount = count;
+}
+
 void
 IeLpp::SerializeInformationField(Buffer::Iterator i) const
 {
 	i.WriteU8(m_lppId);
 	WriteTo(i, m_originAddr);
 	i.WriteHtolsbU32(m_originSeqno);
-	i.WriteU8(GetNumberNeighbors());
-	std::map<Mac48Address, uint8_t>::const_iterator j;
-	for (j = m_neighborsLppCnt.begin(); j != m_neighborsLppCnt.end(); ++j)
-	{
-		WriteTo(i, (*j).first);
-		i.WriteU8((*j).second);
-	}
+	i.WriteU8((m_fragmentIndex << 4) | (m_fragmentCount - 1));
+	i.Write(m_records, m_recordsSize);
 }
 
 uint8_t
@@ -64,15 +82,22 @@ IeLpp::DeserializeInformationField(Buffer::Iterator start, uint8_t length)
 	m_lppId = i.ReadU8();
 	ReadFrom(i, m_originAddr);
 	m_originSeqno = i.ReadLsbtohU32();
-	uint8_t numberNeighbors = i.ReadU8();
-	m_neighborsLppCnt.clear();
-	Mac48Address neighborAddr;
+	uint8_t fragment = i.ReadU8();
+	m_fragmentIndex = fragment >> 4;
+	m_fragmentCount = (fragment & 0x0f) + 1;
+	// The records are kept as they are, only counted here
+	m_recordsSize = (length > LPP_HEADER_SIZE) ? length - LPP_HEADER_SIZE : 0;
+	i.Read(m_records, m_recordsSize);
+	m_nNeighbors = 0;
+	std::fill(m_lastAddress, m_lastAddress + 6, 0);
 	uint8_t lppCnt;
-	for (uint8_t k = 0; k < numberNeighbors; ++k)
+	for (uint32_t offset = 0; offset < m_recordsSize; m_nNeighbors++)
 	{
-		ReadFrom(i, neighborAddr);
-		lppCnt = i.ReadU8();
-		m_neighborsLppCnt.insert(std::make_pair(neighborAddr, lppCnt));
+		offset = ReadRecord(offset, m_lastAddress, lppCnt);
+		if (offset == 0)
+		{
+			break;
+		}
 	}
 
 	uint8_t dist = i.GetDistanceFrom(start);
@@ -83,25 +108,58 @@ IeLpp::DeserializeInformationField(Buffer::Iterator start, uint8_t length)
 uint8_t
 IeLpp::GetInformationFieldSize() const
 {
-	uint8_t retval = 1 //LPP ID
-		+ 6   //Source address (originator)
-		+ 4   //Originator seqno
-		+ 1;  //Number of Neighbors
+	return LPP_HEADER_SIZE + m_recordsSize;
+}
 
-	return (retval + 7 * GetNumberNeighbors());
+uint8_t
+IeLpp::GetSuffixLength(const uint8_t *neighbor, const uint8_t *previous)
+{
+	uint8_t shared = 0;
+	while (previous != 0 && shared < 5 && neighbor[shared] == previous[shared])
+	{
+		shared++;
+	}
+	if (shared >= 3)
+	{
+		return 6 - shared;
+	}
+	return 6;
+}
+
+uint32_t
+IeLpp::ReadRecord(uint32_t offset, uint8_t *address, uint8_t & lppCnt) const
+{
+	uint8_t record = m_records[offset++];
+	uint8_t suffix = SUFFIX_LENGTH[record >> 6];
+	if (offset + suffix > m_recordsSize)
+	{
+		return 0;
+	}
+	std::copy(m_records + offset, m_records + offset + suffix, address + 6 - suffix);
+	lppCnt = record & MAX_LPP_COUNT;
+	return offset + suffix;
 }
 
 void
 IeLpp::Print(std::ostream &os) const
 {
-	os << "LPP=(Lpp ID: " << m_lppId << ", Originator MAC address: " << m_originAddr;
+	os << "LPP=(Lpp ID: " << (uint16_t)m_lppId << ", Originator MAC address: " << m_originAddr;
+	os << "Fragment: " << (uint16_t)m_fragmentIndex << " of " << (uint16_t)m_fragmentCount;
 	os << "Originator Sequence number: " << m_originSeqno;
 	os << "Number of neighbors: " << (*this).GetNumberNeighbors();
 	os << "Neighbors (Mac address, received LPP count): ";
-	std::map<Mac48Address, uint8_t>::const_iterator j;
-	for (j = m_neighborsLppCnt.begin(); j != m_neighborsLppCnt.end(); ++j)
+	uint8_t address[6] = { 0, 0, 0, 0, 0, 0 };
+	uint8_t lppCnt;
+	Mac48Address neighbor;
+	for (uint32_t offset = 0; offset < m_recordsSize; )
 	{
-		os << (*j).first << ", " << (*j).second;
+		offset = ReadRecord(offset, address, lppCnt);
+		if (offset == 0)
+		{
+			break;
+		}
+		neighbor.CopyFrom(address);
+		os << neighbor << ", " << (uint16_t)lppCnt;
 	}
 	os << ")";
 }
@@ -109,56 +167,58 @@ IeLpp::Print(std::ostream &os) const
 bool
 IeLpp::AddToNeighborsList(Mac48Address neighbor, uint8_t lppCnt)
 {
-	if (m_neighborsLppCnt.find(neighbor) != m_neighborsLppCnt.end())
+	NS_ASSERT(lppCnt <= MAX_LPP_COUNT);
+	uint8_t address[6];
+	neighbor.CopyTo(address);
+	uint8_t suffix = GetSuffixLength(address, m_nNeighbors == 0 ? 0 : m_lastAddress);
+	if (m_recordsSize + 1 + suffix > MAX_RECORDS_SIZE)
 	{
-		return true;
+		return false;
 	}
-
-	NS_ASSERT(GetNumberNeighbors() < 255); // can't support more than 2^8 - 1 neighbors
-	m_neighborsLppCnt.insert(std::make_pair(neighbor, lppCnt));
+	uint8_t code = (suffix == 6) ? 0 : 4 - suffix;
+	m_records[m_recordsSize++] = (code << 6) | lppCnt;
+	std::copy(address + 6 - suffix, address + 6, m_records + m_recordsSize);
+	m_recordsSize += suffix;
+	m_nNeighbors++;
+	std::copy(address, address + 6, m_lastAddress);
 	return true;
 }
 
-bool
-IeLpp::RemoveFromNeighborsList(std::pair<Mac48Address, uint8_t> & un)
+uint8_t
+IeLpp::FindReverseCount(Mac48Address neighbor) const
 {
-	if (m_neighborsLppCnt.empty())
+	uint8_t wanted[6];
+	neighbor.CopyTo(wanted);
+	uint8_t address[6] = { 0, 0, 0, 0, 0, 0 };
+	uint8_t lppCnt;
+	for (uint32_t offset = 0; offset < m_recordsSize; )
 	{
-		return false;
+		offset = ReadRecord(offset, address, lppCnt);
+		if (offset == 0)
+		{
+			break;
+		}
+		if (std::equal(address, address + 6, wanted))
+		{
+			return lppCnt;
+		}
 	}
-
-	std::map<Mac48Address, uint8_t>::iterator i = m_neighborsLppCnt.begin();
-	un = *i;
-	m_neighborsLppCnt.erase(i);
-	return true;
+	return 0;
 }
 
 void
 IeLpp::ClearNeighborsList()
 {
-	m_neighborsLppCnt.clear();
+	m_recordsSize = 0;
+	m_nNeighbors = 0;
 }
 
 bool
 operator== (const IeLpp & a, const IeLpp & b)
 {
-	if (a.m_lppId != b.m_lppId || a.m_originAddr != b.m_originAddr || a.m_originSeqno != b.m_originSeqno
-		|| a.GetNumberNeighbors() != b.GetNumberNeighbors())
-	{
-		return false;
-	}
-	std::map<Mac48Address, uint8_t>::const_iterator j = a.m_neighborsLppCnt.begin();
-	std::map<Mac48Address, uint8_t>::const_iterator k = b.m_neighborsLppCnt.begin();
-	for (uint8_t i = 0; i < a.GetNumberNeighbors(); ++i)
-	{
-		if ((j->first != k->first) || (j->second != k->second))
-		{
-			return false;
-		}
-		j++;
-		k++;
-	}
-	return true;
+	return a.m_lppId == b.m_lppId && a.m_originAddr == b.m_originAddr && a.m_originSeqno == b.m_originSeqno
+		&& a.m_fragmentIndex == b.m_fragmentIndex && a.m_fragmentCount == b.m_fragmentCount
+		&& a.m_recordsSize == b.m_recordsSize && std::equal(a.m_records, a.m_records + a.m_recordsSize, b.m_records);
 }
 
 std::ostream &
@@ -25,7 +25,7 @@
 #ifndef WIFI_LPP_INFORMATION_ELEMENT_H
 #define WIFI_LPP_INFORMATION_ELEMENT_H
 
-#include <map>
+#include <stdint.h>
 
 #include "ns3/mac48-address.h"
 #include "ns3/mesh-information-element-vector.h"
@@ -33,9 +33,34 @@
 namespace ns3 {
 namespace dot11s {
 
+/**
+* \ingroup dot11s
+* \brief Link probe packet information element, carries the LPP counts this node
+* received from each of its neighbors.
+*
+* Neighbors are serialized sorted by address, each as a byte holding the
+* LPP count (6 bits) and how many trailing address bytes follow (2 bits,
+* 6, 3, 2 or 1 bytes); the leading bytes are those of the previous neighbor
+* of the element. The element keeps the neighbors in this form, so neither
+* building nor parsing it allocates memory. A list longer than one element
+* allows is split into several elements, each with the same header and its
+* index and the number of elements. At most MAX_FRAGMENTS_PER_FRAME of them
+* are sent per frame; the receiver joins the frames by originator, LPP ID
+* and originator sequence number.
+*/
 class IeLpp : public WifiInformationElement
 {
 public:
+	/// Largest LPP count of a neighbor
+	static const uint8_t MAX_LPP_COUNT = 63;
+	/// Largest number of elements a neighbor list is split into
+	static const uint8_t MAX_FRAGMENTS = 16;
+	/// Largest number of elements sent in one frame: 8 full elements of 257 bytes
+	/// and the 2 byte action header fit in the 2304 byte MMPDU
+	static const uint8_t MAX_FRAGMENTS_PER_FRAME = 8;
+	/// Largest size of the neighbor records of an element
+	static const uint8_t MAX_RECORDS_SIZE = 255 - 12;
+
 	///Constructor
 	IeLpp();
 	///Destructor
@@ -71,14 +96,43 @@ public:
 		return m_originSeqno;
 	}
 
-	uint8_t GetNumberNeighbors() const
+	uint32_t GetNumberNeighbors() const
+	{
+		return m_nNeighbors;
+	}
+
+	/// \returns the index of this element among the elements of the neighbor list
+	uint8_t GetFragmentIndex() const
 	{
-		return (uint8_t)m_neighborsLppCnt.size();
+		return m_fragmentIndex;
 	}
 
+	/// \returns the number of elements the neighbor list was split into
+	uint8_t GetFragmentCount() const
+	{
+		return m_fragmentCount;
+	}
+
+	/**
+	* \param index the index of this element among the elements of the neighbor list
+	* \param count the number of elements the neighbor list was split into
+	*/
+	void SetFragment(uint8_t index, uint8_t count);
+
 	// Control neighbors list
+	/**
+	* Append a neighbor, each neighbor is added once and in address order
+	* \param neighbor a neighbor MAC address
+	* \param lppCnt the LPP count of the neighbor
+	* \returns false if the element is full, the neighbor is not added then
+	*/
 	bool AddToNeighborsList(Mac48Address neighbor, uint8_t lppCnt);
-	bool RemoveFromNeighborsList(std::pair<Mac48Address, uint8_t> & un);
+	/**
+	* Scan the neighbor records for a neighbor
+	* \param neighbor a neighbor MAC address
+	* \returns the LPP count reported for the neighbor, 0 if it is not in the list
+	*/
+	uint8_t FindReverseCount(Mac48Address neighbor) const;
 	void ClearNeighborsList();
 
 	// Inherited from WifiInformationElement
@@ -89,12 +143,33 @@ public:
 	virtual void Print(std::ostream& os) const;
 
 private:
-	uint8_t       m_lppId;         //< LPP ID which is set to the Lpp Time slot (runs 0 to 11 cyclically )
+	uint8_t       m_lppId;         //< LPP ID which is set to the Lpp Time slot (runs 0 to EtxWindow - 1 cyclically)
 	Mac48Address  m_originAddr;    //< Originator MAC Address
 	uint32_t      m_originSeqno;   //< Originator Sequence number
+	uint8_t       m_fragmentIndex; //< Index of this element among those of the neighbor list
+	uint8_t       m_fragmentCount; //< Number of elements of the neighbor list
 
-	// List of neighbors: MAC addresses and number of LLP received from each in the last checked 10 time slot period
-	std::map<Mac48Address, uint8_t> m_neighborsLppCnt;
+	// List of neighbors: MAC addresses and number of LLP received from each in the counted time slots,
+	// serialized records as described above
+	uint8_t       m_records[MAX_RECORDS_SIZE];
+	uint8_t       m_recordsSize;   //< Bytes used in m_records
+	uint8_t       m_nNeighbors;    //< Number of records
+	uint8_t       m_lastAddress[6]; //< Address of the last record
+
+	/**
+	* \param neighbor a neighbor MAC address
+	* \param previous the address serialized before it, 0 for the first one
+	* \returns the number of trailing address bytes serialized for the neighbor
+	*/
+	static uint8_t GetSuffixLength(const uint8_t *neighbor, const uint8_t *previous);
+	/**
+	* Decode a neighbor record
+	* \param offset the offset of the record in m_records
+	* \param address the address of the previous record, replaced by the one of this record
+	* \param lppCnt the LPP count of this record
+	* \returns the offset of the next record, 0 if the record is truncated
+	*/
+	uint32_t ReadRecord(uint32_t offset, uint8_t *address, uint8_t & lppCnt) const;
 
 	/**
 	* equality operator
@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/mesh-timer-wheel.h"
+#include "ns3/simulator.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MeshTimerWheel");
+
+MeshTimerWheel::MeshTimerWheel ()
+  : m_tick (0),
+    m_resolution (MilliSeconds (100)),
+    m_n (0),
+    m_advancing (false)
+{
+}
+void
+MeshTimerWheel::SetResolution (Time resolution)
+{
+  NS_ASSERT_MSG (m_n == 0, "The resolution of a timer wheel can't change while it holds entries");
+  NS_ASSERT (resolution.IsStrictlyPositive ());
+  m_resolution = resolution;
+  m_tick = Simulator::Now ().GetTimeStep () / m_resolution.GetTimeStep ();
+}
+void
+MeshTimerWheel::SetExpiryCallback (ExpiryCallback expire)
+{
+  m_expire = expire;
+}
+void
+MeshTimerWheel::Schedule (uint64_t key, uint32_t tag, Time deadline)
+{
+  NS_LOG_FUNCTION (this << key << tag << deadline);
+  if (m_n == 0 && !m_advancing)
+    {
+      // Nothing to expire on the way, jump to the present
+      m_tick = std::max (m_tick, Simulator::Now ().GetTimeStep () / m_resolution.GetTimeStep ());
+    }
+  Entry entry;
+  entry.key = key;
+  entry.tag = tag;
+  // Round up, an entry never expires before its deadline
+  entry.tick = (deadline.GetTimeStep () + m_resolution.GetTimeStep () - 1) / m_resolution.GetTimeStep ();
+  Insert (entry);
+  m_n++;
+}
+void
+MeshTimerWheel::Insert (const Entry & entry)
+{
+  // Entries already due fire at the next tick
+  int64_t tick = std::max (entry.tick, m_tick + 1);
+  uint64_t delta = tick - m_tick;
+  uint32_t level = 0;
+  while (level < LEVELS - 1 && delta >= ((uint64_t)1 << (SLOT_BITS * (level + 1))))
+    {
+      level++;
+    }
+  if (delta >= ((uint64_t)1 << (SLOT_BITS * LEVELS)))
+    {
+      // Beyond the horizon of the wheel, park it in the farthest slot, it
+      // is inserted again when that slot cascades
+      tick = m_tick + ((int64_t)1 << (SLOT_BITS * LEVELS)) - 1;
+    }
+  m_slots[level][(tick >> (SLOT_BITS * level)) & SLOT_MASK].push_back (entry);
+}
+void
+MeshTimerWheel::Cascade (uint32_t level, uint32_t slot)
+{
+  std::vector<Entry> entries;
+  entries.swap (m_slots[level][slot]);
+  for (std::vector<Entry>::const_iterator i = entries.begin (); i != entries.end (); i++)
+    {
+      Insert (*i);
+    }
+}
+void
+MeshTimerWheel::Advance ()
+{
+  if (m_advancing)
+    {
+      return;
+    }
+  int64_t now = Simulator::Now ().GetTimeStep () / m_resolution.GetTimeStep ();
+  if (m_n == 0)
+    {
+      m_tick = std::max (m_tick, now);
+      return;
+    }
+  m_advancing = true;
+  std::vector<Entry> due;
+  while (m_tick < now && m_n > 0)
+    {
+      m_tick++;
+      for (uint32_t level = 1; level < LEVELS; level++)
+        {
+          if ((m_tick & (((int64_t)1 << (SLOT_BITS * level)) - 1)) != 0)
+            {
+              break;
+            }
+          Cascade (level, (m_tick >> (SLOT_BITS * level)) & SLOT_MASK);
+        }
+      due.clear ();
+      due.swap (m_slots[0][m_tick & SLOT_MASK]);
+      for (std::vector<Entry>::const_iterator i = due.begin (); i != due.end (); i++)
+        {
+          if (i->tick > m_tick)
+            {
+              // Parked beyond the horizon
+              Insert (*i);
+              continue;
+            }
+          m_n--;
+          Time deadline = m_expire (i->key, i->tag);
+          if (deadline > Simulator::Now ())
+            {
+              Schedule (i->key, i->tag, deadline);
+            }
+        }
+    }
+  m_tick = std::max (m_tick, now);
+  m_advancing = false;
+}
+void
+MeshTimerWheel::Clear ()
+{
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      for (uint32_t slot = 0; slot < SLOTS; slot++)
+        {
+          m_slots[level][slot].clear ();
+        }
+    }
+  m_n = 0;
+}
+uint32_t
+MeshTimerWheel::GetN () const
+{
+  return m_n;
+}
+uint64_t
+MeshTimerWheel::GetKey (Mac48Address address)
+{
+  uint8_t buffer[6];
+  address.CopyTo (buffer);
+  uint64_t key = 0;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      key = (key << 8) | buffer[i];
+    }
+  return key;
+}
+Mac48Address
+MeshTimerWheel::GetAddress (uint64_t key)
+{
+  uint8_t buffer[6];
+  for (int i = 5; i >= 0; i--)
+    {
+      buffer[i] = key & 0xff;
+      key >>= 8;
+    }
+  Mac48Address address;
+  address.CopyFrom (buffer);
+  return address;
+}
+
+} // namespace ns3
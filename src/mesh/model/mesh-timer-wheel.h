@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#ifndef MESH_TIMER_WHEEL_H
+#define MESH_TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/mac48-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup mesh
+ *
+ * \brief Hierarchical timer wheel used to evict stale entries of the mesh
+ * state tables (routes, sequence number databases, neighbor information).
+ *
+ * A table schedules each of its entries once, with the time it becomes
+ * stale, and does not touch the wheel when the entry is refreshed. When the
+ * deadline passes the wheel calls the expiry callback of the table, which
+ * either evicts the entry or returns its new deadline. Scheduling and expiry
+ * are amortized O(1), entries are moved down at most once per level.
+ *
+ * The wheel does not schedule simulator events: it is advanced by its table
+ * whenever the table is used, so it never changes the order of events of a
+ * simulation. Deadlines are rounded up to the resolution of the wheel.
+ *
+ * An entry is identified by a 64 bit key (e.g. a MAC address, see GetKey)
+ * and a tag chosen by the table, so that the wheel entry of a table entry
+ * removed and created again can be told apart from the current one.
+ */
+class MeshTimerWheel
+{
+public:
+  /**
+   * Expiry callback: called with the key and the tag of an entry whose
+   * deadline has passed. Returns the new deadline of the entry if it is
+   * still in use, any time not later than now to forget it.
+   */
+  typedef Callback<Time, uint64_t, uint32_t> ExpiryCallback;
+
+  MeshTimerWheel ();
+  /**
+   * \param resolution the duration of a tick, only allowed while the wheel is empty
+   */
+  void SetResolution (Time resolution);
+  /**
+   * \param expire the callback of the table using the wheel
+   */
+  void SetExpiryCallback (ExpiryCallback expire);
+  /**
+   * \param key the key of the entry
+   * \param tag the tag of the entry
+   * \param deadline when the expiry callback must be called for the entry
+   */
+  void Schedule (uint64_t key, uint32_t tag, Time deadline);
+  /// Call the expiry callback of all entries whose deadline has passed
+  void Advance ();
+  /// Forget all entries
+  void Clear ();
+  /// \returns the number of scheduled entries
+  uint32_t GetN () const;
+
+  /**
+   * \param address a MAC address
+   * \returns the address as a 48 bit integer, the order of the integers is
+   * the order of the addresses
+   */
+  static uint64_t GetKey (Mac48Address address);
+  /**
+   * \param key a key returned by GetKey
+   * \returns the MAC address
+   */
+  static Mac48Address GetAddress (uint64_t key);
+
+private:
+  /// Scheduled entry
+  struct Entry
+  {
+    uint64_t key; ///< key of the entry
+    uint32_t tag; ///< tag of the entry
+    int64_t tick; ///< tick of the deadline
+  };
+  static const uint32_t LEVELS = 4;                    ///< number of levels
+  static const uint32_t SLOT_BITS = 6;                 ///< log2 of the number of slots per level
+  static const uint32_t SLOTS = 1 << SLOT_BITS;        ///< slots per level
+  static const uint32_t SLOT_MASK = SLOTS - 1;         ///< mask of a slot index
+
+  /**
+   * Place an entry in the slot matching its distance to the current tick
+   * \param entry the entry
+   */
+  void Insert (const Entry & entry);
+  /**
+   * Reinsert the entries of a slot of an upper level, which now fall in
+   * lower levels
+   * \param level the level
+   * \param slot the slot
+   */
+  void Cascade (uint32_t level, uint32_t slot);
+
+  std::vector<Entry> m_slots[LEVELS][SLOTS]; ///< entries per level and slot
+  int64_t m_tick; ///< current tick, the entries of this tick have been expired
+  Time m_resolution; ///< duration of a tick
+  uint32_t m_n; ///< number of scheduled entries
+  bool m_advancing; ///< whether Advance is running
+  ExpiryCallback m_expire; ///< expiry callback of the table
+};
+
+} // namespace ns3
+
+#endif /* MESH_TIMER_WHEEL_H */
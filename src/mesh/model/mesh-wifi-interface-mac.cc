@@ -33,10 +33,10 @@
 #include "ns3/wifi-utils.h"
 #include "ns3/pointer.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/socket.h"
 #include "ns3/mobility-module.h"
-#include "ns3/rx-power-tag.h"
 
 namespace ns3 {
 
@@ -72,13 +72,37 @@ MeshWifiInterfaceMac::GetTypeId ()
                       &MeshWifiInterfaceMac::SetBeaconGeneration, &MeshWifiInterfaceMac::GetBeaconGeneration),
                     MakeBooleanChecker ()
                     )
+    .AddAttribute ( "NeighborInfoTimeout",
+                    "Time after which the information (location, rx power, failure average) "
+                    "of a neighbor that is not heard anymore is removed (0 means never)",
+                    TimeValue (Seconds (0)),
+                    MakeTimeAccessor (
+                      &MeshWifiInterfaceMac::m_neighborInfoTimeout),
+                    MakeTimeChecker ()
+                    )
+    .AddAttribute ( "NeighborInfoMaxSize",
+                    "Maximum number of neighbors whose information is kept (0 means no limit)",
+                    UintegerValue (0),
+                    MakeUintegerAccessor (
+                      &MeshWifiInterfaceMac::m_neighborInfoMaxSize),
+                    MakeUintegerChecker<uint32_t> ()
+                    )
   ;
   return tid;
 }
 MeshWifiInterfaceMac::MeshWifiInterfaceMac ()
-  : m_standard (WIFI_PHY_STANDARD_80211a)
+  : m_lastRxPowerDbm (0),
+    m_lastRxPacketUid (0),
+    m_lastRxPowerValid (false),
+    m_nextNeighborTag (0),
+    m_neighborInfoTimeout (Seconds (0)),
+    m_neighborInfoMaxSize (0),
+    m_neighborsEvictedExpired (0),
+    m_neighborsEvictedOverflow (0),
+    m_standard (WIFI_PHY_STANDARD_80211a)
 {
   NS_LOG_FUNCTION (this);
+  m_neighborsWheel.SetExpiryCallback (MakeCallback (&MeshWifiInterfaceMac::ExpireNeighborInfo, this));
 
   // Let the lower layers know that we are acting as a mesh node
   SetTypeOfStation (MESH);
@@ -120,11 +144,33 @@ MeshWifiInterfaceMac::SetLinkUpCallback (Callback<void> linkUp)
   linkUp ();
 }
 void
+MeshWifiInterfaceMac::SetWifiPhy (const Ptr<WifiPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  if (m_phy != 0)
+    {
+      m_phy->TraceDisconnectWithoutContext ("MonitorSnifferRx", MakeCallback (&MeshWifiInterfaceMac::NotifyPhyRx, this));
+    }
+  RegularWifiMac::SetWifiPhy (phy);
+  phy->TraceConnectWithoutContext ("MonitorSnifferRx", MakeCallback (&MeshWifiInterfaceMac::NotifyPhyRx, this));
+}
+void
+MeshWifiInterfaceMac::NotifyPhyRx (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                                   MpduInfo aMpdu, SignalNoiseDbm signalNoise)
+{
+  m_lastRxPowerDbm = signalNoise.signal;
+  m_lastRxPacketUid = packet->GetUid ();
+  m_lastRxPowerValid = true;
+}
+void
 MeshWifiInterfaceMac::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
   m_plugins.clear ();
   m_beaconSendEvent.Cancel ();
+  m_neighborsInfo.clear ();
+  m_neighborsLru.clear ();
+  m_neighborsWheel.Clear ();
 
   RegularWifiMac::DoDispose ();
 }
@@ -423,11 +469,12 @@ MeshWifiInterfaceMac::SendBeacon ()
 void
 MeshWifiInterfaceMac::Receive (Ptr<Packet> packet, WifiMacHeader const *hdr)
 {
-  RxPowerTag powerTag;
-  if(packet->RemovePacketTag (powerTag))
-  {
-    UpdatePeerRxPower (hdr->GetAddr2 (), powerTag.GetRxPower());
-  }
+  //The MAC strips headers in place, so the packet keeps the UID the PHY saw
+  if (m_lastRxPowerValid && packet->GetUid () == m_lastRxPacketUid)
+    {
+      UpdatePeerRxPower (hdr->GetAddr2 (), m_lastRxPowerDbm);
+    }
+  m_lastRxPowerValid = false;
   // Process beacon
   if ((hdr->GetAddr1 () != GetAddress ()) && (hdr->GetAddr1 () != Mac48Address::GetBroadcast ()))
     {
@@ -562,6 +609,10 @@ MeshWifiInterfaceMac::Report (std::ostream & os) const
     "Channel=\"" << GetFrequencyChannel () << "\" "
     "Address = \"" << GetAddress () << "\">" << std::endl;
   m_stats.Print (os);
+  os << "<NeighborInfo "
+    "size=\"" << m_neighborsInfo.size () << "\" "
+    "evictedExpired=\"" << m_neighborsEvictedExpired << "\" "
+    "evictedOverflow=\"" << m_neighborsEvictedOverflow << "\"/>" << std::endl;
   os << "</Interface>" << std::endl;
 }
 void
@@ -603,172 +654,118 @@ MeshWifiInterfaceMac::GetDataTxWifiMode(Mac48Address peerAddress)
 
   return GetWifiRemoteStationManager ()->GetDataTxVector (peerAddress, &m_dataHeader, m_dataFrame).GetMode();
 }
-void
-MeshWifiInterfaceMac::UpdateFailAvg (Mac48Address peerAddress, double failAvg)
+MeshWifiInterfaceMac::NeighborInfoUnit &
+MeshWifiInterfaceMac::TouchNeighborInfo (Mac48Address peerAddress)
 {
-  bool updated = false;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
+  m_neighborsWheel.Advance ();
+  NeighborInfoList::iterator i = m_neighborsInfo.find (peerAddress);
+  if (i == m_neighborsInfo.end ())
     {
-      if (i->first == peerAddress)
-      {
-        // if peerAddress is already in the list, then updates the fail Avg
-        i->second.failAvg = failAvg;
-        updated = true;
-        break;
-      }
+      if (m_neighborInfoMaxSize > 0 && m_neighborsInfo.size () >= m_neighborInfoMaxSize)
+        {
+          // Make room by removing the neighbor silent for the longest time
+          m_neighborsInfo.erase (m_neighborsLru.front ());
+          m_neighborsLru.pop_front ();
+          m_neighborsEvictedOverflow++;
+        }
+      i = m_neighborsInfo.insert (std::make_pair (peerAddress, NeighborInfoUnit ())).first;
+      i->second.lruPosition = m_neighborsLru.insert (m_neighborsLru.end (), peerAddress);
+      i->second.wheelTag = m_nextNeighborTag++;
+      if (!m_neighborInfoTimeout.IsZero ())
+        {
+          m_neighborsWheel.Schedule (MeshTimerWheel::GetKey (peerAddress), i->second.wheelTag,
+                                     Simulator::Now () + m_neighborInfoTimeout);
+        }
     }
-    if (!updated)
+  else
     {
-      // if peerAddress does not yet exist in the list, then creates a new entry
-      std::pair<Mac48Address, NeighborInfoUnit> newEntry;
-      newEntry.first = peerAddress;
-      newEntry.second.failAvg = failAvg;
-      m_neighborsInfo.push_back(newEntry);
+      m_neighborsLru.splice (m_neighborsLru.end (), m_neighborsLru, i->second.lruPosition);
     }
+  i->second.lastUpdate = Simulator::Now ();
+  return i->second;
 }
-double
-MeshWifiInterfaceMac::GetFailAvg (Mac48Address peerAddress)
+const MeshWifiInterfaceMac::NeighborInfoUnit *
+MeshWifiInterfaceMac::FindNeighborInfo (Mac48Address peerAddress) const
 {
-  double retval = 0;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::const_iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
+  NeighborInfoList::const_iterator i = m_neighborsInfo.find (peerAddress);
+  if (i == m_neighborsInfo.end ())
     {
-      if (i->first == peerAddress)
-      {
-        retval = i->second.failAvg;
-        break;
-      }
+      return 0;
     }
-  return retval;
+  return &i->second;
 }
-void
-MeshWifiInterfaceMac::UpdatePeerGeoInfo (Mac48Address peerAddress, Vector location, Vector velocity)
+Time
+MeshWifiInterfaceMac::ExpireNeighborInfo (uint64_t key, uint32_t tag)
 {
-  bool updated = false;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
+  NeighborInfoList::iterator i = m_neighborsInfo.find (MeshTimerWheel::GetAddress (key));
+  if (i == m_neighborsInfo.end () || i->second.wheelTag != tag || m_neighborInfoTimeout.IsZero ())
     {
-      if (i->first == peerAddress)
-      {
-        // if peerAddress is already in the list, then update the GeoInformation
-        i->second.lastUpdatedGeo = Simulator::Now ();
-        i->second.location = location;
-        i->second.velocity = velocity;
-        updated = true;
-        break;
-      }
+      return Simulator::Now ();
     }
-  if (!updated)
-  {
-    // if peerAddress does not exist in the list, then add it
-    std::pair<Mac48Address, NeighborInfoUnit> newEntry;
-    newEntry.first = peerAddress;
-    newEntry.second.lastUpdatedGeo = Simulator::Now ();
-    newEntry.second.location = location;
-    newEntry.second.velocity = velocity;
-    m_neighborsInfo.push_back(newEntry);
-  }
+  if (i->second.lastUpdate + m_neighborInfoTimeout > Simulator::Now ())
+    {
+      return i->second.lastUpdate + m_neighborInfoTimeout;
+    }
+  NS_LOG_DEBUG ("Removing information of silent neighbor " << i->first);
+  m_neighborsLru.erase (i->second.lruPosition);
+  m_neighborsInfo.erase (i);
+  m_neighborsEvictedExpired++;
+  return Simulator::Now ();
+}
+void
+MeshWifiInterfaceMac::UpdateFailAvg (Mac48Address peerAddress, double failAvg)
+{
+  TouchNeighborInfo (peerAddress).failAvg = failAvg;
+}
+double
+MeshWifiInterfaceMac::GetFailAvg (Mac48Address peerAddress)
+{
+  const NeighborInfoUnit * info = FindNeighborInfo (peerAddress);
+  return (info != 0) ? info->failAvg : 0;
+}
+void
+MeshWifiInterfaceMac::UpdatePeerGeoInfo (Mac48Address peerAddress, Vector location, Vector velocity)
+{
+  NeighborInfoUnit & info = TouchNeighborInfo (peerAddress);
+  info.lastUpdatedGeo = Simulator::Now ();
+  info.location = location;
+  info.velocity = velocity;
 }
 void
 MeshWifiInterfaceMac::UpdatePeerRxPower (Mac48Address peerAddress, double rxPower)
 {
-  bool updated = false;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
-    {
-      if (i->first == peerAddress)
-      {
-        // if peerAddress is found in the list, then updat the rx power
-        i->second.lastUpdatedPower = Simulator::Now ();
-        i->second.rxPowerDbm = rxPower;
-        updated = true;
-        break;
-      }
-    }
-  if (!updated)
-  {
-    // if peerAddress is not in the list, then add it
-    std::pair<Mac48Address, NeighborInfoUnit> newEntry;
-    newEntry.first = peerAddress;
-    newEntry.second.lastUpdatedPower = Simulator::Now();
-    newEntry.second.rxPowerDbm = rxPower;
-    m_neighborsInfo.push_back(newEntry);
-  }
+  NeighborInfoUnit & info = TouchNeighborInfo (peerAddress);
+  info.lastUpdatedPower = Simulator::Now ();
+  info.rxPowerDbm = rxPower;
 }
 Vector
 MeshWifiInterfaceMac::GetPeerLocation (Mac48Address peerAddress)
 {
-  Vector retval;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::const_iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
-    {
-      if (i->first == peerAddress)
-      {
-        retval = i->second.location;
-        break;
-      }
-    }
-  return retval;
+  const NeighborInfoUnit * info = FindNeighborInfo (peerAddress);
+  return (info != 0) ? info->location : Vector ();
 }
 Vector
 MeshWifiInterfaceMac::GetPeerVelocity (Mac48Address peerAddress)
 {
-  Vector retval;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::const_iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
-    {
-      if (i->first == peerAddress)
-      {
-        retval = i->second.velocity;
-        break;
-      }
-    }
-  return retval;
+  const NeighborInfoUnit * info = FindNeighborInfo (peerAddress);
+  return (info != 0) ? info->velocity : Vector ();
 }
 double
 MeshWifiInterfaceMac::GetPeerRxPower (Mac48Address peerAddress)
 {
-  double retval = -100;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::const_iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
-    {
-      if (i->first == peerAddress)
-      {
-        retval = i->second.rxPowerDbm;
-        break;
-      }
-    }
-  return retval;
+  const NeighborInfoUnit * info = FindNeighborInfo (peerAddress);
+  return (info != 0) ? info->rxPowerDbm : -100;
 }
 Time
 MeshWifiInterfaceMac::GetPeerLastTimeStampGeo (Mac48Address peerAddress)
 {
-  Time lastUpdateTime;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::const_iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
-    {
-      if (i->first == peerAddress)
-      {
-        lastUpdateTime = i->second.lastUpdatedGeo;
-        break;
-      }
-    }
-  return lastUpdateTime;
+  const NeighborInfoUnit * info = FindNeighborInfo (peerAddress);
+  return (info != 0) ? info->lastUpdatedGeo : Time ();
 }
 Time
 MeshWifiInterfaceMac::GetPeerLastTimeStampPower (Mac48Address peerAddress)
 {
-  Time lastUpdateTime;
-  for (std::vector<std::pair<Mac48Address, NeighborInfoUnit> >::const_iterator i = m_neighborsInfo.begin();
-        i != m_neighborsInfo.end(); i++)
-    {
-      if (i->first == peerAddress)
-      {
-        lastUpdateTime = i->second.lastUpdatedPower;
-        break;
-      }
-    }
-    return lastUpdateTime;
+  const NeighborInfoUnit * info = FindNeighborInfo (peerAddress);
+  return (info != 0) ? info->lastUpdatedPower : Time ();
 }
 } // namespace ns3
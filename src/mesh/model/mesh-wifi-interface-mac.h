@@ -27,15 +27,18 @@
 
 #include <stdint.h>
 #include <map>
+#include <list>
 #include "ns3/mac48-address.h"
 #include "ns3/mgt-headers.h"
 #include "ns3/callback.h"
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
 #include "ns3/regular-wifi-mac.h"
+#include "ns3/wifi-phy.h"
 #include "ns3/mesh-wifi-interface-mac-plugin.h"
 #include "ns3/event-id.h"
 #include "ns3/vector.h"
+#include "ns3/mesh-timer-wheel.h"
 
 namespace ns3 {
 
@@ -69,6 +72,7 @@ public:
   virtual void  Enqueue (Ptr<const Packet> packet, Mac48Address to);
   virtual bool  SupportsSendFrom () const;
   virtual void  SetLinkUpCallback (Callback<void> linkUp);
+  virtual void  SetWifiPhy (const Ptr<WifiPhy> phy);
   ///\name Each mesh point interface must know the mesh point address
   // \{
   void SetMeshPointAddress (Mac48Address);
@@ -250,8 +254,11 @@ public:
     Time lastUpdatedGeo;
     Time lastUpdatedPower;
     double pChgRate;  // Power Change Rate
+    Time lastUpdate;  // last time any of the information was updated
+    uint32_t wheelTag; // tag of the neighbor in the expiry wheel
+    std::list<Mac48Address>::iterator lruPosition; // position of the neighbor in the eviction order
     // constructor
-    NeighborInfoUnit (): failAvg(0), pChgRate (0) {}
+    NeighborInfoUnit (): failAvg(0), pChgRate (0), wheelTag (0) {}
   };
 private:
   /**
@@ -261,6 +268,21 @@ private:
    * \param hdr the wifi MAC header
    */
   void Receive (Ptr<Packet> packet, WifiMacHeader const *hdr);
+  /**
+   * PHY MonitorSnifferRx sink. The PHY fires it right before handing the
+   * frame to the MAC, so it carries the rx power of the frame without
+   * tagging every copy of a transmission. MacLow drops some of these frames
+   * (ACKs, frames for other stations, duplicates), so the power is kept
+   * with the packet UID and only used by Receive for the same packet.
+   *
+   * \param packet the received packet
+   * \param channelFreqMhz the channel frequency in MHz
+   * \param txVector the TXVECTOR of the frame
+   * \param aMpdu the A-MPDU information
+   * \param signalNoise the signal and noise power in dBm
+   */
+  void NotifyPhyRx (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                    MpduInfo aMpdu, SignalNoiseDbm signalNoise);
   /**
    * Send frame. Frame is supposed to be tagged by routing information.
    *
@@ -284,9 +306,26 @@ private:
 
 private:
   typedef std::vector<Ptr<MeshWifiInterfaceMacPlugin> > PluginList; ///< PluginList typedef
-  typedef std::vector<std::pair<Mac48Address, NeighborInfoUnit> > NeighborInfoList;
+  typedef std::map<Mac48Address, NeighborInfoUnit> NeighborInfoList;
 
   virtual void DoInitialize ();
+  /**
+   * \param peerAddress the peer address
+   * \returns the information of the peer, created if needed, marked as updated now
+   */
+  NeighborInfoUnit & TouchNeighborInfo (Mac48Address peerAddress);
+  /**
+   * \param peerAddress the peer address
+   * \returns the information of the peer, 0 if there is none
+   */
+  const NeighborInfoUnit * FindNeighborInfo (Mac48Address peerAddress) const;
+  /**
+   * Expiry callback of m_neighborsWheel
+   * \param key the peer address key
+   * \param tag the wheel tag of the peer
+   * \returns the time the peer information becomes stale, or now if it was evicted
+   */
+  Time ExpireNeighborInfo (uint64_t key, uint32_t tag);
 
   ///\name Mesh timing intervals
   // \{
@@ -304,6 +343,26 @@ private:
   Mac48Address m_mpAddress;
   /// List of neighbor information elements (location, velocity, average frame error)
   NeighborInfoList m_neighborsInfo;
+  /// Rx power (dBm, including rx gain) of the frame being passed up by the PHY
+  double m_lastRxPowerDbm;
+  /// UID of the packet m_lastRxPowerDbm was measured for
+  uint64_t m_lastRxPacketUid;
+  /// Whether m_lastRxPowerDbm and m_lastRxPacketUid are set
+  bool m_lastRxPowerValid;
+  /// Evicts the information of neighbors not heard for m_neighborInfoTimeout
+  MeshTimerWheel m_neighborsWheel;
+  /// Addresses of m_neighborsInfo, the neighbor silent for the longest time first
+  std::list<Mac48Address> m_neighborsLru;
+  /// Wheel tag of the next new neighbor
+  uint32_t m_nextNeighborTag;
+  /// How long the information of a silent neighbor is kept, 0 for ever
+  Time m_neighborInfoTimeout;
+  /// Maximum number of neighbors in m_neighborsInfo, 0 for no limit
+  uint32_t m_neighborInfoMaxSize;
+  /// Neighbors evicted because they were silent for m_neighborInfoTimeout
+  uint32_t m_neighborsEvictedExpired;
+  /// Neighbors evicted because m_neighborsInfo was full
+  uint32_t m_neighborsEvictedOverflow;
 
   /// "Timer" for the next beacon
   EventId m_beaconSendEvent;
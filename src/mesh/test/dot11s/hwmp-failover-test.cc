@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/hwmp-protocol.h"
+#include "ns3/hwmp-rtable.h"
+
+using namespace ns3;
+using namespace dot11s;
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief A failed peer link leaves no gap in a multipath reactive route
+ *
+ * The path to a destination has a primary and an alternative next hop.
+ * When the peer link to the primary fails, the route must be valid
+ * through the alternative at the same simulation time, so packets are
+ * forwarded without waiting for a new route discovery. With a single next
+ * hop, the route is removed and the packets wait for a PREQ/PREP round
+ * trip, as before multipath.
+ */
+class HwmpFailOverPeerTest : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param maxAlternatives alternatives kept per route, 0 for a single next hop
+   */
+  HwmpFailOverPeerTest (uint32_t maxAlternatives);
+  virtual ~HwmpFailOverPeerTest ();
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_maxAlternatives; ///< alternatives kept per route
+};
+
+HwmpFailOverPeerTest::HwmpFailOverPeerTest (uint32_t maxAlternatives)
+  : TestCase (maxAlternatives > 0 ? "Peer link failure moves the route to its alternative at once"
+              : "Peer link failure removes a single next hop route"),
+    m_maxAlternatives (maxAlternatives)
+{
+}
+
+HwmpFailOverPeerTest::~HwmpFailOverPeerTest ()
+{
+}
+
+void
+HwmpFailOverPeerTest::DoRun (void)
+{
+  Mac48Address self ("00:00:00:00:00:01");
+  Mac48Address primary ("00:00:00:00:00:10");
+  Mac48Address alternative ("00:00:00:00:00:11");
+  Mac48Address destination ("00:00:00:00:00:20");
+  Mac48Address other ("00:00:00:00:00:21");
+
+  Ptr<HwmpProtocol> hwmp = CreateObject<HwmpProtocol> ();
+  Ptr<HwmpRtable> rtable = hwmp->GetRoutingTable ();
+  rtable->SetMaxAlternatives (m_maxAlternatives);
+  rtable->AddReactivePath (destination, primary, 1, 100, Seconds (10), 5);
+  NS_TEST_ASSERT_MSG_EQ (rtable->AddAlternativePath (destination, alternative, 2, 150, 50, Seconds (10), 5),
+                         m_maxAlternatives > 0, "Alternative kept only in multipath mode");
+  //A route through a peer that stays up is not touched
+  rtable->AddReactivePath (other, alternative, 2, 100, Seconds (10), 3);
+
+  hwmp->PeerLinkStatus (self, primary, 1, false);
+
+  HwmpRtable::LookupResult result = rtable->LookupReactive (destination);
+  if (m_maxAlternatives > 0)
+    {
+      NS_TEST_ASSERT_MSG_EQ (result.IsValid (), true, "Route still valid right after the failure");
+      NS_TEST_ASSERT_MSG_EQ (result.retransmitter, alternative, "Route moved to the alternative");
+      NS_TEST_ASSERT_MSG_EQ (result.ifIndex, 2, "Interface of the alternative");
+      NS_TEST_ASSERT_MSG_EQ (result.metric, 150, "Metric of the alternative");
+      NS_TEST_ASSERT_MSG_EQ (result.seqnum, 5, "Sequence number kept");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (result.IsValid (), false, "Route waits for a new discovery");
+    }
+  NS_TEST_ASSERT_MSG_EQ (rtable->LookupReactive (other).retransmitter, alternative, "Other route kept");
+
+  hwmp->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief An expired primary next hop is renewed from an alternative
+ *
+ * The primary next hop expires before the alternative. The route must be
+ * renewed from the alternative instead of triggering a route discovery.
+ */
+class HwmpRenewFromAlternativeTest : public TestCase
+{
+public:
+  HwmpRenewFromAlternativeTest ();
+  virtual ~HwmpRenewFromAlternativeTest ();
+
+private:
+  virtual void DoRun (void);
+  /// Check the route once the primary has expired
+  void CheckExpired (void);
+
+  Ptr<HwmpRtable> m_rtable; ///< the routing table
+  Mac48Address m_destination; ///< the destination
+  Mac48Address m_alternative; ///< the alternative next hop
+};
+
+HwmpRenewFromAlternativeTest::HwmpRenewFromAlternativeTest ()
+  : TestCase ("Expired next hop renewed from an alternative"),
+    m_destination ("00:00:00:00:00:20"),
+    m_alternative ("00:00:00:00:00:11")
+{
+}
+
+HwmpRenewFromAlternativeTest::~HwmpRenewFromAlternativeTest ()
+{
+}
+
+void
+HwmpRenewFromAlternativeTest::CheckExpired (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_rtable->LookupReactive (m_destination).IsValid (), false, "Primary next hop expired");
+  NS_TEST_ASSERT_MSG_EQ (m_rtable->RenewFromAlternative (m_destination), true, "Alternative promoted");
+  HwmpRtable::LookupResult result = m_rtable->LookupReactive (m_destination);
+  NS_TEST_ASSERT_MSG_EQ (result.IsValid (), true, "Route valid again");
+  NS_TEST_ASSERT_MSG_EQ (result.retransmitter, m_alternative, "Route through the alternative");
+}
+
+void
+HwmpRenewFromAlternativeTest::DoRun (void)
+{
+  m_rtable = CreateObject<HwmpRtable> ();
+  m_rtable->SetMaxAlternatives (2);
+  m_rtable->AddReactivePath (m_destination, Mac48Address ("00:00:00:00:00:10"), 1, 100, Seconds (1), 5);
+  m_rtable->AddAlternativePath (m_destination, m_alternative, 1, 150, 50, Seconds (5), 5);
+
+  Simulator::Schedule (Seconds (2), &HwmpRenewFromAlternativeTest::CheckExpired, this);
+  Simulator::Run ();
+
+  m_rtable->Dispose ();
+  m_rtable = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HWMP multipath failover test suite
+ */
+class HwmpFailOverTestSuite : public TestSuite
+{
+public:
+  HwmpFailOverTestSuite ();
+};
+
+HwmpFailOverTestSuite::HwmpFailOverTestSuite ()
+  : TestSuite ("devices-mesh-dot11s-hwmp-failover", UNIT)
+{
+  AddTestCase (new HwmpFailOverPeerTest (2), TestCase::QUICK);
+  AddTestCase (new HwmpFailOverPeerTest (0), TestCase::QUICK);
+  AddTestCase (new HwmpRenewFromAlternativeTest, TestCase::QUICK);
+}
+
+static HwmpFailOverTestSuite g_hwmpFailOverTestSuite; ///< the test suite
@@ -0,0 +1,256 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/hwmp-protocol.h"
+#include "ns3/ie-lpp.h"
+
+using namespace ns3;
+using namespace dot11s;
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief The elements of a neighbor list sent in one frame fit an MMPDU
+ *
+ * IeLpp::MAX_FRAGMENTS_PER_FRAME elements with the longest neighbor
+ * records, and the action header, must fit in 2304 bytes.
+ */
+class IeLppFrameSizeTest : public TestCase
+{
+public:
+  IeLppFrameSizeTest ();
+  virtual ~IeLppFrameSizeTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+IeLppFrameSizeTest::IeLppFrameSizeTest ()
+  : TestCase ("LPP elements of one frame fit in an MMPDU")
+{
+}
+
+IeLppFrameSizeTest::~IeLppFrameSizeTest ()
+{
+}
+
+void
+IeLppFrameSizeTest::DoRun (void)
+{
+  IeLpp lpp;
+  //Addresses without a common prefix take the 7 byte records
+  uint8_t address[6] = { 0, 0, 0, 0, 0, 0 };
+  Mac48Address neighbor;
+  for (uint8_t i = 1; ; i++)
+    {
+      address[0] = i;
+      address[5] = i;
+      neighbor.CopyFrom (address);
+      if (!lpp.AddToNeighborsList (neighbor, IeLpp::MAX_LPP_COUNT))
+        {
+          break;
+        }
+    }
+  NS_TEST_ASSERT_MSG_GT (lpp.GetNumberNeighbors (), 30, "Element filled with neighbors");
+  uint32_t actionHeaderSize = 2;
+  uint32_t frameSize = IeLpp::MAX_FRAGMENTS_PER_FRAME * (uint32_t) lpp.GetSerializedSize () + actionHeaderSize;
+  NS_TEST_ASSERT_MSG_LT (frameSize, 2304 + 1, "Frame larger than an MMPDU");
+  NS_TEST_ASSERT_MSG_GT (frameSize + lpp.GetSerializedSize (), 2304, "A frame could carry more elements");
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief NeighborEtx::FillLppCntData adds the neighbors in address order
+ *
+ * The neighbors are heard in an order where no address shares its leading
+ * bytes with the previous one. Sorted, the second address shares five
+ * bytes with the first, so the element is 5 bytes shorter.
+ */
+class NeighborEtxLppOrderTest : public TestCase
+{
+public:
+  NeighborEtxLppOrderTest ();
+  virtual ~NeighborEtxLppOrderTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NeighborEtxLppOrderTest::NeighborEtxLppOrderTest ()
+  : TestCase ("LPP neighbor list filled in address order")
+{
+}
+
+NeighborEtxLppOrderTest::~NeighborEtxLppOrderTest ()
+{
+}
+
+void
+NeighborEtxLppOrderTest::DoRun (void)
+{
+  Mac48Address a ("00:00:01:00:00:01");
+  Mac48Address b ("00:00:02:00:00:01");
+  Mac48Address c ("00:00:01:00:00:02");
+
+  NeighborEtx etx;
+  //A time slot counted by the LPP counts, see NeighborEtx::m_countMask
+  etx.UpdateNeighborEtx (a, 5, 1);
+  etx.UpdateNeighborEtx (b, 5, 1);
+  etx.UpdateNeighborEtx (c, 5, 1);
+  std::vector<IeLpp> lpp;
+  etx.FillLppCntData (lpp);
+
+  NS_TEST_ASSERT_MSG_EQ (lpp.size (), 1, "One element");
+  NS_TEST_ASSERT_MSG_EQ (lpp[0].GetNumberNeighbors (), 3, "All neighbors listed");
+  //a and b in full, c as the last byte after a
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) lpp[0].GetInformationFieldSize (), 12 + 7 + 2 + 7, "Neighbors not sorted");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) lpp[0].FindReverseCount (c), 1, "c listed");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HwmpProtocol::ReceiveLpp joins a neighbor list sent in several frames
+ *
+ * A list of 10 elements arrives in a frame with the first 8 and a frame
+ * with the last 2, the receiver being listed in the last element. The ETX
+ * of the sender is only updated once both frames arrived, with the count
+ * found in the second one. Frames of different LPPs are not joined.
+ */
+class HwmpLppReassemblyTest : public TestCase
+{
+public:
+  HwmpLppReassemblyTest ();
+  virtual ~HwmpLppReassemblyTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Build the elements of a neighbor list
+   * \param seqno the originator sequence number
+   * \param first the index of the first element
+   * \param last the index after the last element
+   * \returns the elements
+   */
+  std::vector<Ptr<IeLpp> > MakeFrame (uint32_t seqno, uint8_t first, uint8_t last);
+
+  Mac48Address m_self; ///< the receiver
+  Mac48Address m_origin; ///< the sender
+};
+
+HwmpLppReassemblyTest::HwmpLppReassemblyTest ()
+  : TestCase ("LPP neighbor list sent in several frames is joined by LPP ID and seqno"),
+    m_origin ("00:00:00:00:01:00")
+{
+}
+
+HwmpLppReassemblyTest::~HwmpLppReassemblyTest ()
+{
+}
+
+std::vector<Ptr<IeLpp> >
+HwmpLppReassemblyTest::MakeFrame (uint32_t seqno, uint8_t first, uint8_t last)
+{
+  const uint8_t count = 10;
+  std::vector<Ptr<IeLpp> > frame;
+  for (uint8_t k = first; k < last; k++)
+    {
+      Ptr<IeLpp> lpp = Create<IeLpp> ();
+      lpp->SetLppId (5);
+      lpp->SetOriginAddress (m_origin);
+      lpp->SetOriginSeqno (seqno);
+      lpp->SetFragment (k, count);
+      uint8_t address[6] = { 0x02, 0, 0, 0, k, 0 };
+      for (uint8_t i = 1; i <= 20; i++)
+        {
+          address[5] = i;
+          Mac48Address neighbor;
+          neighbor.CopyFrom (address);
+          lpp->AddToNeighborsList (neighbor, 3);
+        }
+      if (k == count - 1)
+        {
+          lpp->AddToNeighborsList (m_self, 9);
+        }
+      frame.push_back (lpp);
+    }
+  return frame;
+}
+
+void
+HwmpLppReassemblyTest::DoRun (void)
+{
+  Ptr<HwmpProtocol> hwmp = CreateObject<HwmpProtocol> ();
+  m_self = hwmp->GetAddress ();
+  //ETX of the sender after a complete LPP, and without any
+  NeighborEtx expected;
+  uint32_t unknownEtx = expected.GetEtxForNeighbor (m_origin);
+  expected.UpdateNeighborEtx (m_origin, 5, 9);
+  uint32_t completeEtx = expected.GetEtxForNeighbor (m_origin);
+  NS_TEST_ASSERT_MSG_NE (completeEtx, unknownEtx, "The reverse count must change the ETX");
+
+  //Frames of two different LPPs
+  hwmp->ReceiveLpp (MakeFrame (1, 0, 8), m_origin, 1, m_origin);
+  hwmp->ReceiveLpp (MakeFrame (2, 8, 10), m_origin, 1, m_origin);
+  NS_TEST_ASSERT_MSG_EQ (hwmp->m_nbEtx.GetEtxForNeighbor (m_origin), unknownEtx, "Parts of different LPPs joined");
+
+  //The first frame of the second LPP completes it
+  hwmp->ReceiveLpp (MakeFrame (2, 0, 8), m_origin, 1, m_origin);
+  NS_TEST_ASSERT_MSG_EQ (hwmp->m_nbEtx.GetEtxForNeighbor (m_origin), completeEtx, "Parts of one LPP not joined");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->m_lppParts.size (), 0, "Completed list not released");
+
+  //A repeated frame does not complete a list
+  hwmp->ReceiveLpp (MakeFrame (3, 0, 8), m_origin, 1, m_origin);
+  hwmp->ReceiveLpp (MakeFrame (3, 0, 8), m_origin, 1, m_origin);
+  NS_TEST_ASSERT_MSG_EQ (hwmp->m_lppParts.size (), 1, "Incomplete list kept");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->m_lppParts.begin ()->second.received, 0xff, "Parts of the first frame only");
+
+  hwmp->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HWMP LPP test suite
+ */
+class HwmpLppTestSuite : public TestSuite
+{
+public:
+  HwmpLppTestSuite ();
+};
+
+HwmpLppTestSuite::HwmpLppTestSuite ()
+  : TestSuite ("devices-mesh-dot11s-hwmp-lpp", UNIT)
+{
+  AddTestCase (new IeLppFrameSizeTest, TestCase::QUICK);
+  AddTestCase (new HwmpLppReassemblyTest, TestCase::QUICK);
+  AddTestCase (new NeighborEtxLppOrderTest, TestCase::QUICK);
+}
+
+static HwmpLppTestSuite g_hwmpLppTestSuite; ///< the test suite
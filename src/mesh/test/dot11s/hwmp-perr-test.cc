@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/hwmp-protocol.h"
+#include "ns3/hwmp-protocol-mac.h"
+#include "ns3/hwmp-rtable.h"
+
+using namespace ns3;
+using namespace dot11s;
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HwmpProtocol::GetPerrReceivers lists every precursor once
+ *
+ * A precursor of several failed destinations, here three, is a PERR
+ * receiver once, on the interface of the first destination it was listed
+ * for. The receivers keep the order in which they were first seen.
+ */
+class HwmpPerrReceiversTest : public TestCase
+{
+public:
+  HwmpPerrReceiversTest ();
+  virtual ~HwmpPerrReceiversTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+HwmpPerrReceiversTest::HwmpPerrReceiversTest ()
+  : TestCase ("PERR receivers listed for several destinations appear once")
+{
+}
+
+HwmpPerrReceiversTest::~HwmpPerrReceiversTest ()
+{
+}
+
+void
+HwmpPerrReceiversTest::DoRun (void)
+{
+  Mac48Address next ("00:00:00:00:00:10");
+  Mac48Address p ("00:00:00:00:00:20");
+  Mac48Address q ("00:00:00:00:00:21");
+  Mac48Address r ("00:00:00:00:00:22");
+  Mac48Address d1 ("00:00:00:00:00:01");
+  Mac48Address d2 ("00:00:00:00:00:02");
+  Mac48Address d3 ("00:00:00:00:00:03");
+  Mac48Address other ("00:00:00:00:00:04");
+
+  Ptr<HwmpProtocol> hwmp = CreateObject<HwmpProtocol> ();
+  Ptr<HwmpRtable> rtable = hwmp->GetRoutingTable ();
+  rtable->AddReactivePath (d1, next, 1, 10, Seconds (10), 1);
+  rtable->AddReactivePath (d2, next, 2, 10, Seconds (10), 1);
+  rtable->AddReactivePath (d3, next, 3, 10, Seconds (10), 1);
+  rtable->AddReactivePath (other, next, 1, 10, Seconds (10), 1);
+  //p is a precursor of the three destinations, on a different interface each
+  rtable->AddPrecursor (d1, 1, p, Seconds (10));
+  rtable->AddPrecursor (d1, 1, q, Seconds (10));
+  rtable->AddPrecursor (d2, 2, p, Seconds (10));
+  rtable->AddPrecursor (d3, 3, r, Seconds (10));
+  rtable->AddPrecursor (d3, 3, p, Seconds (10));
+  rtable->AddPrecursor (d3, 3, q, Seconds (10));
+  rtable->AddPrecursor (other, 1, r, Seconds (10));
+
+  std::vector<HwmpProtocol::FailedDestination> failed;
+  HwmpProtocol::FailedDestination destination;
+  destination.seqnum = 2;
+  destination.destination = d1;
+  failed.push_back (destination);
+  destination.destination = d2;
+  failed.push_back (destination);
+  destination.destination = d3;
+  failed.push_back (destination);
+
+  std::vector<std::pair<uint32_t, Mac48Address> > receivers = hwmp->GetPerrReceivers (failed);
+  NS_TEST_ASSERT_MSG_EQ (receivers.size (), 3, "p, q and r, once each");
+  NS_TEST_ASSERT_MSG_EQ (receivers[0].second, p, "p first");
+  NS_TEST_ASSERT_MSG_EQ (receivers[0].first, 1, "p on the interface of d1");
+  NS_TEST_ASSERT_MSG_EQ (receivers[1].second, q, "q second");
+  NS_TEST_ASSERT_MSG_EQ (receivers[1].first, 1, "q on the interface of d1");
+  NS_TEST_ASSERT_MSG_EQ (receivers[2].second, r, "r last");
+  NS_TEST_ASSERT_MSG_EQ (receivers[2].first, 3, "r on the interface of d3");
+
+  //The failed paths are gone, the others are kept
+  NS_TEST_ASSERT_MSG_EQ (rtable->LookupReactive (d1).retransmitter, Mac48Address::GetBroadcast (), "d1 deleted");
+  NS_TEST_ASSERT_MSG_EQ (rtable->LookupReactive (d2).retransmitter, Mac48Address::GetBroadcast (), "d2 deleted");
+  NS_TEST_ASSERT_MSG_EQ (rtable->LookupReactive (d3).retransmitter, Mac48Address::GetBroadcast (), "d3 deleted");
+  NS_TEST_ASSERT_MSG_EQ (rtable->LookupReactive (other).retransmitter, next, "other kept");
+
+  hwmp->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HwmpProtocolMac::MyPerr keeps one entry per destination and receiver
+ *
+ * A destination reported again before the PERR is sent keeps its position
+ * and takes the newer sequence number; an older one is ignored. A receiver
+ * added twice is listed once.
+ */
+class HwmpMyPerrTest : public TestCase
+{
+public:
+  HwmpMyPerrTest ();
+  virtual ~HwmpMyPerrTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Add a failed destination to m_perr
+   * \param address the destination
+   * \param seqnum its sequence number
+   * \returns the value returned by AddDestination
+   */
+  bool AddDestination (Mac48Address address, uint32_t seqnum);
+
+  HwmpProtocolMac::MyPerr m_perr; ///< the PERR being built
+};
+
+HwmpMyPerrTest::HwmpMyPerrTest ()
+  : TestCase ("PERR destinations reported again keep one entry with the newer seqnum")
+{
+}
+
+HwmpMyPerrTest::~HwmpMyPerrTest ()
+{
+}
+
+bool
+HwmpMyPerrTest::AddDestination (Mac48Address address, uint32_t seqnum)
+{
+  HwmpProtocol::FailedDestination destination;
+  destination.destination = address;
+  destination.seqnum = seqnum;
+  return m_perr.AddDestination (destination);
+}
+
+void
+HwmpMyPerrTest::DoRun (void)
+{
+  Mac48Address d ("00:00:00:00:00:01");
+  Mac48Address e ("00:00:00:00:00:02");
+  Mac48Address f ("00:00:00:00:00:03");
+
+  NS_TEST_ASSERT_MSG_EQ (AddDestination (d, 5), true, "d added");
+  NS_TEST_ASSERT_MSG_EQ (AddDestination (e, 7), true, "e added");
+  NS_TEST_ASSERT_MSG_EQ (AddDestination (d, 9), false, "d already present");
+  NS_TEST_ASSERT_MSG_EQ (AddDestination (e, 6), false, "e already present");
+  //Sequence numbers compare modulo 2^32
+  NS_TEST_ASSERT_MSG_EQ (AddDestination (f, 0xfffffffe), true, "f added");
+  NS_TEST_ASSERT_MSG_EQ (AddDestination (f, 1), false, "f already present");
+
+  NS_TEST_ASSERT_MSG_EQ (m_perr.destinations.size (), 3, "One entry per destination");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.destinations[0].destination, d, "d keeps its position");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.destinations[0].seqnum, 9, "d takes the newer seqnum");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.destinations[1].destination, e, "e keeps its position");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.destinations[1].seqnum, 7, "e ignores the older seqnum");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.destinations[2].destination, f, "f last");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.destinations[2].seqnum, 1, "f takes the wrapped around seqnum");
+
+  Mac48Address p ("00:00:00:00:00:20");
+  Mac48Address q ("00:00:00:00:00:21");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.AddReceiver (p), true, "p added");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.AddReceiver (q), true, "q added");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.AddReceiver (p), false, "p already present");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.receivers.size (), 2, "One entry per receiver");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.receivers[0], p, "p first");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.receivers[1], q, "q second");
+
+  m_perr.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (AddDestination (d, 3), true, "d added again after Clear");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.AddReceiver (p), true, "p added again after Clear");
+  NS_TEST_ASSERT_MSG_EQ (m_perr.destinations[0].seqnum, 3, "No seqnum left from before Clear");
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HWMP PERR test suite
+ */
+class HwmpPerrTestSuite : public TestSuite
+{
+public:
+  HwmpPerrTestSuite ();
+};
+
+HwmpPerrTestSuite::HwmpPerrTestSuite ()
+  : TestSuite ("devices-mesh-dot11s-hwmp-perr", UNIT)
+{
+  AddTestCase (new HwmpPerrReceiversTest, TestCase::QUICK);
+  AddTestCase (new HwmpMyPerrTest, TestCase::QUICK);
+}
+
+static HwmpPerrTestSuite g_hwmpPerrTestSuite; ///< the test suite
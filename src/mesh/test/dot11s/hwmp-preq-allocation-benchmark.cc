@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/buffer.h"
+#include "ns3/hwmp-protocol.h"
+#include "ns3/hwmp-rtable.h"
+#include "ns3/ie-dot11s-preq.h"
+#include <cstdlib>
+#include <new>
+#include <iostream>
+#include <iomanip>
+
+using namespace ns3;
+using namespace dot11s;
+
+namespace {
+/// Whether the global operator new counts its calls
+bool g_countAllocations = false;
+/// Calls to the global operator new while g_countAllocations is set
+uint64_t g_allocations = 0;
+} // namespace
+
+/**
+ * Global operator new of the test runner, counting its calls while
+ * g_countAllocations is set. Operator new[] and the allocators of the
+ * standard containers go through it.
+ * \param size the number of bytes
+ * \returns the allocated memory
+ */
+void *
+operator new (std::size_t size)
+{
+  if (g_countAllocations)
+    {
+      g_allocations++;
+    }
+  void * p = std::malloc (size != 0 ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+/**
+ * Global operator delete matching the counting operator new
+ * \param p the memory to free
+ */
+void
+operator delete (void * p) noexcept
+{
+  std::free (p);
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief Heap allocations per PREQ received by HwmpProtocol
+ *
+ * The element is deserialized as MeshInformationElementVector does for
+ * HwmpProtocolMac::ReceiveAction, then handed to HwmpProtocol::ReceivePreq.
+ * Every PREQ comes from the same originator with a newer sequence number,
+ * so it is accepted, updates the routes to the originator and the previous
+ * hop, and is to be forwarded. The protocol has no interface, so the
+ * packets of the forwarded PREQ, and the packet the element was received
+ * in, are not counted. The counts are printed, not checked.
+ */
+class HwmpPreqAllocationBenchmark : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param nDestinations the number of destinations of the PREQ
+   */
+  HwmpPreqAllocationBenchmark (uint8_t nDestinations);
+  virtual ~HwmpPreqAllocationBenchmark ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Deserialize a received PREQ
+   * \param buffer the information field of the PREQ
+   * \param seqno the originator sequence number of the received PREQ
+   * \returns the element
+   */
+  Ptr<IePreq> Deserialize (const Buffer & buffer, uint32_t seqno);
+
+  uint8_t m_nDestinations; ///< destinations of the PREQ
+};
+
+HwmpPreqAllocationBenchmark::HwmpPreqAllocationBenchmark (uint8_t nDestinations)
+  : TestCase ("Heap allocations per received PREQ with " + std::to_string (nDestinations) + " destinations"),
+    m_nDestinations (nDestinations)
+{
+}
+
+HwmpPreqAllocationBenchmark::~HwmpPreqAllocationBenchmark ()
+{
+}
+
+Ptr<IePreq>
+HwmpPreqAllocationBenchmark::Deserialize (const Buffer & buffer, uint32_t seqno)
+{
+  Ptr<IePreq> preq = Create<IePreq> ();
+  preq->DeserializeInformationField (buffer.Begin (), buffer.GetSize ());
+  //A new PREQ of the originator
+  preq->SetOriginatorSeqNumber (seqno);
+  preq->DecrementTtl ();
+  return preq;
+}
+
+void
+HwmpPreqAllocationBenchmark::DoRun (void)
+{
+  const uint32_t nPreqs = 10000;
+  Mac48Address originator ("00:00:00:00:01:00");
+  Mac48Address from ("00:00:00:00:01:01");
+
+  //The allocations below must go through the counting operator new
+  g_allocations = 0;
+  g_countAllocations = true;
+  void * probe = ::operator new (1);
+  g_countAllocations = false;
+  ::operator delete (probe);
+  NS_TEST_ASSERT_MSG_EQ (g_allocations, 1, "The counting operator new is not used");
+
+  IePreq sent;
+  sent.SetOriginatorAddress (originator);
+  sent.SetTTL (32);
+  sent.SetLifetime (5000);
+  for (uint8_t i = 0; i < m_nDestinations; i++)
+    {
+      //Unknown destinations, the PREQ is not answered
+      uint8_t address[6] = { 0, 0, 0, 0, 2, 0 };
+      address[5] = i;
+      Mac48Address destination;
+      destination.CopyFrom (address);
+      sent.AddDestinationAddressElement (true, false, destination, 1);
+    }
+  Buffer buffer;
+  buffer.AddAtStart (sent.GetInformationFieldSize ());
+  sent.SerializeInformationField (buffer.Begin ());
+
+  Ptr<HwmpProtocol> hwmp = CreateObject<HwmpProtocol> ();
+  //The first PREQ creates the routes and the sequence number entry
+  hwmp->ReceivePreq (*Deserialize (buffer, 1), from, 1, from, 100);
+
+  uint64_t receiveAllocations = 0;
+  g_allocations = 0;
+  for (uint32_t i = 0; i < nPreqs; i++)
+    {
+      g_countAllocations = true;
+      Ptr<IePreq> preq = Deserialize (buffer, i + 2);
+      uint64_t elementAllocations = g_allocations;
+      hwmp->ReceivePreq (*preq, from, 1, from, 100);
+      receiveAllocations += g_allocations - elementAllocations;
+      g_countAllocations = false;
+    }
+  uint64_t allAllocations = g_allocations;
+
+  std::cout << std::fixed << std::setprecision (2)
+            << "PREQ with " << (uint32_t) m_nDestinations << " destinations: "
+            << (double) allAllocations / nPreqs << " allocations per received PREQ, "
+            << (double) receiveAllocations / nPreqs << " in HwmpProtocol::ReceivePreq" << std::endl;
+
+  NS_TEST_ASSERT_MSG_EQ (hwmp->GetRoutingTable ()->LookupReactive (originator).seqnum, nPreqs + 1,
+                         "Every PREQ accepted");
+  hwmp->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HWMP PREQ allocation benchmark suite
+ *
+ * The counts are printed by
+ * ./waf --run "test-runner --suite=devices-mesh-dot11s-hwmp-preq-allocation-benchmark".
+ */
+class HwmpPreqAllocationBenchmarkSuite : public TestSuite
+{
+public:
+  HwmpPreqAllocationBenchmarkSuite ();
+};
+
+HwmpPreqAllocationBenchmarkSuite::HwmpPreqAllocationBenchmarkSuite ()
+  : TestSuite ("devices-mesh-dot11s-hwmp-preq-allocation-benchmark", PERFORMANCE)
+{
+  AddTestCase (new HwmpPreqAllocationBenchmark (1), TestCase::QUICK);
+  AddTestCase (new HwmpPreqAllocationBenchmark (2), TestCase::QUICK);
+  AddTestCase (new HwmpPreqAllocationBenchmark (4), TestCase::QUICK);
+}
+
+static HwmpPreqAllocationBenchmarkSuite g_hwmpPreqAllocationBenchmarkSuite; ///< the test suite
@@ -0,0 +1,315 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/hwmp-protocol.h"
+
+using namespace ns3;
+using namespace dot11s;
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief Packet limits of the HWMP route discovery queue
+ *
+ * With MaxQueueSize 4, 5 packets fit in the queue, as in the original
+ * queue. A destination holds MaxQueueSizePerDestination packets at most,
+ * and the queue MaxQueueBytes at most. The packets are dequeued in
+ * arrival order, whatever their destination.
+ */
+class HwmpQueueLimitsTest : public TestCase
+{
+public:
+  HwmpQueueLimitsTest ();
+  virtual ~HwmpQueueLimitsTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Queue a packet
+   * \param hwmp the protocol
+   * \param dst the destination of the packet
+   * \param size the size of the packet
+   * \returns the value returned by QueuePacket
+   */
+  bool Enqueue (Ptr<HwmpProtocol> hwmp, Mac48Address dst, uint32_t size);
+  /**
+   * Sink of the QueueDrop trace
+   * \param packet the dropped packet
+   * \param destination its destination
+   * \param reason why it was dropped
+   */
+  void QueueDrop (Ptr<const Packet> packet, Mac48Address destination, HwmpProtocol::QueueDropReason reason);
+
+  uint32_t m_queueOverflows; ///< packets dropped with QUEUE_OVERFLOW
+  uint32_t m_destinationOverflows; ///< packets dropped with DESTINATION_OVERFLOW
+};
+
+HwmpQueueLimitsTest::HwmpQueueLimitsTest ()
+  : TestCase ("Route discovery queue limits per destination, in packets and in bytes"),
+    m_queueOverflows (0),
+    m_destinationOverflows (0)
+{
+}
+
+HwmpQueueLimitsTest::~HwmpQueueLimitsTest ()
+{
+}
+
+bool
+HwmpQueueLimitsTest::Enqueue (Ptr<HwmpProtocol> hwmp, Mac48Address dst, uint32_t size)
+{
+  HwmpProtocol::QueuedPacket packet;
+  packet.pkt = Create<Packet> (size);
+  packet.src = Mac48Address ("00:00:00:00:00:01");
+  packet.dst = dst;
+  return hwmp->QueuePacket (packet);
+}
+
+void
+HwmpQueueLimitsTest::QueueDrop (Ptr<const Packet> packet, Mac48Address destination, HwmpProtocol::QueueDropReason reason)
+{
+  if (reason == HwmpProtocol::QUEUE_OVERFLOW)
+    {
+      m_queueOverflows++;
+    }
+  else if (reason == HwmpProtocol::DESTINATION_OVERFLOW)
+    {
+      m_destinationOverflows++;
+    }
+}
+
+void
+HwmpQueueLimitsTest::DoRun (void)
+{
+  Mac48Address d1 ("00:00:00:00:00:11");
+  Mac48Address d2 ("00:00:00:00:00:12");
+  Mac48Address d3 ("00:00:00:00:00:13");
+  Mac48Address d4 ("00:00:00:00:00:14");
+
+  Ptr<HwmpProtocol> hwmp = CreateObject<HwmpProtocol> ();
+  hwmp->SetAttribute ("MaxQueueSize", UintegerValue (4));
+  hwmp->SetAttribute ("MaxQueueSizePerDestination", UintegerValue (2));
+  hwmp->TraceConnectWithoutContext ("QueueDrop", MakeCallback (&HwmpQueueLimitsTest::QueueDrop, this));
+
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d1, 100), true, "First packet to d1");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d2, 100), true, "First packet to d2");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d1, 100), true, "Second packet to d1");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d1, 100), false, "Third packet to d1");
+  NS_TEST_ASSERT_MSG_EQ (m_destinationOverflows, 1, "Dropped for its destination");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d2, 100), true, "Second packet to d2");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d3, 100), true, "First packet to d3");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->m_rqueuePackets, 5, "MaxQueueSize + 1 packets queued");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d4, 100), false, "Packet to d4 with the queue full");
+  NS_TEST_ASSERT_MSG_EQ (m_queueOverflows, 1, "Dropped for the queue");
+
+  //A packet dequeued by destination frees a place for that destination
+  NS_TEST_ASSERT_MSG_EQ (hwmp->DequeueFirstPacketByDst (d1).dst, d1, "Packet to d1 dequeued");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d1, 100), true, "Packet to d1 queued again");
+  NS_TEST_ASSERT_MSG_EQ (m_destinationOverflows, 1, "No other drop for its destination");
+
+  //Arrival order: d2, d1, d2, d3, d1
+  NS_TEST_ASSERT_MSG_EQ (hwmp->DequeueFirstPacket ().dst, d2, "First arrived");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->DequeueFirstPacket ().dst, d1, "Second arrived");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->DequeueFirstPacket ().dst, d2, "Third arrived");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->DequeueFirstPacket ().dst, d3, "Fourth arrived");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->DequeueFirstPacket ().dst, d1, "Fifth arrived");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->DequeueFirstPacket ().pkt, 0, "Queue empty");
+  NS_TEST_ASSERT_MSG_EQ (hwmp->m_rqueueBytes, 0, "No bytes left");
+  hwmp->Dispose ();
+
+  hwmp = CreateObject<HwmpProtocol> ();
+  hwmp->SetAttribute ("MaxQueueBytes", UintegerValue (250));
+  hwmp->TraceConnectWithoutContext ("QueueDrop", MakeCallback (&HwmpQueueLimitsTest::QueueDrop, this));
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d1, 100), true, "100 bytes queued");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d2, 100), true, "200 bytes queued");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d3, 100), false, "300 bytes exceed MaxQueueBytes");
+  NS_TEST_ASSERT_MSG_EQ (Enqueue (hwmp, d3, 50), true, "250 bytes queued");
+  NS_TEST_ASSERT_MSG_EQ (m_queueOverflows, 2, "Dropped for the bytes of the queue");
+  hwmp->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief Packets waiting longer than MaxQueueTime are dropped on time
+ *
+ * With MaxQueueTime 1 s, a packet queued at 0 s and one queued at 0.5 s
+ * are dropped right after 1 s and 1.5 s, without any other queue
+ * operation, and their senders are told. A packet dequeued before its
+ * time is not dropped.
+ */
+class HwmpQueueTimeoutTest : public TestCase
+{
+public:
+  HwmpQueueTimeoutTest ();
+  virtual ~HwmpQueueTimeoutTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Queue a packet
+   * \param dst the destination of the packet
+   */
+  void Enqueue (Mac48Address dst);
+  /**
+   * Dequeue the packet of a destination
+   * \param dst the destination
+   */
+  void Dequeue (Mac48Address dst);
+  /**
+   * Check the queue
+   * \param packets the expected number of queued packets
+   * \param timeouts the expected number of packets dropped for their age
+   */
+  void Check (uint32_t packets, uint32_t timeouts);
+  /**
+   * Route reply callback of the queued packets
+   * \param success whether a route was found
+   * \param packet the packet
+   * \param src its source
+   * \param dst its destination
+   * \param protocol its protocol
+   * \param outInterface the outgoing interface
+   */
+  void Reply (bool success, Ptr<Packet> packet, Mac48Address src, Mac48Address dst, uint16_t protocol,
+              uint32_t outInterface);
+  /**
+   * Sink of the QueueDrop trace
+   * \param packet the dropped packet
+   * \param destination its destination
+   * \param reason why it was dropped
+   */
+  void QueueDrop (Ptr<const Packet> packet, Mac48Address destination, HwmpProtocol::QueueDropReason reason);
+
+  Ptr<HwmpProtocol> m_hwmp; ///< the protocol
+  uint32_t m_timeouts; ///< packets dropped with QUEUE_TIMEOUT
+  uint32_t m_failedReplies; ///< replies telling the sender that the packet was dropped
+};
+
+HwmpQueueTimeoutTest::HwmpQueueTimeoutTest ()
+  : TestCase ("Route discovery queue drops packets waiting longer than MaxQueueTime on time"),
+    m_timeouts (0),
+    m_failedReplies (0)
+{
+}
+
+HwmpQueueTimeoutTest::~HwmpQueueTimeoutTest ()
+{
+}
+
+void
+HwmpQueueTimeoutTest::Enqueue (Mac48Address dst)
+{
+  HwmpProtocol::QueuedPacket packet;
+  packet.pkt = Create<Packet> (100);
+  packet.src = Mac48Address ("00:00:00:00:00:01");
+  packet.dst = dst;
+  packet.reply = MakeCallback (&HwmpQueueTimeoutTest::Reply, this);
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp->QueuePacket (packet), true, "Packet to " << dst << " queued");
+}
+
+void
+HwmpQueueTimeoutTest::Dequeue (Mac48Address dst)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp->DequeueFirstPacketByDst (dst).dst, dst, "Packet to " << dst << " dequeued");
+}
+
+void
+HwmpQueueTimeoutTest::Check (uint32_t packets, uint32_t timeouts)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp->m_rqueuePackets, packets, "Queued packets at " << Simulator::Now ().GetSeconds () << " s");
+  NS_TEST_ASSERT_MSG_EQ (m_timeouts, timeouts, "Packets dropped for their age at " << Simulator::Now ().GetSeconds () << " s");
+  NS_TEST_ASSERT_MSG_EQ (m_failedReplies, timeouts, "Senders told at " << Simulator::Now ().GetSeconds () << " s");
+}
+
+void
+HwmpQueueTimeoutTest::Reply (bool success, Ptr<Packet> packet, Mac48Address src, Mac48Address dst, uint16_t protocol,
+                             uint32_t outInterface)
+{
+  if (!success)
+    {
+      m_failedReplies++;
+    }
+}
+
+void
+HwmpQueueTimeoutTest::QueueDrop (Ptr<const Packet> packet, Mac48Address destination, HwmpProtocol::QueueDropReason reason)
+{
+  if (reason == HwmpProtocol::QUEUE_TIMEOUT)
+    {
+      m_timeouts++;
+    }
+}
+
+void
+HwmpQueueTimeoutTest::DoRun (void)
+{
+  Mac48Address d1 ("00:00:00:00:00:11");
+  Mac48Address d2 ("00:00:00:00:00:12");
+  Mac48Address d3 ("00:00:00:00:00:13");
+
+  m_hwmp = CreateObject<HwmpProtocol> ();
+  m_hwmp->SetAttribute ("MaxQueueTime", TimeValue (Seconds (1)));
+  m_hwmp->TraceConnectWithoutContext ("QueueDrop", MakeCallback (&HwmpQueueTimeoutTest::QueueDrop, this));
+
+  Simulator::Schedule (Seconds (0), &HwmpQueueTimeoutTest::Enqueue, this, d1);
+  Simulator::Schedule (Seconds (0.5), &HwmpQueueTimeoutTest::Enqueue, this, d2);
+  Simulator::Schedule (Seconds (1), &HwmpQueueTimeoutTest::Check, this, 2, 0);
+  Simulator::Schedule (Seconds (1.001), &HwmpQueueTimeoutTest::Check, this, 1, 1);
+  Simulator::Schedule (Seconds (1.5), &HwmpQueueTimeoutTest::Check, this, 1, 1);
+  Simulator::Schedule (Seconds (1.501), &HwmpQueueTimeoutTest::Check, this, 0, 2);
+  Simulator::Schedule (Seconds (2), &HwmpQueueTimeoutTest::Enqueue, this, d3);
+  Simulator::Schedule (Seconds (2.5), &HwmpQueueTimeoutTest::Dequeue, this, d3);
+  Simulator::Schedule (Seconds (4), &HwmpQueueTimeoutTest::Check, this, 0, 2);
+  Simulator::Run ();
+
+  m_hwmp->Dispose ();
+  m_hwmp = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HWMP route discovery queue test suite
+ */
+class HwmpQueueTestSuite : public TestSuite
+{
+public:
+  HwmpQueueTestSuite ();
+};
+
+HwmpQueueTestSuite::HwmpQueueTestSuite ()
+  : TestSuite ("devices-mesh-dot11s-hwmp-queue", UNIT)
+{
+  AddTestCase (new HwmpQueueLimitsTest, TestCase::QUICK);
+  AddTestCase (new HwmpQueueTimeoutTest, TestCase::QUICK);
+}
+
+static HwmpQueueTestSuite g_hwmpQueueTestSuite; ///< the test suite
@@ -0,0 +1,306 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/mesh-helper.h"
+#include "ns3/mesh-point-device.h"
+#include "ns3/hwmp-protocol.h"
+#include "ns3/hwmp-rtable.h"
+#include "ns3/ie-dot11s-rann.h"
+
+using namespace ns3;
+using namespace dot11s;
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HwmpProtocol::ReceiveRann keeps the freshest announcement of a root
+ *
+ * A newer sequence number replaces the announcement whatever its metric,
+ * an older one is ignored, and the same one only replaces it with a better
+ * metric. Sequence numbers compare modulo 2^32. FindRann forgets an
+ * announcement after two announcement intervals.
+ */
+class HwmpRannAcceptanceTest : public TestCase
+{
+public:
+  HwmpRannAcceptanceTest ();
+  virtual ~HwmpRannAcceptanceTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Receive a RANN
+   * \param root the root of the announcement
+   * \param seqno its sequence number
+   * \param from the neighbor it is received from
+   * \param metric the metric of the link to that neighbor
+   */
+  void Receive (Mac48Address root, uint32_t seqno, Mac48Address from, uint32_t metric);
+  /**
+   * Check whether FindRann returns the announcement of a root
+   * \param root the root
+   * \param found whether it must be found
+   */
+  void CheckFound (Mac48Address root, bool found);
+
+  Ptr<HwmpProtocol> m_hwmp; ///< the protocol
+};
+
+HwmpRannAcceptanceTest::HwmpRannAcceptanceTest ()
+  : TestCase ("RANN with a newer sequence number replaces an older one")
+{
+}
+
+HwmpRannAcceptanceTest::~HwmpRannAcceptanceTest ()
+{
+}
+
+void
+HwmpRannAcceptanceTest::Receive (Mac48Address root, uint32_t seqno, Mac48Address from, uint32_t metric)
+{
+  IeRann rann;
+  rann.SetTTL (32);
+  rann.SetOriginatorAddress (root);
+  rann.SetDestSeqNumber (seqno);
+  rann.SetMetric (0);
+  m_hwmp->ReceiveRann (rann, from, 1, metric);
+}
+
+void
+HwmpRannAcceptanceTest::CheckFound (Mac48Address root, bool found)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp->FindRann (root) != 0, found, "Announcement of " << root << " at "
+                         << Simulator::Now ().GetSeconds () << " s");
+}
+
+void
+HwmpRannAcceptanceTest::DoRun (void)
+{
+  Mac48Address root ("00:00:00:00:00:01");
+  Mac48Address other ("00:00:00:00:00:02");
+  Mac48Address a ("00:00:00:00:00:10");
+  Mac48Address b ("00:00:00:00:00:11");
+
+  m_hwmp = CreateObject<HwmpProtocol> ();
+  Receive (root, 5, a, 100);
+  const HwmpProtocol::RannState * rann = m_hwmp->FindRann (root);
+  NS_TEST_ASSERT_MSG_EQ (rann != 0, true, "First announcement accepted");
+  NS_TEST_ASSERT_MSG_EQ (rann->seqno, 5, "Sequence number of the first announcement");
+  NS_TEST_ASSERT_MSG_EQ (rann->retransmitter, a, "Next hop towards the root");
+  NS_TEST_ASSERT_MSG_EQ (rann->metric, 100, "Metric through a");
+
+  Receive (root, 4, b, 10);
+  NS_TEST_ASSERT_MSG_EQ (rann->seqno, 5, "Older announcement ignored");
+  NS_TEST_ASSERT_MSG_EQ (rann->retransmitter, a, "Older announcement ignored despite its metric");
+  Receive (root, 5, b, 150);
+  NS_TEST_ASSERT_MSG_EQ (rann->retransmitter, a, "Same announcement with a worse metric ignored");
+  Receive (root, 5, b, 50);
+  NS_TEST_ASSERT_MSG_EQ (rann->retransmitter, b, "Same announcement with a better metric accepted");
+  NS_TEST_ASSERT_MSG_EQ (rann->metric, 50, "Metric through b");
+  Receive (root, 6, a, 100);
+  NS_TEST_ASSERT_MSG_EQ (rann->seqno, 6, "Newer announcement accepted");
+  NS_TEST_ASSERT_MSG_EQ (rann->retransmitter, a, "Newer announcement accepted despite its metric");
+  NS_TEST_ASSERT_MSG_EQ (rann->metric, 100, "Metric of the newer announcement");
+
+  //Sequence numbers wrap around
+  Receive (other, 0xffffffff, a, 100);
+  Receive (other, 1, b, 200);
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp->FindRann (other)->seqno, 1, "Wrapped around sequence number is newer");
+  Receive (other, 0xfffffffe, a, 10);
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp->FindRann (other)->retransmitter, b, "Sequence number before the wrap around is older");
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp->FindRann (Mac48Address ("00:00:00:00:00:03")) == 0, true, "Root never announced");
+
+  Time lifetime = m_hwmp->m_dot11MeshHWMPrannInterval * 2;
+  Simulator::Schedule (lifetime, &HwmpRannAcceptanceTest::CheckFound, this, root, true);
+  Simulator::Schedule (lifetime + MilliSeconds (1), &HwmpRannAcceptanceTest::CheckFound, this, root, false);
+  Simulator::Run ();
+
+  m_hwmp->Dispose ();
+  m_hwmp = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief RANN mode on a chain of three mesh points
+ *
+ * Node 0 is a root sending RANNs, each node only hears its neighbors in
+ * the chain. The announcement must reach node 2 through node 1, with a
+ * growing metric. A packet from node 2 to the root then makes node 2
+ * send a single PREQ, individually addressed to node 1, that node 1
+ * forwards to the root, instead of flooding a PREQ. The root answers and
+ * node 2 has a path to the root through node 1.
+ */
+class HwmpRannChainTest : public TestCase
+{
+public:
+  HwmpRannChainTest ();
+  virtual ~HwmpRannChainTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param node the node index
+   * \returns the address of the only interface of the node
+   */
+  Mac48Address GetInterfaceAddress (uint32_t node) const;
+  /// Check that the announcement reached every node
+  void CheckAnnouncement (void);
+  /// Send a packet from node 2 to the root
+  void SendToRoot (void);
+  /// Check the path of node 2 to the root
+  void CheckRootPath (void);
+
+  Mac48Address m_root; ///< the address of the root mesh point
+  std::vector<Ptr<MeshPointDevice> > m_mp; ///< the mesh points
+  std::vector<Ptr<HwmpProtocol> > m_hwmp; ///< the HWMP of the mesh points
+};
+
+HwmpRannChainTest::HwmpRannChainTest ()
+  : TestCase ("RANN propagates along a chain and leads the PREQ to the root")
+{
+}
+
+HwmpRannChainTest::~HwmpRannChainTest ()
+{
+}
+
+Mac48Address
+HwmpRannChainTest::GetInterfaceAddress (uint32_t node) const
+{
+  return Mac48Address::ConvertFrom (m_mp[node]->GetInterfaces ()[0]->GetAddress ());
+}
+
+void
+HwmpRannChainTest::CheckAnnouncement (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp[0]->FindRann (m_root) == 0, true, "The root ignores its own announcements");
+  const HwmpProtocol::RannState * first = m_hwmp[1]->FindRann (m_root);
+  const HwmpProtocol::RannState * second = m_hwmp[2]->FindRann (m_root);
+  NS_TEST_ASSERT_MSG_EQ (first != 0, true, "Announcement received by node 1");
+  NS_TEST_ASSERT_MSG_EQ (second != 0, true, "Announcement forwarded to node 2");
+  NS_TEST_ASSERT_MSG_EQ (first->retransmitter, GetInterfaceAddress (0), "Node 1 heard the root");
+  NS_TEST_ASSERT_MSG_EQ (second->retransmitter, GetInterfaceAddress (1), "Node 2 heard node 1");
+  NS_TEST_ASSERT_MSG_EQ (second->seqno, first->seqno, "Same announcement");
+  NS_TEST_ASSERT_MSG_GT (second->metric, first->metric, "Metric grows along the chain");
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp[2]->GetRoutingTable ()->LookupReactive (m_root).IsValid (), false,
+                         "An announcement alone does not make a path");
+}
+
+void
+HwmpRannChainTest::SendToRoot (void)
+{
+  m_mp[2]->Send (Create<Packet> (100), m_root, 0x0800);
+}
+
+void
+HwmpRannChainTest::CheckRootPath (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp[2]->m_stats.initiatedRootPreq, 1, "One PREQ sent to the root");
+  NS_TEST_ASSERT_MSG_EQ (m_hwmp[2]->m_stats.initiatedPreq, 1, "No PREQ flooded");
+  NS_TEST_ASSERT_MSG_GT (m_hwmp[1]->m_stats.forwardedPreq, 0, "PREQ forwarded to the root by node 1");
+  HwmpRtable::LookupResult result = m_hwmp[2]->GetRoutingTable ()->LookupReactive (m_root);
+  NS_TEST_ASSERT_MSG_EQ (result.IsValid (), true, "Path to the root");
+  NS_TEST_ASSERT_MSG_EQ (result.retransmitter, GetInterfaceAddress (1), "Path to the root through node 1");
+}
+
+void
+HwmpRannChainTest::DoRun (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  NodeContainer nodes;
+  nodes.Create (3);
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (100),
+                                 "DeltaY", DoubleValue (0),
+                                 "GridWidth", UintegerValue (3),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  //Each node only hears its neighbors in the chain
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (150));
+  YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
+  wifiPhy.SetChannel (wifiChannel.Create ());
+  MeshHelper mesh = MeshHelper::Default ();
+  mesh.SetStackInstaller ("ns3::Dot11sStack");
+  mesh.SetMacType ("RandomStart", TimeValue (Seconds (0.1)));
+  mesh.SetNumberOfInterfaces (1);
+  NetDeviceContainer devices = mesh.Install (wifiPhy, nodes);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      m_mp.push_back (DynamicCast<MeshPointDevice> (devices.Get (i)));
+      m_hwmp.push_back (DynamicCast<HwmpProtocol> (m_mp[i]->GetRoutingProtocol ()));
+    }
+  m_root = Mac48Address::ConvertFrom (m_mp[0]->GetAddress ());
+  //The announcements start when the protocol is initialized
+  m_hwmp[0]->SetAttribute ("RootAnnouncement", BooleanValue (true));
+  m_hwmp[0]->SetRoot ();
+
+  //The peer links are up for the second announcement, sent after 5.12 s
+  Simulator::Schedule (Seconds (6), &HwmpRannChainTest::CheckAnnouncement, this);
+  Simulator::Schedule (Seconds (6), &HwmpRannChainTest::SendToRoot, this);
+  Simulator::Schedule (Seconds (7), &HwmpRannChainTest::CheckRootPath, this);
+  Simulator::Stop (Seconds (8));
+  Simulator::Run ();
+
+  m_mp.clear ();
+  m_hwmp.clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HWMP RANN test suite
+ */
+class HwmpRannTestSuite : public TestSuite
+{
+public:
+  HwmpRannTestSuite ();
+};
+
+HwmpRannTestSuite::HwmpRannTestSuite ()
+  : TestSuite ("devices-mesh-dot11s-hwmp-rann", UNIT)
+{
+  AddTestCase (new HwmpRannAcceptanceTest, TestCase::QUICK);
+  AddTestCase (new HwmpRannChainTest, TestCase::QUICK);
+}
+
+static HwmpRannTestSuite g_hwmpRannTestSuite; ///< the test suite
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/hwmp-rtable.h"
+#include <iostream>
+#include <iomanip>
+#include <map>
+
+using namespace ns3;
+using namespace dot11s;
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief Per packet route lookup cost of HwmpRtable
+ *
+ * Times the reactive route lookup done by HwmpProtocol::ForwardUnicast for
+ * every data packet, on tables of the sizes of the drone scenarios. The
+ * baseline is the former table, a std::map probed twice by LookupReactive
+ * (once for the expiry check and once more through LookupReactiveExpired).
+ * The current table is probed once through FindReactive. Both must return
+ * the same next hops. The best time of three rounds of each table and
+ * their ratio are printed, and the hash table must not be notably slower
+ * than the baseline.
+ */
+class HwmpRtableLookupBenchmark : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param nRoutes the number of reactive routes in the table
+   */
+  HwmpRtableLookupBenchmark (uint32_t nRoutes);
+  virtual ~HwmpRtableLookupBenchmark ();
+
+private:
+  virtual void DoRun (void);
+
+  /// Reactive route as stored by the former table
+  struct MapRoute
+  {
+    Mac48Address retransmitter; ///< next hop
+    uint32_t interface; ///< interface
+    uint32_t metric; ///< metric
+    Time whenExpire; ///< expiration time
+    uint32_t seqnum; ///< sequence number
+  };
+  /**
+   * LookupReactive of the former table
+   * \param destination the destination
+   * \returns the route
+   */
+  HwmpRtable::LookupResult MapLookupReactive (Mac48Address destination);
+  /**
+   * LookupReactiveExpired of the former table
+   * \param destination the destination
+   * \returns the route
+   */
+  HwmpRtable::LookupResult MapLookupReactiveExpired (Mac48Address destination);
+  /**
+   * Route lookup of HwmpProtocol::ForwardUnicast
+   * \param destination the destination
+   * \returns the route
+   */
+  HwmpRtable::LookupResult FindLookupReactive (Mac48Address destination);
+
+  uint32_t m_nRoutes; ///< number of routes
+  std::map<Mac48Address, MapRoute> m_map; ///< former table
+  Ptr<HwmpRtable> m_rtable; ///< current table
+};
+
+HwmpRtableLookupBenchmark::HwmpRtableLookupBenchmark (uint32_t nRoutes)
+  : TestCase ("Reactive route lookup per packet with routes to " + std::to_string (nRoutes) + " nodes"),
+    m_nRoutes (nRoutes)
+{
+}
+
+HwmpRtableLookupBenchmark::~HwmpRtableLookupBenchmark ()
+{
+}
+
+HwmpRtable::LookupResult
+HwmpRtableLookupBenchmark::MapLookupReactive (Mac48Address destination)
+{
+  std::map<Mac48Address, MapRoute>::iterator i = m_map.find (destination);
+  if (i == m_map.end ())
+    {
+      return HwmpRtable::LookupResult ();
+    }
+  if ((i->second.whenExpire < Simulator::Now ()) && (i->second.whenExpire != Seconds (0)))
+    {
+      return HwmpRtable::LookupResult ();
+    }
+  return MapLookupReactiveExpired (destination);
+}
+
+HwmpRtable::LookupResult
+HwmpRtableLookupBenchmark::MapLookupReactiveExpired (Mac48Address destination)
+{
+  std::map<Mac48Address, MapRoute>::iterator i = m_map.find (destination);
+  if (i == m_map.end ())
+    {
+      return HwmpRtable::LookupResult ();
+    }
+  return HwmpRtable::LookupResult (i->second.retransmitter, i->second.interface, i->second.metric, i->second.seqnum,
+                                   i->second.whenExpire - Simulator::Now ());
+}
+
+HwmpRtable::LookupResult
+HwmpRtableLookupBenchmark::FindLookupReactive (Mac48Address destination)
+{
+  const HwmpRtable::ReactiveRoute * route = m_rtable->FindReactive (destination);
+  HwmpRtable::LookupResult result;
+  if (route != 0 && !route->IsExpired ())
+    {
+      result = route->GetLookupResult ();
+    }
+  return result;
+}
+
+void
+HwmpRtableLookupBenchmark::DoRun (void)
+{
+  //About as many packets as a 125 s drone run forwards per node
+  const uint32_t nLookups = 2000000;
+
+  m_rtable = CreateObject<HwmpRtable> ();
+  std::vector<Mac48Address> destinations;
+  for (uint32_t i = 0; i < m_nRoutes; i++)
+    {
+      Mac48Address destination = Mac48Address::Allocate ();
+      Mac48Address retransmitter = Mac48Address::Allocate ();
+      destinations.push_back (destination);
+      m_rtable->AddReactivePath (destination, retransmitter, 1, 100 + i, Seconds (10), i);
+      MapRoute route;
+      route.retransmitter = retransmitter;
+      route.interface = 1;
+      route.metric = 100 + i;
+      route.whenExpire = Simulator::Now () + Seconds (10);
+      route.seqnum = i;
+      m_map[destination] = route;
+    }
+  //Packets of a flow come in bursts, spread them over the destinations
+  //with a stride prime to the table size
+  std::vector<uint32_t> order (nLookups);
+  for (uint32_t i = 0; i < nLookups; i++)
+    {
+      order[i] = (uint32_t)(((uint64_t)i * 7919) % m_nRoutes);
+    }
+
+  //Best of a few rounds of each table, alternated so that both see the
+  //same machine load
+  uint64_t mapSum = 0;
+  uint64_t findSum = 0;
+  int64_t mapMs = 0;
+  int64_t findMs = 0;
+  SystemWallClockMs clock;
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      mapSum = 0;
+      clock.Start ();
+      for (uint32_t i = 0; i < nLookups; i++)
+        {
+          mapSum += MapLookupReactive (destinations[order[i]]).metric;
+        }
+      int64_t ms = clock.End ();
+      mapMs = (round == 0 || ms < mapMs) ? ms : mapMs;
+
+      findSum = 0;
+      clock.Start ();
+      for (uint32_t i = 0; i < nLookups; i++)
+        {
+          findSum += FindLookupReactive (destinations[order[i]]).metric;
+        }
+      ms = clock.End ();
+      findMs = (round == 0 || ms < findMs) ? ms : findMs;
+    }
+
+  std::cout << std::fixed << std::setprecision (1)
+            << "HwmpRtable " << m_nRoutes << " routes: std::map " << mapMs * 1e6 / nLookups
+            << " ns/packet, hash table " << findMs * 1e6 / nLookups << " ns/packet";
+  if (findMs > 0)
+    {
+      std::cout << std::setprecision (2) << ", " << (double) mapMs / findMs << "x the std::map baseline";
+    }
+  std::cout << std::endl;
+
+  NS_TEST_ASSERT_MSG_EQ (findSum, mapSum, "Both tables must return the same routes");
+  //Allow for the millisecond resolution of the clock and some noise
+  NS_TEST_EXPECT_MSG_LT (findMs, mapMs + mapMs / 4 + 2, "The hash table is slower than the std::map baseline");
+  for (uint32_t i = 0; i < m_nRoutes; i++)
+    {
+      HwmpRtable::LookupResult expected = MapLookupReactive (destinations[i]);
+      HwmpRtable::LookupResult found = FindLookupReactive (destinations[i]);
+      NS_TEST_ASSERT_MSG_EQ (found.retransmitter, expected.retransmitter, "Next hop to " << destinations[i]);
+      NS_TEST_ASSERT_MSG_EQ (m_rtable->LookupReactive (destinations[i]).retransmitter, expected.retransmitter,
+                             "LookupReactive to " << destinations[i]);
+    }
+
+  m_map.clear ();
+  m_rtable->Dispose ();
+  m_rtable = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief HwmpRtable lookup benchmark suite
+ *
+ * The times, and the speedup over the std::map baseline, are printed by
+ * ./waf --run "test-runner --suite=devices-mesh-dot11s-hwmp-rtable-benchmark".
+ */
+class HwmpRtableBenchmarkSuite : public TestSuite
+{
+public:
+  HwmpRtableBenchmarkSuite ();
+};
+
+HwmpRtableBenchmarkSuite::HwmpRtableBenchmarkSuite ()
+  : TestSuite ("devices-mesh-dot11s-hwmp-rtable-benchmark", PERFORMANCE)
+{
+  AddTestCase (new HwmpRtableLookupBenchmark (20), TestCase::QUICK);
+  AddTestCase (new HwmpRtableLookupBenchmark (60), TestCase::QUICK);
+  AddTestCase (new HwmpRtableLookupBenchmark (200), TestCase::QUICK);
+}
+
+static HwmpRtableBenchmarkSuite g_hwmpRtableBenchmarkSuite; ///< the test suite
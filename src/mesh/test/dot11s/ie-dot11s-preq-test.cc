@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/buffer.h"
+#include "ns3/ie-dot11s-preq.h"
+
+using namespace ns3;
+using namespace dot11s;
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief IePreq only reads the destination units present in the element
+ *
+ * The destination count is read off the wire. A count larger than the
+ * units held by the information field must not make the element read past
+ * it, nor overflow its fixed array of destinations.
+ */
+class IePreqDestCountTest : public TestCase
+{
+public:
+  IePreqDestCountTest ();
+  virtual ~IePreqDestCountTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Serialize a PREQ with two destinations, overwrite its destination count
+   * and deserialize it with the given information field length
+   * \param count the destination count written in the element
+   * \param length the information field length given to the deserializer
+   * \param received the deserialized element
+   */
+  void Deserialize (uint8_t count, uint8_t length, IePreq &received);
+
+  IePreq m_sent; ///< the PREQ with two destinations
+};
+
+IePreqDestCountTest::IePreqDestCountTest ()
+  : TestCase ("PREQ destination count read off the wire is clamped to the element length")
+{
+}
+
+IePreqDestCountTest::~IePreqDestCountTest ()
+{
+}
+
+void
+IePreqDestCountTest::Deserialize (uint8_t count, uint8_t length, IePreq &received)
+{
+  Buffer buffer;
+  buffer.AddAtStart (m_sent.GetInformationFieldSize ());
+  m_sent.SerializeInformationField (buffer.Begin ());
+  //The destination count follows the 25 bytes of fixed fields
+  Buffer::Iterator i = buffer.Begin ();
+  i.Next (25);
+  i.WriteU8 (count);
+  received.DeserializeInformationField (buffer.Begin (), length);
+}
+
+void
+IePreqDestCountTest::DoRun (void)
+{
+  m_sent.SetOriginatorAddress (Mac48Address ("00:00:00:00:00:01"));
+  m_sent.SetOriginatorSeqNumber (7);
+  m_sent.AddDestinationAddressElement (false, true, Mac48Address ("00:00:00:00:00:02"), 11);
+  m_sent.AddDestinationAddressElement (true, false, Mac48Address ("00:00:00:00:00:03"), 12);
+  uint8_t size = m_sent.GetInformationFieldSize ();
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) size, 26 + 2 * 11, "Two destination units");
+
+  IePreq exact;
+  Deserialize (2, size, exact);
+  NS_TEST_ASSERT_MSG_EQ (exact, m_sent, "Round trip of a well formed PREQ");
+
+  IePreq tooMany;
+  Deserialize (255, size, tooMany);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) tooMany.GetDestCount (), 2, "Count clamped to the units in the element");
+  NS_TEST_ASSERT_MSG_EQ (tooMany, m_sent, "Units present are still read");
+
+  IePreq shortElement;
+  Deserialize (2, 26 + 11, shortElement);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) shortElement.GetDestCount (), 1, "Count clamped to a shorter element");
+  NS_TEST_ASSERT_MSG_EQ (shortElement.GetDestination (0).GetDestinationAddress (), Mac48Address ("00:00:00:00:00:02"),
+                         "First unit read");
+
+  IePreq noUnits;
+  Deserialize (2, 26, noUnits);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) noUnits.GetDestCount (), 0, "Element without room for a unit");
+}
+
+/**
+ * \ingroup dot11s-test
+ * \ingroup tests
+ *
+ * \brief IePreq test suite
+ */
+class IePreqTestSuite : public TestSuite
+{
+public:
+  IePreqTestSuite ();
+};
+
+IePreqTestSuite::IePreqTestSuite ()
+  : TestSuite ("devices-mesh-dot11s-ie-preq", UNIT)
+{
+  AddTestCase (new IePreqDestCountTest, TestCase::QUICK);
+}
+
+static IePreqTestSuite g_iePreqTestSuite; ///< the test suite
@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/mesh-timer-wheel.h"
+#include <map>
+
+using namespace ns3;
+
+/**
+ * \ingroup mesh-test
+ * \ingroup tests
+ *
+ * \brief MeshTimerWheel calls the expiry callback at the deadline of every entry
+ *
+ * With the default 100 ms ticks, the entries are scheduled at time 0 with:
+ * - tag 1: 150 ms, rounded up to 200 ms, in the first level
+ * - tag 2: 10 s, cascaded from the second level
+ * - tag 3: 500 s, cascaded from the third level
+ * - tag 4: 2000000 s, beyond the 1677721.6 s horizon of the wheel, parked
+ *   and inserted again until it falls within the wheel
+ * - tag 5: 1 s, the expiry callback returns a new deadline 1 s later the
+ *   first time and lets it expire the second time
+ * The wheel is advanced just before and at each deadline.
+ */
+class MeshTimerWheelTest : public TestCase
+{
+public:
+  MeshTimerWheelTest ();
+  virtual ~MeshTimerWheelTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Expiry callback of the wheel
+   * \param key the key of the entry
+   * \param tag the tag of the entry
+   * \returns the new deadline of tag 5 the first time, now otherwise
+   */
+  Time Expire (uint64_t key, uint32_t tag);
+  /**
+   * Advance the wheel and check the expiry callback calls of an entry
+   * \param tag the tag of the entry
+   * \param calls the expected number of calls so far
+   */
+  void Check (uint32_t tag, uint32_t calls);
+  /**
+   * \param tag the tag of an entry
+   * \returns the key of the entry
+   */
+  static uint64_t GetKey (uint32_t tag);
+
+  MeshTimerWheel m_wheel; ///< the wheel
+  std::map<uint32_t, uint32_t> m_calls; ///< expiry callback calls per tag
+};
+
+MeshTimerWheelTest::MeshTimerWheelTest ()
+  : TestCase ("Timer wheel expires entries at their deadline")
+{
+}
+
+MeshTimerWheelTest::~MeshTimerWheelTest ()
+{
+}
+
+uint64_t
+MeshTimerWheelTest::GetKey (uint32_t tag)
+{
+  uint8_t address[6] = { 0, 0, 0, 0, 0x10, 0 };
+  address[5] = tag;
+  Mac48Address key;
+  key.CopyFrom (address);
+  return MeshTimerWheel::GetKey (key);
+}
+
+Time
+MeshTimerWheelTest::Expire (uint64_t key, uint32_t tag)
+{
+  NS_TEST_EXPECT_MSG_EQ (key, GetKey (tag), "Key of tag " << tag);
+  m_calls[tag]++;
+  if (tag == 5 && m_calls[tag] == 1)
+    {
+      return Simulator::Now () + Seconds (1);
+    }
+  return Simulator::Now ();
+}
+
+void
+MeshTimerWheelTest::Check (uint32_t tag, uint32_t calls)
+{
+  m_wheel.Advance ();
+  NS_TEST_ASSERT_MSG_EQ (m_calls[tag], calls, "Expiry callback calls of tag " << tag
+                         << " at " << Simulator::Now ().GetSeconds () << " s");
+}
+
+void
+MeshTimerWheelTest::DoRun (void)
+{
+  m_wheel.SetExpiryCallback (MakeCallback (&MeshTimerWheelTest::Expire, this));
+  m_wheel.Schedule (GetKey (1), 1, MilliSeconds (150));
+  m_wheel.Schedule (GetKey (2), 2, Seconds (10));
+  m_wheel.Schedule (GetKey (3), 3, Seconds (500));
+  m_wheel.Schedule (GetKey (4), 4, Seconds (2000000));
+  m_wheel.Schedule (GetKey (5), 5, Seconds (1));
+  NS_TEST_ASSERT_MSG_EQ (m_wheel.GetN (), 5, "Entries scheduled");
+
+  //Rounding up
+  Simulator::Schedule (MilliSeconds (150), &MeshTimerWheelTest::Check, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (199), &MeshTimerWheelTest::Check, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (200), &MeshTimerWheelTest::Check, this, 1, 1);
+  //Rescheduling from the expiry callback
+  Simulator::Schedule (Seconds (1), &MeshTimerWheelTest::Check, this, 5, 1);
+  Simulator::Schedule (MilliSeconds (1999), &MeshTimerWheelTest::Check, this, 5, 1);
+  Simulator::Schedule (Seconds (2), &MeshTimerWheelTest::Check, this, 5, 2);
+  //Cascading from the second and the third levels
+  Simulator::Schedule (MilliSeconds (9999), &MeshTimerWheelTest::Check, this, 2, 0);
+  Simulator::Schedule (Seconds (10), &MeshTimerWheelTest::Check, this, 2, 1);
+  Simulator::Schedule (MilliSeconds (499999), &MeshTimerWheelTest::Check, this, 3, 0);
+  Simulator::Schedule (Seconds (500), &MeshTimerWheelTest::Check, this, 3, 1);
+  //Parked beyond the horizon
+  Simulator::Schedule (Seconds (1677722), &MeshTimerWheelTest::Check, this, 4, 0);
+  Simulator::Schedule (MilliSeconds (1999999999), &MeshTimerWheelTest::Check, this, 4, 0);
+  Simulator::Schedule (Seconds (2000000), &MeshTimerWheelTest::Check, this, 4, 1);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_calls[1], 1, "Tag 1 expired once");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[2], 1, "Tag 2 expired once");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[3], 1, "Tag 3 expired once");
+  NS_TEST_ASSERT_MSG_EQ (m_wheel.GetN (), 0, "All entries expired");
+  m_wheel.Clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup mesh-test
+ * \ingroup tests
+ *
+ * \brief MeshTimerWheel::GetKey keeps the order of the addresses
+ */
+class MeshTimerWheelKeyTest : public TestCase
+{
+public:
+  MeshTimerWheelKeyTest ();
+  virtual ~MeshTimerWheelKeyTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MeshTimerWheelKeyTest::MeshTimerWheelKeyTest ()
+  : TestCase ("Timer wheel keys of MAC addresses")
+{
+}
+
+MeshTimerWheelKeyTest::~MeshTimerWheelKeyTest ()
+{
+}
+
+void
+MeshTimerWheelKeyTest::DoRun (void)
+{
+  Mac48Address a ("00:00:00:00:01:ff");
+  Mac48Address b ("00:00:00:00:02:00");
+  Mac48Address c ("ff:00:00:00:00:00");
+  NS_TEST_ASSERT_MSG_LT (MeshTimerWheel::GetKey (a), MeshTimerWheel::GetKey (b), "a before b");
+  NS_TEST_ASSERT_MSG_LT (MeshTimerWheel::GetKey (b), MeshTimerWheel::GetKey (c), "b before c");
+  NS_TEST_ASSERT_MSG_EQ (MeshTimerWheel::GetKey (c), 0xff0000000000ULL, "48 bit key");
+  NS_TEST_ASSERT_MSG_EQ (MeshTimerWheel::GetAddress (MeshTimerWheel::GetKey (a)), a, "Address of the key of a");
+  NS_TEST_ASSERT_MSG_EQ (MeshTimerWheel::GetAddress (MeshTimerWheel::GetKey (c)), c, "Address of the key of c");
+}
+
+/**
+ * \ingroup mesh-test
+ * \ingroup tests
+ *
+ * \brief MeshTimerWheel test suite
+ */
+class MeshTimerWheelTestSuite : public TestSuite
+{
+public:
+  MeshTimerWheelTestSuite ();
+};
+
+MeshTimerWheelTestSuite::MeshTimerWheelTestSuite ()
+  : TestSuite ("devices-mesh-timer-wheel", UNIT)
+{
+  AddTestCase (new MeshTimerWheelTest, TestCase::QUICK);
+  AddTestCase (new MeshTimerWheelKeyTest, TestCase::QUICK);
+}
+
+static MeshTimerWheelTestSuite g_meshTimerWheelTestSuite; ///< the test suite
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "ns3/assert.h"
+#include "ns3/double.h"
+#include "ns3/propagation-loss-model.h"
+#include "path-loss-batch.h"
+
+#if defined (__AVX__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ns3 {
+
+// Same value used by FriisPropagationLossModel to derive the wavelength
+static const double SPEED_OF_LIGHT = 299792458.0;
+
+PathLossBatch::PathLossBatch ()
+{
+}
+
+bool
+PathLossBatch::Build (Ptr<PropagationLossModel> loss)
+{
+  m_stages.clear ();
+  for (Ptr<PropagationLossModel> model = loss; model != 0; model = model->GetNext ())
+    {
+      std::string name = model->GetInstanceTypeId ().GetName ();
+      Stage stage;
+      DoubleValue value;
+      if (name == "ns3::FriisPropagationLossModel")
+        {
+          stage.type = FRIIS;
+          model->GetAttribute ("Frequency", value);
+          stage.lambda = SPEED_OF_LIGHT / value.Get ();
+          model->GetAttribute ("SystemLoss", value);
+          stage.systemLoss = value.Get ();
+          model->GetAttribute ("MinLoss", value);
+          stage.minLoss = value.Get ();
+        }
+      else if (name == "ns3::LogDistancePropagationLossModel")
+        {
+          stage.type = LOG_DISTANCE;
+          model->GetAttribute ("Exponent", value);
+          stage.exponent = value.Get ();
+          model->GetAttribute ("ReferenceDistance", value);
+          stage.referenceDistance = value.Get ();
+          model->GetAttribute ("ReferenceLoss", value);
+          stage.referenceLoss = value.Get ();
+        }
+      else
+        {
+          m_stages.clear ();
+          return false;
+        }
+      m_stages.push_back (stage);
+    }
+  return !m_stages.empty ();
+}
+
+void
+PathLossBatch::CalcDistances (const Vector &sender, const double *x, const double *y, const double *z,
+                              double *distance, std::size_t n)
+{
+  std::size_t i = 0;
+#if defined (__AVX__)
+  __m256d sx = _mm256_set1_pd (sender.x);
+  __m256d sy = _mm256_set1_pd (sender.y);
+  __m256d sz = _mm256_set1_pd (sender.z);
+  for (; i + 4 <= n; i += 4)
+    {
+      __m256d dx = _mm256_sub_pd (_mm256_loadu_pd (x + i), sx);
+      __m256d dy = _mm256_sub_pd (_mm256_loadu_pd (y + i), sy);
+      __m256d dz = _mm256_sub_pd (_mm256_loadu_pd (z + i), sz);
+      __m256d sq = _mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (dx, dx), _mm256_mul_pd (dy, dy)),
+                                  _mm256_mul_pd (dz, dz));
+      _mm256_storeu_pd (distance + i, _mm256_sqrt_pd (sq));
+    }
+#elif defined (__SSE2__)
+  __m128d sx = _mm_set1_pd (sender.x);
+  __m128d sy = _mm_set1_pd (sender.y);
+  __m128d sz = _mm_set1_pd (sender.z);
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128d dx = _mm_sub_pd (_mm_loadu_pd (x + i), sx);
+      __m128d dy = _mm_sub_pd (_mm_loadu_pd (y + i), sy);
+      __m128d dz = _mm_sub_pd (_mm_loadu_pd (z + i), sz);
+      __m128d sq = _mm_add_pd (_mm_add_pd (_mm_mul_pd (dx, dx), _mm_mul_pd (dy, dy)), _mm_mul_pd (dz, dz));
+      _mm_storeu_pd (distance + i, _mm_sqrt_pd (sq));
+    }
+#endif
+  // Scalar fallback and remainder, same operation order as CalculateDistance
+  for (; i < n; i++)
+    {
+      double dx = x[i] - sender.x;
+      double dy = y[i] - sender.y;
+      double dz = z[i] - sender.z;
+      distance[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+    }
+}
+
+void
+PathLossBatch::CalcRxPower (double txPowerDbm, const Vector &sender,
+                            const std::vector<double> &x, const std::vector<double> &y, const std::vector<double> &z,
+                            std::vector<double> &rxPowerDbm) const
+{
+  NS_ASSERT (x.size () == y.size () && x.size () == z.size ());
+  std::size_t n = x.size ();
+  rxPowerDbm.resize (n);
+  if (n == 0)
+    {
+      return;
+    }
+  m_distance.resize (n);
+  CalcRxPower (txPowerDbm, sender, &x[0], &y[0], &z[0], &m_distance[0], &rxPowerDbm[0], n);
+}
+
+void
+PathLossBatch::CalcRxPower (double txPowerDbm, const Vector &sender, const double *x, const double *y, const double *z,
+                            double *distance, double *rxPowerDbm, std::size_t n) const
+{
+  CalcDistances (sender, x, y, z, distance, n);
+  std::fill (rxPowerDbm, rxPowerDbm + n, txPowerDbm);
+  for (std::vector<Stage>::const_iterator stage = m_stages.begin (); stage != m_stages.end (); ++stage)
+    {
+      if (stage->type == FRIIS)
+        {
+          double numerator = stage->lambda * stage->lambda;
+          for (std::size_t i = 0; i < n; i++)
+            {
+              if (distance[i] <= 0)
+                {
+                  rxPowerDbm[i] -= stage->minLoss;
+                  continue;
+                }
+              double denominator = 16 * M_PI * M_PI * distance[i] * distance[i] * stage->systemLoss;
+              double lossDb = -10 * std::log10 (numerator / denominator);
+              rxPowerDbm[i] -= std::max (lossDb, stage->minLoss);
+            }
+        }
+      else
+        {
+          for (std::size_t i = 0; i < n; i++)
+            {
+              if (distance[i] <= stage->referenceDistance)
+                {
+                  rxPowerDbm[i] -= stage->referenceLoss;
+                  continue;
+                }
+              double pathLossDb = 10 * stage->exponent * std::log10 (distance[i] / stage->referenceDistance);
+              double rxc = -stage->referenceLoss - pathLossDb;
+              rxPowerDbm[i] += rxc;
+            }
+        }
+    }
+}
+
+} //namespace ns3
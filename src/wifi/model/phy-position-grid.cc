@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "ns3/assert.h"
+#include "phy-position-grid.h"
+
+namespace ns3 {
+
+// Cell indices are packed in 21 bits per axis
+static const int64_t CELL_BITS = 21;
+static const int64_t CELL_OFFSET = (int64_t)1 << (CELL_BITS - 1);
+static const int64_t CELL_MASK = ((int64_t)1 << CELL_BITS) - 1;
+
+PhyPositionGrid::PhyPositionGrid ()
+  : m_cellSize (1.0),
+    m_count (0)
+{
+}
+
+void
+PhyPositionGrid::Reset (double cellSize)
+{
+  NS_ASSERT (cellSize > 0);
+  m_cellSize = cellSize;
+  m_cells.clear ();
+  m_positions.clear ();
+  m_present.clear ();
+  m_count = 0;
+}
+
+int64_t
+PhyPositionGrid::GetCell (double coordinate) const
+{
+  int64_t cell = (int64_t) std::floor (coordinate / m_cellSize);
+  return std::max (-CELL_OFFSET, std::min (CELL_OFFSET - 1, cell));
+}
+
+int64_t
+PhyPositionGrid::GetKey (int64_t x, int64_t y, int64_t z)
+{
+  return (((x + CELL_OFFSET) & CELL_MASK) << (2 * CELL_BITS))
+         | (((y + CELL_OFFSET) & CELL_MASK) << CELL_BITS)
+         | ((z + CELL_OFFSET) & CELL_MASK);
+}
+
+void
+PhyPositionGrid::Insert (uint32_t index, const Vector &position)
+{
+  if (index >= m_positions.size ())
+    {
+      m_positions.resize (index + 1);
+      m_present.resize (index + 1, false);
+    }
+  NS_ASSERT (!m_present[index]);
+  m_positions[index] = position;
+  m_present[index] = true;
+  m_count++;
+  m_cells[GetKey (GetCell (position.x), GetCell (position.y), GetCell (position.z))].push_back (index);
+}
+
+void
+PhyPositionGrid::Query (const Vector &center, double radius, std::vector<uint32_t> &result) const
+{
+  result.clear ();
+  int64_t xMin = GetCell (center.x - radius);
+  int64_t xMax = GetCell (center.x + radius);
+  int64_t yMin = GetCell (center.y - radius);
+  int64_t yMax = GetCell (center.y + radius);
+  int64_t zMin = GetCell (center.z - radius);
+  int64_t zMax = GetCell (center.z + radius);
+  double boxCells = (double)(xMax - xMin + 1) * (yMax - yMin + 1) * (zMax - zMin + 1);
+  if (boxCells > m_cells.size ())
+    {
+      // The sphere covers more cells than there are occupied ones: cheaper to walk the occupied cells
+      for (CellMap::const_iterator cell = m_cells.begin (); cell != m_cells.end (); ++cell)
+        {
+          for (std::vector<uint32_t>::const_iterator i = cell->second.begin (); i != cell->second.end (); ++i)
+            {
+              if (CalculateDistance (center, m_positions[*i]) <= radius)
+                {
+                  result.push_back (*i);
+                }
+            }
+        }
+    }
+  else
+    {
+      for (int64_t x = xMin; x <= xMax; x++)
+        {
+          for (int64_t y = yMin; y <= yMax; y++)
+            {
+              for (int64_t z = zMin; z <= zMax; z++)
+                {
+                  CellMap::const_iterator cell = m_cells.find (GetKey (x, y, z));
+                  if (cell == m_cells.end ())
+                    {
+                      continue;
+                    }
+                  for (std::vector<uint32_t>::const_iterator i = cell->second.begin (); i != cell->second.end (); ++i)
+                    {
+                      if (CalculateDistance (center, m_positions[*i]) <= radius)
+                        {
+                          result.push_back (*i);
+                        }
+                    }
+                }
+            }
+        }
+    }
+  // Callers iterate receivers in PHY list order, keep it that way
+  std::sort (result.begin (), result.end ());
+}
+
+uint32_t
+PhyPositionGrid::GetN () const
+{
+  return m_count;
+}
+
+} //namespace ns3
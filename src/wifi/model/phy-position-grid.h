@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#ifndef PHY_POSITION_GRID_H
+#define PHY_POSITION_GRID_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * \brief Uniform 3D grid over the positions of the PHYs attached to a channel
+ *
+ * PHYs are identified by their index in the channel PHY list. The grid only
+ * stores a snapshot of the positions, it is up to the owner to rebuild it
+ * when the nodes move and to inflate the query radius to account for the
+ * movement since the snapshot was taken.
+ */
+class PhyPositionGrid
+{
+public:
+  PhyPositionGrid ();
+  /**
+   * Remove all the entries and set the size of the grid cells
+   * \param cellSize the edge of a cubic cell in meters
+   */
+  void Reset (double cellSize);
+  /**
+   * Add a PHY to the grid
+   * \param index the index of the PHY in the channel PHY list
+   * \param position the position of the PHY
+   */
+  void Insert (uint32_t index, const Vector &position);
+  /**
+   * Find all PHYs within a sphere
+   * \param center the center of the sphere
+   * \param radius the radius of the sphere in meters
+   * \param result the PHY indices found, in increasing order
+   */
+  void Query (const Vector &center, double radius, std::vector<uint32_t> &result) const;
+  /// \returns the number of PHYs in the grid
+  uint32_t GetN () const;
+
+private:
+  /**
+   * \param coordinate a coordinate along any of the axes
+   * \returns the cell index along that axis
+   */
+  int64_t GetCell (double coordinate) const;
+  /**
+   * \param x cell index along the x axis
+   * \param y cell index along the y axis
+   * \param z cell index along the z axis
+   * \returns the key of the cell in the cell map
+   */
+  static int64_t GetKey (int64_t x, int64_t y, int64_t z);
+
+  typedef std::map<int64_t, std::vector<uint32_t> > CellMap; ///< CellMap typedef
+
+  double m_cellSize; ///< edge of a cubic cell
+  CellMap m_cells; ///< PHY indices per occupied cell
+  std::vector<Vector> m_positions; ///< position snapshot per PHY index
+  std::vector<bool> m_present; ///< whether a PHY index was inserted
+  uint32_t m_count; ///< number of inserted PHYs
+};
+
+} //namespace ns3
+
+#endif /* PHY_POSITION_GRID_H */
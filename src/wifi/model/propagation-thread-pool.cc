@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/assert.h"
+#include "propagation-thread-pool.h"
+
+namespace ns3 {
+
+PropagationThreadPool::PropagationThreadPool (uint32_t nThreads)
+  : m_nThreads (nThreads),
+    m_nItems (0),
+    m_generation (0),
+    m_pending (0),
+    m_stop (false)
+{
+  NS_ASSERT (nThreads > 0);
+  for (uint32_t id = 1; id < m_nThreads; id++)
+    {
+      m_threads.push_back (std::thread (&PropagationThreadPool::WorkerLoop, this, id));
+    }
+}
+
+PropagationThreadPool::~PropagationThreadPool ()
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all ();
+  for (std::vector<std::thread>::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      i->join ();
+    }
+}
+
+uint32_t
+PropagationThreadPool::GetNThreads (void) const
+{
+  return m_nThreads;
+}
+
+void
+PropagationThreadPool::Run (Job job, uint32_t nItems)
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_job = job;
+    m_nItems = nItems;
+    m_pending = m_nThreads - 1;
+    m_generation++;
+  }
+  m_start.notify_all ();
+  RunSlice (0);
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (m_pending > 0)
+    {
+      m_done.wait (lock);
+    }
+}
+
+void
+PropagationThreadPool::WorkerLoop (uint32_t id)
+{
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      while (!m_stop && m_generation == seen)
+        {
+          m_start.wait (lock);
+        }
+      if (m_stop)
+        {
+          return;
+        }
+      seen = m_generation;
+      lock.unlock ();
+      RunSlice (id);
+      lock.lock ();
+      if (--m_pending == 0)
+        {
+          m_done.notify_one ();
+        }
+    }
+}
+
+void
+PropagationThreadPool::RunSlice (uint32_t id)
+{
+  // The job fields are only written by Run while no slice is running
+  uint32_t begin = (uint64_t)m_nItems * id / m_nThreads;
+  uint32_t end = (uint64_t)m_nItems * (id + 1) / m_nThreads;
+  if (begin < end)
+    {
+      m_job (begin, end, id);
+    }
+}
+
+} //namespace ns3
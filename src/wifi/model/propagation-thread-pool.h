@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#ifndef PROPAGATION_THREAD_POOL_H
+#define PROPAGATION_THREAD_POOL_H
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * \brief Small fixed pool of threads splitting a range of independent items
+ *
+ * Run blocks the simulation thread until every item is processed; the
+ * simulation thread processes the first slice itself. The job must only
+ * read shared state and write to the slots of its own items; in particular
+ * it must not schedule events, log, or copy ns-3 smart pointers to objects
+ * that other threads use, since reference counts are not atomic.
+ */
+class PropagationThreadPool
+{
+public:
+  /**
+   * Job signature: first item, one past the last item, worker id
+   */
+  typedef Callback<void, uint32_t, uint32_t, uint32_t> Job;
+
+  /**
+   * \param nThreads the number of threads, including the simulation thread
+   */
+  PropagationThreadPool (uint32_t nThreads);
+  ~PropagationThreadPool ();
+
+  /**
+   * Split the items in one contiguous slice per thread and process them
+   * \param job the function processing a slice
+   * \param nItems the number of items
+   */
+  void Run (Job job, uint32_t nItems);
+  /// \returns the number of threads, including the simulation thread
+  uint32_t GetNThreads (void) const;
+
+private:
+  /**
+   * Body of the pool threads
+   * \param id the worker id, starting at 1
+   */
+  void WorkerLoop (uint32_t id);
+  /**
+   * Process the slice of a worker
+   * \param id the worker id
+   */
+  void RunSlice (uint32_t id);
+
+  uint32_t m_nThreads;                 ///< number of threads, including the simulation thread
+  std::vector<std::thread> m_threads;  ///< pool threads
+  std::mutex m_mutex;                  ///< protects the fields below
+  std::condition_variable m_start;     ///< signaled when a job is posted or the pool stops
+  std::condition_variable m_done;      ///< signaled when the last slice is done
+  Job m_job;                           ///< current job
+  uint32_t m_nItems;                   ///< number of items of the current job
+  uint64_t m_generation;               ///< incremented for every job
+  uint32_t m_pending;                  ///< pool threads still processing the current job
+  bool m_stop;                         ///< set when the pool is destroyed
+};
+
+} //namespace ns3
+
+#endif /* PROPAGATION_THREAD_POOL_H */
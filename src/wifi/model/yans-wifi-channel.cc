@@ -27,10 +27,15 @@
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
 #include "ns3/mobility-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+#include <limits>
 #include "yans-wifi-channel.h"
 #include "yans-wifi-phy.h"
 #include "wifi-utils.h"
-#include "rx-power-tag.h"
 
 namespace ns3 {
 
@@ -38,6 +43,72 @@ NS_LOG_COMPONENT_DEFINE ("YansWifiChannel");
 
 NS_OBJECT_ENSURE_REGISTERED (YansWifiChannel);
 
+/// Distance beyond which the range of a transmission is considered unbounded (m)
+static const double MAX_CULLING_RANGE = 1e6;
+/// Resolution of the maximum range search (m)
+static const double CULLING_RANGE_RESOLUTION = 0.01;
+/// Receivers per item when a batched transmission is split among threads, a multiple of the SIMD width
+static const uint32_t BATCH_BLOCK = 4;
+
+/**
+ * \ingroup wifi
+ *
+ * Listener registered by YansWifiChannel with every attached PHY. A PHY
+ * only notifies the switching state when it really changes channel, which
+ * for a switch requested during a transmission is once that transmission
+ * ends, so the per channel PHY lists follow postponed switches too.
+ */
+class YansWifiChannelPhyListener : public WifiPhyListener
+{
+public:
+  /**
+   * Create a listener
+   * \param switched invoked when a PHY starts switching channel
+   */
+  YansWifiChannelPhyListener (Callback<void> switched)
+    : m_switched (switched)
+  {
+  }
+  virtual ~YansWifiChannelPhyListener ()
+  {
+  }
+  void NotifyRxStart (Time duration)
+  {
+  }
+  void NotifyRxEndOk (void)
+  {
+  }
+  void NotifyRxEndError (void)
+  {
+  }
+  void NotifyTxStart (Time duration, double txPowerDbm)
+  {
+  }
+  void NotifyMaybeCcaBusyStart (Time duration)
+  {
+  }
+  void NotifySwitchingStart (Time duration)
+  {
+    //The new channel number is set right after, the buckets are rebuilt lazily
+    m_switched ();
+  }
+  void NotifySleep (void)
+  {
+  }
+  void NotifyOff (void)
+  {
+  }
+  void NotifyWakeup (void)
+  {
+  }
+  void NotifyOn (void)
+  {
+  }
+
+private:
+  Callback<void> m_switched; ///< the channel to notify
+};
+
 TypeId
 YansWifiChannel::GetTypeId (void)
 {
@@ -53,11 +124,92 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("SpatialIndex",
+                   "Skip the receivers that are out of range of a transmission using a grid of the PHY positions. "
+                   "Only used when the propagation loss models depend on distance alone (Friis, LogDistance, "
+                   "ThreeLogDistance, Kun2600Mhz, Range)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_spatialIndex),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CullingMargin",
+                   "Signals this many dB below the EnergyDetectionThreshold of a receiver are still delivered "
+                   "when SpatialIndex is enabled, so that they add to its interference",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_cullingMargin),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("SpatialIndexRefresh",
+                   "Maximum age of the PHY positions snapshot used by SpatialIndex, the snapshot is also "
+                   "refreshed whenever a node changes its course",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&YansWifiChannel::m_spatialIndexRefresh),
+                   MakeTimeChecker ())
+    .AddAttribute ("PathLossCache",
+                   "Cache the rx power and propagation delay of every sender/receiver pair until either "
+                   "node changes its course. Only used with deterministic loss models (Friis, LogDistance, "
+                   "ThreeLogDistance, TwoRayGround, ItuR1411Los, ItuR1411NlosOverRooftop, Kun2600Mhz) and "
+                   "the ConstantSpeed delay model",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_pathLossCache),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PathLossCacheQuantum",
+                   "How long a cached pair is reused while one of its nodes is moving, e.g. under ns2 mobility. "
+                   "Zero means pairs of moving nodes are never cached",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&YansWifiChannel::m_pathLossCacheQuantum),
+                   MakeTimeChecker ())
+    .AddAttribute ("BatchedPathLoss",
+                   "Compute the rx power of all the receivers of a transmission in one pass when the loss "
+                   "chain only contains Friis and LogDistance models. The parameters of these models are "
+                   "read at the first transmission",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_batchedPathLoss),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PropagationThreads",
+                   "Number of threads computing the rx powers of a transmission, including the simulation "
+                   "thread. Splits the BatchedPathLoss pass when it applies, otherwise only used with the "
+                   "deterministic models supported by PathLossCache. Never used when the PathLossCache is in use. "
+                   "Propagation logging must be disabled when greater than 1",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&YansWifiChannel::m_propagationThreads),
+                   MakeUintegerChecker<uint32_t> (1, 64))
+    .AddAttribute ("PropagationThreadThreshold",
+                   "Minimum number of receivers of a transmission for the propagation threads to be used",
+                   UintegerValue (200),
+                   MakeUintegerAccessor (&YansWifiChannel::m_propagationThreadThreshold),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
+YansWifiChannel::PathLossEntry::PathLossEntry ()
+  : txPowerDbm (0.0),
+    rxPowerDbm (0.0),
+    senderEpoch (0),
+    receiverEpoch (0),
+    moving (false)
+{
+}
+
 YansWifiChannel::YansWifiChannel ()
+  : m_spatialIndex (false),
+    m_cullingMargin (0.0),
+    m_spatialIndexRefresh (Seconds (1.0)),
+    m_cullable (-1),
+    m_gridValid (false),
+    m_gridMaxSpeed (0.0),
+    m_minSensitivityDbm (0.0),
+    m_pathLossCache (false),
+    m_pathLossCacheQuantum (Seconds (0)),
+    m_cacheable (-1),
+    m_mobilityHooked (false),
+    m_batchedPathLoss (false),
+    m_batchable (-1),
+    m_bucketsValid (false),
+    m_phyListener (0),
+    m_propagationThreads (1),
+    m_propagationThreadThreshold (200),
+    m_threadPool (0),
+    m_parallelTxPowerDbm (0.0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -65,7 +217,26 @@ YansWifiChannel::YansWifiChannel ()
 YansWifiChannel::~YansWifiChannel ()
 {
   NS_LOG_FUNCTION (this);
+  if (m_phyListener != 0)
+    {
+      for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+        {
+          //A disposed PHY has no channel left and has dropped its listeners
+          if ((*i)->GetChannel () != 0)
+            {
+              (*i)->UnregisterListener (m_phyListener);
+            }
+        }
+    }
   m_phyList.clear ();
+  m_phyMobility.clear ();
+  m_phyIndex.clear ();
+  m_pairCache.clear ();
+  delete m_threadPool;
+  m_threadPool = 0;
+  delete m_phyListener;
+  m_phyListener = 0;
+  m_workerMobility.clear ();
 }
 
 void
@@ -73,6 +244,11 @@ YansWifiChannel::SetPropagationLossModel (const Ptr<PropagationLossModel> loss)
 {
   NS_LOG_FUNCTION (this << loss);
   m_loss = loss;
+  m_cullable = -1;
+  m_cacheable = -1;
+  m_batchable = -1;
+  m_maxRange.clear ();
+  m_pairCache.clear ();
 }
 
 void
@@ -80,6 +256,8 @@ YansWifiChannel::SetPropagationDelayModel (const Ptr<PropagationDelayModel> dela
 {
   NS_LOG_FUNCTION (this << delay);
   m_delay = delay;
+  m_cacheable = -1;
+  m_pairCache.clear ();
 }
 
 void
@@ -88,23 +266,124 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << duration.GetSeconds ());
   Ptr<MobilityModel> senderMobility = sender->GetMobility ();
   NS_ASSERT (senderMobility != 0);
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+  bool cache = m_pathLossCache && IsLossChainCacheable ();
+  if ((m_spatialIndex || cache) && !m_mobilityHooked)
     {
-      if (sender != (*i))
+      HookMobility ();
+    }
+  uint32_t senderIndex = 0;
+  if (cache)
+    {
+      std::map<Ptr<YansWifiPhy>, uint32_t>::const_iterator i = m_phyIndex.find (sender);
+      NS_ASSERT (i != m_phyIndex.end ());
+      senderIndex = i->second;
+    }
+  bool cull = false;
+  std::vector<uint32_t> candidates;
+  if (m_spatialIndex && IsLossChainCullable ())
+    {
+      UpdateSpatialIndex (txPowerDbm);
+      double range = GetMaxRange (txPowerDbm);
+      if (range >= 0)
+        {
+          //Receivers may have moved since the snapshot of their positions was taken
+          double radius = range + m_gridMaxSpeed * (Simulator::Now () - m_gridTimeStamp).GetSeconds ();
+          m_grid.Query (senderMobility->GetPosition (), radius, candidates);
+          cull = true;
+        }
+    }
+  //Only PHYs tuned to the sender channel can receive the frame
+  const std::vector<uint32_t> &receivers = cull ? candidates : GetChannelBucket (sender->GetChannelNumber ());
+  std::size_t nReceivers = receivers.size ();
+  bool batch = !cache && m_batchedPathLoss && IsLossChainBatchable ();
+  bool parallel = !cache && (m_propagationThreads > 1) && (nReceivers >= m_propagationThreadThreshold)
+    && (batch || IsLossChainCacheable ());
+  double delaySpeed = 0;
+  if (batch || parallel)
+    {
+      //Snapshot the receiver positions and compute all the rx powers in one pass
+      m_batchX.clear ();
+      m_batchY.clear ();
+      m_batchZ.clear ();
+      for (std::size_t k = 0; k < nReceivers; k++)
+        {
+          Vector position = m_phyList[receivers[k]]->GetMobility ()->GetPosition ();
+          m_batchX.push_back (position.x);
+          m_batchY.push_back (position.y);
+          m_batchZ.push_back (position.z);
+        }
+    }
+  if (parallel)
+    {
+      PrepareThreadPool ();
+      m_parallelSender = senderMobility->GetPosition ();
+      m_parallelTxPowerDbm = txPowerDbm;
+      m_batchRxPower.resize (nReceivers);
+      m_parallelDistance.resize (nReceivers);
+      if (batch)
+        {
+          //Blocks of BATCH_BLOCK receivers keep the vectorized part of each slice aligned
+          m_threadPool->Run (MakeCallback (&YansWifiChannel::CalcBatchSlice, this),
+                             (nReceivers + BATCH_BLOCK - 1) / BATCH_BLOCK);
+        }
+      else
+        {
+          m_threadPool->Run (MakeCallback (&YansWifiChannel::CalcPropagationSlice, this), nReceivers);
+          delaySpeed = DynamicCast<ConstantSpeedPropagationDelayModel> (m_delay)->GetSpeed ();
+        }
+    }
+  else if (batch)
+    {
+      m_batch.CalcRxPower (txPowerDbm, senderMobility->GetPosition (), m_batchX, m_batchY, m_batchZ, m_batchRxPower);
+    }
+  for (std::size_t k = 0; k < nReceivers; k++)
+    {
+      uint32_t receiverIndex = receivers[k];
+      Ptr<YansWifiPhy> receiver = m_phyList[receiverIndex];
+      if (sender != receiver)
         {
           //For now don't account for inter channel interference nor channel bonding
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
+          if (receiver->GetChannelNumber () != sender->GetChannelNumber ())
             {
+              if (!cull)
+                {
+                  //Channel changed without a switching notification
+                  m_bucketsValid = false;
+                }
               continue;
             }
 
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+          Ptr<MobilityModel> receiverMobility = receiver->GetMobility ()->GetObject<MobilityModel> ();
+          double rxPowerDbm;
+          Time delay;
+          if (batch)
+            {
+              rxPowerDbm = m_batchRxPower[k];
+              delay = m_delay->GetDelay (senderMobility, receiverMobility);
+            }
+          else if (parallel)
+            {
+              //Same computation as ConstantSpeedPropagationDelayModel::GetDelay
+              rxPowerDbm = m_batchRxPower[k];
+              delay = Seconds (m_parallelDistance[k] / delaySpeed);
+            }
+          else if (!cache || !LookupPathLoss (senderIndex, receiverIndex, txPowerDbm, rxPowerDbm, delay))
+            {
+              rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+              delay = m_delay->GetDelay (senderMobility, receiverMobility);
+              if (cache)
+                {
+                  StorePathLoss (senderIndex, receiverIndex, txPowerDbm, rxPowerDbm, delay, senderMobility, receiverMobility);
+                }
+            }
+          if (cull && (rxPowerDbm + receiver->GetRxGain () < receiver->GetEdThreshold () - m_cullingMargin))
+            {
+              NS_LOG_DEBUG ("propagation: rxPower=" << rxPowerDbm << "dbm is below the sensitivity of " << receiver);
+              continue;
+            }
           NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
                         "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<NetDevice> dstNetDevice = (*i)->GetDevice ();
+          Ptr<NetDevice> dstNetDevice = receiver->GetDevice ();
           uint32_t dstNode;
           if (dstNetDevice == 0)
             {
@@ -117,24 +396,16 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 
           Simulator::ScheduleWithContext (dstNode,
                                           delay, &YansWifiChannel::Receive,
-                                          (*i), copy, rxPowerDbm, duration);
+                                          receiver, packet, rxPowerDbm, duration);
         }
     }
 }
 
 void
-YansWifiChannel::Receive (Ptr<YansWifiPhy> phy, Ptr<Packet> packet, double rxPowerDbm, Time duration)
+YansWifiChannel::Receive (Ptr<YansWifiPhy> phy, Ptr<const Packet> packet, double rxPowerDbm, Time duration)
 {
   NS_LOG_FUNCTION (phy << packet << rxPowerDbm << duration.GetSeconds ());
-  RxPowerTag rxPowerTag;
-  if (!packet->PeekPacketTag (rxPowerTag))
-    {
-      rxPowerTag.SetRxPower (rxPowerDbm + phy->GetRxGain());
-      packet->AddPacketTag (rxPowerTag);
-    }
-  else
-    NS_FATAL_ERROR ("Packet is not supposed to be received with the Power Tag from the network");
-  phy->StartReceivePreambleAndHeader (packet, DbmToW (rxPowerDbm + phy->GetRxGain ()), duration);
+  phy->StartReceivePreambleAndHeader (packet->Copy (), DbmToW (rxPowerDbm + phy->GetRxGain ()), duration);
 }
 
 std::size_t
@@ -153,7 +424,320 @@ void
 YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
   NS_LOG_FUNCTION (this << phy);
+  if (m_phyListener == 0)
+    {
+      m_phyListener = new YansWifiChannelPhyListener (MakeCallback (&YansWifiChannel::InvalidateChannelBuckets, this));
+    }
+  phy->RegisterListener (m_phyListener);
+  m_phyIndex[phy] = m_phyList.size ();
   m_phyList.push_back (phy);
+  m_gridValid = false;
+  m_mobilityHooked = false;
+  m_bucketsValid = false;
+  m_pairCache.clear ();
+}
+
+bool
+YansWifiChannel::IsLossChainCullable (void) const
+{
+  if (m_cullable < 0)
+    {
+      m_cullable = (m_loss != 0) ? 1 : 0;
+      for (Ptr<PropagationLossModel> model = m_loss; model != 0; model = model->GetNext ())
+        {
+          std::string name = model->GetInstanceTypeId ().GetName ();
+          if ((name != "ns3::FriisPropagationLossModel")
+              && (name != "ns3::LogDistancePropagationLossModel")
+              && (name != "ns3::ThreeLogDistancePropagationLossModel")
+              && (name != "ns3::Kun2600MhzPropagationLossModel")
+              && (name != "ns3::RangePropagationLossModel"))
+            {
+              NS_LOG_WARN ("SpatialIndex disabled, " << name << " does not depend on distance alone");
+              m_cullable = 0;
+              break;
+            }
+        }
+    }
+  return (m_cullable == 1);
+}
+
+void
+YansWifiChannel::UpdateSpatialIndex (double txPowerDbm) const
+{
+  if (m_gridValid && (Simulator::Now () - m_gridTimeStamp <= m_spatialIndexRefresh))
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << txPowerDbm);
+  double minSensitivityDbm = std::numeric_limits<double>::max ();
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      minSensitivityDbm = std::min (minSensitivityDbm, (*i)->GetEdThreshold () - (*i)->GetRxGain () - m_cullingMargin);
+    }
+  if (minSensitivityDbm != m_minSensitivityDbm)
+    {
+      m_minSensitivityDbm = minSensitivityDbm;
+      m_maxRange.clear ();
+    }
+  double cellSize = GetMaxRange (txPowerDbm);
+  m_grid.Reset (cellSize > 0 ? cellSize : MAX_CULLING_RANGE);
+  m_gridMaxSpeed = 0;
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      Ptr<MobilityModel> mobility = m_phyMobility[i];
+      m_grid.Insert (i, mobility->GetPosition ());
+      m_gridMaxSpeed = std::max (m_gridMaxSpeed, CalculateDistance (mobility->GetVelocity (), Vector (0, 0, 0)));
+    }
+  m_gridTimeStamp = Simulator::Now ();
+  m_gridValid = true;
+}
+
+double
+YansWifiChannel::GetMaxRange (double txPowerDbm) const
+{
+  std::map<double, double>::const_iterator i = m_maxRange.find (txPowerDbm);
+  if (i != m_maxRange.end ())
+    {
+      return i->second;
+    }
+  //Only loss models that decrease monotonically with distance are accepted,
+  //so bracket the range and then bisect it
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 0));
+  double inRange = 0;
+  double outOfRange = 1;
+  b->SetPosition (Vector (outOfRange, 0, 0));
+  while (m_loss->CalcRxPower (txPowerDbm, a, b) >= m_minSensitivityDbm)
+    {
+      inRange = outOfRange;
+      outOfRange *= 2;
+      if (outOfRange > MAX_CULLING_RANGE)
+        {
+          NS_LOG_DEBUG ("Range of a " << txPowerDbm << "dBm transmission is unbounded");
+          m_maxRange[txPowerDbm] = -1;
+          return -1;
+        }
+      b->SetPosition (Vector (outOfRange, 0, 0));
+    }
+  while (outOfRange - inRange > CULLING_RANGE_RESOLUTION)
+    {
+      double middle = (inRange + outOfRange) / 2;
+      b->SetPosition (Vector (middle, 0, 0));
+      if (m_loss->CalcRxPower (txPowerDbm, a, b) >= m_minSensitivityDbm)
+        {
+          inRange = middle;
+        }
+      else
+        {
+          outOfRange = middle;
+        }
+    }
+  NS_LOG_DEBUG ("Range of a " << txPowerDbm << "dBm transmission is " << outOfRange << "m");
+  m_maxRange[txPowerDbm] = outOfRange;
+  return outOfRange;
+}
+
+void
+YansWifiChannel::HookMobility (void) const
+{
+  NS_LOG_FUNCTION (this);
+  m_phyMobility.resize (m_phyList.size ());
+  m_phyEpoch.resize (m_phyList.size (), 0);
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[i]->GetMobility ()->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      if (mobility == m_phyMobility[i])
+        {
+          continue;
+        }
+      if (m_phyMobility[i] != 0)
+        {
+          m_phyMobility[i]->TraceDisconnectWithoutContext ("CourseChange",
+                                                           MakeCallback (&YansWifiChannel::NotifyCourseChange, this));
+        }
+      //Interfaces of the same node share the model, only connect it once
+      if (std::find (m_phyMobility.begin (), m_phyMobility.end (), mobility) == m_phyMobility.end ())
+        {
+          mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&YansWifiChannel::NotifyCourseChange, this));
+        }
+      m_phyMobility[i] = mobility;
+      m_phyEpoch[i]++;
+    }
+  m_mobilityHooked = true;
+}
+
+void
+YansWifiChannel::NotifyCourseChange (Ptr<const MobilityModel> model) const
+{
+  m_gridValid = false;
+  for (uint32_t i = 0; i < m_phyMobility.size (); i++)
+    {
+      if (m_phyMobility[i] == model)
+        {
+          m_phyEpoch[i]++;
+        }
+    }
+}
+
+bool
+YansWifiChannel::IsLossChainCacheable (void) const
+{
+  if (m_cacheable < 0)
+    {
+      m_cacheable = ((m_loss != 0) && (m_delay != 0)) ? 1 : 0;
+      if ((m_delay != 0) && (m_delay->GetInstanceTypeId ().GetName () != "ns3::ConstantSpeedPropagationDelayModel"))
+        {
+          NS_LOG_WARN ("PathLossCache disabled, the propagation delay model is not deterministic");
+          m_cacheable = 0;
+        }
+      for (Ptr<PropagationLossModel> model = m_loss; (model != 0) && (m_cacheable == 1); model = model->GetNext ())
+        {
+          std::string name = model->GetInstanceTypeId ().GetName ();
+          if ((name != "ns3::FriisPropagationLossModel")
+              && (name != "ns3::LogDistancePropagationLossModel")
+              && (name != "ns3::ThreeLogDistancePropagationLossModel")
+              && (name != "ns3::TwoRayGroundPropagationLossModel")
+              && (name != "ns3::ItuR1411LosPropagationLossModel")
+              && (name != "ns3::ItuR1411NlosOverRooftopPropagationLossModel")
+              && (name != "ns3::Kun2600MhzPropagationLossModel"))
+            {
+              NS_LOG_WARN ("PathLossCache disabled, " << name << " is not deterministic");
+              m_cacheable = 0;
+            }
+        }
+    }
+  return (m_cacheable == 1);
+}
+
+void
+YansWifiChannel::InvalidateChannelBuckets (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_bucketsValid = false;
+}
+
+const std::vector<uint32_t> &
+YansWifiChannel::GetChannelBucket (uint16_t channelNumber) const
+{
+  //The sender is on the PHY list, so a missing bucket means a channel change was not
+  //seen, e.g. the initial channel configured when the PHY was initialized
+  if (!m_bucketsValid || (m_buckets.find (channelNumber) == m_buckets.end ()))
+    {
+      NS_LOG_DEBUG ("Rebuilding the per channel PHY lists");
+      m_buckets.clear ();
+      for (uint32_t i = 0; i < m_phyList.size (); i++)
+        {
+          m_buckets[m_phyList[i]->GetChannelNumber ()].push_back (i);
+        }
+      m_bucketsValid = true;
+    }
+  return m_buckets[channelNumber];
+}
+
+void
+YansWifiChannel::PrepareThreadPool (void) const
+{
+  if ((m_threadPool != 0) && (m_threadPool->GetNThreads () == m_propagationThreads))
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << m_propagationThreads);
+  delete m_threadPool;
+  m_threadPool = new PropagationThreadPool (m_propagationThreads);
+  //Each thread places the two ends of a link on its own mobility models
+  m_workerMobility.clear ();
+  for (uint32_t i = 0; i < 2 * m_propagationThreads; i++)
+    {
+      m_workerMobility.push_back (CreateObject<ConstantPositionMobilityModel> ());
+    }
+}
+
+void
+YansWifiChannel::CalcPropagationSlice (uint32_t begin, uint32_t end, uint32_t worker) const
+{
+  MobilityModel *a = PeekPointer (m_workerMobility[2 * worker]);
+  MobilityModel *b = PeekPointer (m_workerMobility[2 * worker + 1]);
+  a->SetPosition (m_parallelSender);
+  for (uint32_t i = begin; i < end; i++)
+    {
+      b->SetPosition (Vector (m_batchX[i], m_batchY[i], m_batchZ[i]));
+      m_batchRxPower[i] = m_loss->CalcRxPower (m_parallelTxPowerDbm, a, b);
+      m_parallelDistance[i] = a->GetDistanceFrom (b);
+    }
+}
+
+void
+YansWifiChannel::CalcBatchSlice (uint32_t beginBlock, uint32_t endBlock, uint32_t worker) const
+{
+  uint32_t begin = beginBlock * BATCH_BLOCK;
+  uint32_t end = std::min<uint32_t> (endBlock * BATCH_BLOCK, m_batchX.size ());
+  if (begin >= end)
+    {
+      return;
+    }
+  m_batch.CalcRxPower (m_parallelTxPowerDbm, m_parallelSender, &m_batchX[begin], &m_batchY[begin], &m_batchZ[begin],
+                       &m_parallelDistance[begin], &m_batchRxPower[begin], end - begin);
+}
+
+bool
+YansWifiChannel::IsLossChainBatchable (void) const
+{
+  if (m_batchable < 0)
+    {
+      m_batchable = m_batch.Build (m_loss) ? 1 : 0;
+    }
+  return (m_batchable == 1);
+}
+
+bool
+YansWifiChannel::LookupPathLoss (uint32_t senderIndex, uint32_t receiverIndex, double txPowerDbm,
+                                 double &rxPowerDbm, Time &delay) const
+{
+  if (m_pairCache.empty ())
+    {
+      return false;
+    }
+  const PathLossEntry &entry = m_pairCache[senderIndex * m_phyList.size () + receiverIndex];
+  if ((entry.txPowerDbm != txPowerDbm)
+      || (entry.senderEpoch != m_phyEpoch[senderIndex])
+      || (entry.receiverEpoch != m_phyEpoch[receiverIndex]))
+    {
+      return false;
+    }
+  if (entry.moving && (Simulator::Now () - entry.whenStored >= m_pathLossCacheQuantum))
+    {
+      return false;
+    }
+  rxPowerDbm = entry.rxPowerDbm;
+  delay = entry.delay;
+  return true;
+}
+
+void
+YansWifiChannel::StorePathLoss (uint32_t senderIndex, uint32_t receiverIndex, double txPowerDbm,
+                                double rxPowerDbm, Time delay,
+                                Ptr<MobilityModel> senderMobility, Ptr<MobilityModel> receiverMobility) const
+{
+  bool moving = (CalculateDistance (senderMobility->GetVelocity (), Vector (0, 0, 0)) > 0)
+    || (CalculateDistance (receiverMobility->GetVelocity (), Vector (0, 0, 0)) > 0);
+  if (moving && m_pathLossCacheQuantum.IsZero ())
+    {
+      return;
+    }
+  if (m_pairCache.empty ())
+    {
+      m_pairCache.resize (m_phyList.size () * m_phyList.size ());
+    }
+  PathLossEntry &entry = m_pairCache[senderIndex * m_phyList.size () + receiverIndex];
+  entry.txPowerDbm = txPowerDbm;
+  entry.rxPowerDbm = rxPowerDbm;
+  entry.delay = delay;
+  entry.whenStored = Simulator::Now ();
+  entry.senderEpoch = m_phyEpoch[senderIndex];
+  entry.receiverEpoch = m_phyEpoch[receiverIndex];
+  entry.moving = moving;
 }
 
 int64_t
@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2006,2007 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mathieu Lacage, <mathieu.lacage@sophia.inria.fr>
+ */
+
+#ifndef YANS_WIFI_CHANNEL_H
+#define YANS_WIFI_CHANNEL_H
+
+#include <map>
+#include "ns3/channel.h"
+#include "ns3/nstime.h"
+#include "phy-position-grid.h"
+#include "path-loss-batch.h"
+#include "propagation-thread-pool.h"
+
+namespace ns3 {
+
+class NetDevice;
+class PropagationLossModel;
+class PropagationDelayModel;
+class MobilityModel;
+class YansWifiPhy;
+class Packet;
+class YansWifiChannelPhyListener;
+
+/**
+ * \brief a channel to interconnect ns3::YansWifiPhy objects.
+ * \ingroup wifi
+ *
+ * This class is expected to be used in tandem with the ns3::YansWifiPhy
+ * class and supports an ns3::PropagationLossModel and an
+ * ns3::PropagationDelayModel.  By default, no propagation models are set;
+ * it is the caller's responsibility to set them before using the channel.
+ *
+ * When the SpatialIndex attribute is enabled and the loss model chain only
+ * depends on the distance between the nodes, the channel keeps a grid of
+ * the PHY positions and only considers the receivers within the maximum
+ * range of the transmission. That range is derived from the tx power, the
+ * loss model and the lowest EnergyDetectionThreshold of the attached PHYs.
+ * Receivers below their EnergyDetectionThreshold (minus CullingMargin) are
+ * not delivered the frame, hence such weak signals do not add to their
+ * interference either.
+ *
+ * When the PathLossCache attribute is enabled and the loss and delay models
+ * are deterministic, the rx power and delay of every sender/receiver pair
+ * are reused until either PHY's mobility model reports a course change.
+ * Pairs with a moving node are reused for PathLossCacheQuantum at most.
+ *
+ * When the loss chain only holds Friis and LogDistance models, the rx
+ * powers of all the receivers are computed in one pass by PathLossBatch
+ * (BatchedPathLoss attribute, disabled by default).
+ *
+ * When a transmission has at least PropagationThreadThreshold receivers,
+ * the rx powers can be split among PropagationThreads threads, either as
+ * slices of the PathLossBatch pass or, for other deterministic models, one
+ * CalcRxPower per receiver. Receptions are still scheduled by the
+ * simulation thread in PHY list order, so the results do not depend on
+ * the number of threads.
+ */
+class YansWifiChannel : public Channel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  YansWifiChannel ();
+  virtual ~YansWifiChannel ();
+
+  //inherited from Channel.
+  std::size_t GetNDevices (void) const;
+  Ptr<NetDevice> GetDevice (std::size_t i) const;
+
+  /**
+   * Adds the given YansWifiPhy to the PHY list
+   *
+   * \param phy the YansWifiPhy to be added to the PHY list
+   */
+  void Add (Ptr<YansWifiPhy> phy);
+
+  /**
+   * \param loss the new propagation loss model.
+   */
+  void SetPropagationLossModel (const Ptr<PropagationLossModel> loss);
+  /**
+   * \param delay the new propagation delay model.
+   */
+  void SetPropagationDelayModel (const Ptr<PropagationDelayModel> delay);
+
+  /**
+   * \param sender the phy object from which the packet is originating.
+   * \param packet the packet to send
+   * \param txPowerDbm the tx power associated to the packet, in dBm
+   * \param duration the transmission duration associated with the packet
+   *
+   * This method should not be invoked by normal users. It is
+   * currently invoked only from YansWifiPhy::StartTx.  The channel
+   * attempts to deliver the packet to all other YansWifiPhy objects
+   * on the channel (except for the sender).
+   */
+  void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm, Time duration) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   *
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+
+private:
+  /**
+   * A vector of pointers to YansWifiPhy.
+   */
+  typedef std::vector<Ptr<YansWifiPhy> > PhyList;
+
+  /**
+   * This method is scheduled by Send for each associated YansWifiPhy.
+   * The method then calls the corresponding YansWifiPhy that the first
+   * bit of the packet has arrived.
+   *
+   * All the receptions of a transmission share the packet of the sender
+   * until then. Each receiver still gets its own copy here, as before the
+   * copy was made in Send, because the stock PHY and MAC remove tags and
+   * headers from the packet they are handed.
+   *
+   * \param receiver the device to which the packet is destined
+   * \param packet the packet being sent, shared by all the receivers
+   * \param txPowerDbm the tx power associated to the packet being sent (dBm)
+   * \param duration the transmission duration associated with the packet being sent
+   */
+  static void Receive (Ptr<YansWifiPhy> receiver, Ptr<const Packet> packet, double txPowerDbm, Time duration);
+
+  ///\name Spatial receiver culling
+  //\{
+  /**
+   * \returns true if every model in the loss chain is deterministic and only depends on distance
+   */
+  bool IsLossChainCullable (void) const;
+  /**
+   * Take a new snapshot of the PHY positions when nodes moved or the refresh interval elapsed
+   * \param txPowerDbm the tx power of the transmission being sent, used to size the grid cells
+   */
+  void UpdateSpatialIndex (double txPowerDbm) const;
+  /**
+   * \param txPowerDbm the tx power of the transmission
+   * \returns the distance beyond which no PHY can sense the transmission, negative if unbounded
+   */
+  double GetMaxRange (double txPowerDbm) const;
+  /**
+   * CourseChange sink of the mobility models of the attached PHYs
+   * \param model the mobility model that changed its course
+   */
+  void NotifyCourseChange (Ptr<const MobilityModel> model) const;
+  /**
+   * Connect to the CourseChange trace of the mobility model of each PHY
+   */
+  void HookMobility (void) const;
+  //\}
+
+  ///\name Pairwise path loss cache
+  //\{
+  /// Cached propagation results of a sender/receiver pair
+  struct PathLossEntry
+  {
+    PathLossEntry ();
+    double txPowerDbm;       ///< tx power the entry was computed for
+    double rxPowerDbm;       ///< rx power, before rx gain
+    Time delay;              ///< propagation delay
+    Time whenStored;         ///< when the entry was computed
+    uint32_t senderEpoch;    ///< course change count of the sender
+    uint32_t receiverEpoch;  ///< course change count of the receiver
+    bool moving;             ///< either PHY was moving when computed
+  };
+  /**
+   * \returns true if the loss and delay models always give the same result for the same positions
+   */
+  bool IsLossChainCacheable (void) const;
+  /**
+   * \param senderIndex index of the sender in the PHY list
+   * \param receiverIndex index of the receiver in the PHY list
+   * \param txPowerDbm the tx power of the transmission
+   * \param rxPowerDbm the cached rx power, if found
+   * \param delay the cached propagation delay, if found
+   * \returns true if a valid entry was found
+   */
+  bool LookupPathLoss (uint32_t senderIndex, uint32_t receiverIndex, double txPowerDbm,
+                       double &rxPowerDbm, Time &delay) const;
+  /**
+   * \param senderIndex index of the sender in the PHY list
+   * \param receiverIndex index of the receiver in the PHY list
+   * \param txPowerDbm the tx power of the transmission
+   * \param rxPowerDbm the rx power computed by the loss model
+   * \param delay the delay computed by the delay model
+   * \param senderMobility the mobility model of the sender
+   * \param receiverMobility the mobility model of the receiver
+   */
+  void StorePathLoss (uint32_t senderIndex, uint32_t receiverIndex, double txPowerDbm,
+                      double rxPowerDbm, Time delay,
+                      Ptr<MobilityModel> senderMobility, Ptr<MobilityModel> receiverMobility) const;
+  //\}
+
+  /**
+   * \returns true if the loss chain can be computed by PathLossBatch
+   */
+  bool IsLossChainBatchable (void) const;
+  /**
+   * \param channelNumber the channel number
+   * \returns the indices of the PHYs tuned to that channel, in PHY list order
+   */
+  const std::vector<uint32_t> & GetChannelBucket (uint16_t channelNumber) const;
+  /**
+   * Rebuild the per channel PHY lists at the next transmission, called
+   * when an attached PHY actually switches channel
+   */
+  void InvalidateChannelBuckets (void);
+  /**
+   * Create the thread pool, or recreate it if PropagationThreads changed
+   */
+  void PrepareThreadPool (void) const;
+  /**
+   * Compute the rx power and distance of a slice of the position snapshot, run by the pool threads
+   * \param begin the first receiver of the slice
+   * \param end one past the last receiver of the slice
+   * \param worker the id of the thread
+   */
+  void CalcPropagationSlice (uint32_t begin, uint32_t end, uint32_t worker) const;
+  /**
+   * Compute the batched rx powers of a slice of the position snapshot, run by the pool threads
+   * \param beginBlock the first block of BATCH_BLOCK receivers of the slice
+   * \param endBlock one past the last block of the slice
+   * \param worker the id of the thread
+   */
+  void CalcBatchSlice (uint32_t beginBlock, uint32_t endBlock, uint32_t worker) const;
+
+  /// PHY indices per channel number
+  typedef std::map<uint16_t, std::vector<uint32_t> > ChannelBuckets;
+
+  PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
+  Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
+  Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+
+  bool m_spatialIndex;                 //!< Cull out of range receivers
+  double m_cullingMargin;              //!< Margin below the EnergyDetectionThreshold (dB)
+  Time m_spatialIndexRefresh;          //!< Maximum age of the position snapshot
+  mutable int8_t m_cullable;           //!< Loss chain supports culling: -1 unknown, 0 no, 1 yes
+  mutable PhyPositionGrid m_grid;      //!< Snapshot of the PHY positions
+  mutable bool m_gridValid;            //!< False when a node changed its course since the snapshot
+  mutable Time m_gridTimeStamp;        //!< When the snapshot was taken
+  mutable double m_gridMaxSpeed;       //!< Highest PHY speed at the snapshot (m/s)
+  mutable double m_minSensitivityDbm;  //!< Lowest rx power (before rx gain) any PHY can sense
+  mutable std::map<double, double> m_maxRange;            //!< Maximum range per tx power
+  mutable std::vector<Ptr<MobilityModel> > m_phyMobility; //!< Mobility models hooked, per PHY
+
+  bool m_pathLossCache;                //!< Reuse the propagation results of unchanged pairs
+  Time m_pathLossCacheQuantum;         //!< Maximum age of an entry with a moving PHY
+  mutable int8_t m_cacheable;          //!< Models support caching: -1 unknown, 0 no, 1 yes
+  mutable bool m_mobilityHooked;       //!< CourseChange connected for every PHY
+  mutable std::vector<uint32_t> m_phyEpoch;          //!< Course change count, per PHY
+  mutable std::vector<PathLossEntry> m_pairCache;    //!< Entries indexed by sender * N + receiver
+  std::map<Ptr<YansWifiPhy>, uint32_t> m_phyIndex;   //!< Index of each PHY in the PHY list
+
+  bool m_batchedPathLoss;              //!< Compute the rx powers of a transmission in one pass
+  mutable int8_t m_batchable;          //!< Loss chain supports batching: -1 unknown, 0 no, 1 yes
+  mutable PathLossBatch m_batch;       //!< Parameters of the loss chain
+  mutable std::vector<double> m_batchX;       //!< Receiver x coordinates of the current transmission
+  mutable std::vector<double> m_batchY;       //!< Receiver y coordinates of the current transmission
+  mutable std::vector<double> m_batchZ;       //!< Receiver z coordinates of the current transmission
+  mutable std::vector<double> m_batchRxPower; //!< Rx powers of the current transmission
+
+  mutable ChannelBuckets m_buckets;    //!< PHYs per channel number
+  mutable bool m_bucketsValid;         //!< False after a PHY was added or switched channel
+  YansWifiChannelPhyListener *m_phyListener; //!< Registered with every PHY to see its channel switches, unregistered on destruction
+
+  uint32_t m_propagationThreads;       //!< Threads computing the rx powers of a transmission
+  uint32_t m_propagationThreadThreshold; //!< Minimum number of receivers to use the threads
+  mutable PropagationThreadPool *m_threadPool;   //!< Pool, created at the first parallel transmission
+  mutable std::vector<Ptr<MobilityModel> > m_workerMobility; //!< Two private mobility models per thread
+  mutable Vector m_parallelSender;     //!< Sender position of the current transmission
+  mutable double m_parallelTxPowerDbm; //!< Tx power of the current transmission
+  mutable std::vector<double> m_parallelDistance; //!< Distances of the current transmission
+};
+
+} //namespace ns3
+
+#endif /* YANS_WIFI_CHANNEL_H */
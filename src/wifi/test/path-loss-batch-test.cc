@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/path-loss-batch.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief PathLossBatch rx powers against the scalar loss chain
+ *
+ * The receivers are placed at random positions, on top of the sender and
+ * very far from it. Every batched rx power must be within 1e-9 dB of
+ * PropagationLossModel::CalcRxPower, the tolerance documented by
+ * PathLossBatch.
+ */
+class PathLossBatchTest : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param name the test name
+   * \param loss the loss chain
+   */
+  PathLossBatchTest (std::string name, Ptr<PropagationLossModel> loss);
+  virtual ~PathLossBatchTest ();
+
+private:
+  virtual void DoRun (void);
+
+  Ptr<PropagationLossModel> m_loss; ///< the loss chain
+};
+
+PathLossBatchTest::PathLossBatchTest (std::string name, Ptr<PropagationLossModel> loss)
+  : TestCase (name),
+    m_loss (loss)
+{
+}
+
+PathLossBatchTest::~PathLossBatchTest ()
+{
+}
+
+void
+PathLossBatchTest::DoRun (void)
+{
+  const double txPowerDbm = 16.0206;
+  //Odd count so the SIMD loops also leave a scalar remainder
+  const uint32_t nRandom = 1001;
+
+  Ptr<UniformRandomVariable> coordinate = CreateObject<UniformRandomVariable> ();
+  coordinate->SetStream (1);
+  coordinate->SetAttribute ("Min", DoubleValue (-2000));
+  coordinate->SetAttribute ("Max", DoubleValue (2000));
+
+  Vector sender (coordinate->GetValue (), coordinate->GetValue (), coordinate->GetValue ());
+  std::vector<Vector> positions;
+  for (uint32_t i = 0; i < nRandom; i++)
+    {
+      positions.push_back (Vector (coordinate->GetValue (), coordinate->GetValue (), coordinate->GetValue ()));
+    }
+  //Coincident with the sender
+  positions.push_back (sender);
+  //Closer than the LogDistance reference distance
+  positions.push_back (Vector (sender.x + 0.5, sender.y, sender.z));
+  //Very distant nodes
+  positions.push_back (Vector (sender.x + 1e6, sender.y, sender.z));
+  positions.push_back (Vector (-1e7, 1e7, 5e6));
+
+  PathLossBatch batch;
+  NS_TEST_ASSERT_MSG_EQ (batch.Build (m_loss), true, "Loss chain should be batchable");
+
+  std::vector<double> x, y, z, rxPowerDbm;
+  for (std::vector<Vector>::const_iterator i = positions.begin (); i != positions.end (); ++i)
+    {
+      x.push_back (i->x);
+      y.push_back (i->y);
+      z.push_back (i->z);
+    }
+  batch.CalcRxPower (txPowerDbm, sender, x, y, z, rxPowerDbm);
+  NS_TEST_ASSERT_MSG_EQ (rxPowerDbm.size (), positions.size (), "One rx power per receiver");
+
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (sender);
+  for (std::size_t i = 0; i < positions.size (); i++)
+    {
+      b->SetPosition (positions[i]);
+      double expected = m_loss->CalcRxPower (txPowerDbm, a, b);
+      NS_TEST_ASSERT_MSG_EQ_TOL (rxPowerDbm[i], expected, 1e-9, "Rx power of receiver " << i << " at " << positions[i]);
+    }
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief PathLossBatch chain with an unsupported model
+ */
+class PathLossBatchUnsupportedTest : public TestCase
+{
+public:
+  PathLossBatchUnsupportedTest ();
+  virtual ~PathLossBatchUnsupportedTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PathLossBatchUnsupportedTest::PathLossBatchUnsupportedTest ()
+  : TestCase ("Chain with an unsupported model is rejected")
+{
+}
+
+PathLossBatchUnsupportedTest::~PathLossBatchUnsupportedTest ()
+{
+}
+
+void
+PathLossBatchUnsupportedTest::DoRun (void)
+{
+  Ptr<FriisPropagationLossModel> friis = CreateObject<FriisPropagationLossModel> ();
+  friis->SetNext (CreateObject<RangePropagationLossModel> ());
+  PathLossBatch batch;
+  NS_TEST_ASSERT_MSG_EQ (batch.Build (friis), false, "Range model is not batchable");
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief PathLossBatch test suite
+ */
+class PathLossBatchTestSuite : public TestSuite
+{
+public:
+  PathLossBatchTestSuite ();
+};
+
+PathLossBatchTestSuite::PathLossBatchTestSuite ()
+  : TestSuite ("wifi-path-loss-batch", UNIT)
+{
+  Ptr<FriisPropagationLossModel> friis = CreateObject<FriisPropagationLossModel> ();
+  friis->SetAttribute ("Frequency", DoubleValue (5.18e9));
+  AddTestCase (new PathLossBatchTest ("Friis", friis), TestCase::QUICK);
+
+  Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  logDistance->SetAttribute ("Exponent", DoubleValue (2.7));
+  AddTestCase (new PathLossBatchTest ("LogDistance", logDistance), TestCase::QUICK);
+
+  Ptr<FriisPropagationLossModel> first = CreateObject<FriisPropagationLossModel> ();
+  first->SetAttribute ("MinLoss", DoubleValue (10));
+  Ptr<LogDistancePropagationLossModel> second = CreateObject<LogDistancePropagationLossModel> ();
+  second->SetAttribute ("ReferenceDistance", DoubleValue (2));
+  first->SetNext (second);
+  AddTestCase (new PathLossBatchTest ("Friis then LogDistance", first), TestCase::QUICK);
+
+  AddTestCase (new PathLossBatchUnsupportedTest, TestCase::QUICK);
+}
+
+static PathLossBatchTestSuite g_pathLossBatchTestSuite; ///< the test suite
@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2020 Oscar Bautista
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Oscar Bautista <obaut004@fiu.edu>
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/packet.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/wifi-mac-helper.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief YansWifiChannel gives the same receptions with and without propagation threads
+ *
+ * The same broadcast scenario is run with PropagationThreads set to 1 and
+ * to 4, the threshold being low enough for every transmission to use the
+ * pool. The receptions started at every PHY and the signal power of every
+ * decoded frame must be identical, in the same order. Both the batched
+ * path loss and the per receiver computation are checked.
+ */
+class YansWifiChannelThreadsTest : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param batched the value of the BatchedPathLoss attribute
+   */
+  YansWifiChannelThreadsTest (bool batched);
+  virtual ~YansWifiChannelThreadsTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /// One reception event
+  struct RxEvent
+  {
+    int64_t time;     ///< when it happened (ns)
+    uint32_t node;    ///< the receiving node
+    bool decoded;     ///< false for the start of a reception, true for a decoded frame
+    double signalDbm; ///< signal power of a decoded frame
+  };
+  /**
+   * Run the scenario
+   * \param threads the number of propagation threads
+   * \param events the receptions, in order
+   */
+  void RunScenario (uint32_t threads, std::vector<RxEvent> &events);
+  /**
+   * PhyRxBegin sink
+   * \param packet the packet being received
+   */
+  void NotifyRxBegin (Ptr<const Packet> packet);
+  /**
+   * MonitorSnifferRx sink
+   * \param packet the received packet
+   * \param channelFreqMhz the channel frequency
+   * \param txVector the tx vector
+   * \param aMpdu the A-MPDU information
+   * \param signalNoise the signal and noise power
+   */
+  void NotifyRx (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                 MpduInfo aMpdu, SignalNoiseDbm signalNoise);
+  /**
+   * Receive callback of the devices
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  bool m_batched;                 ///< BatchedPathLoss value
+  std::vector<RxEvent> *m_events; ///< receptions of the running scenario
+  uint32_t m_firstNode;           ///< id of the first node of the running scenario
+};
+
+YansWifiChannelThreadsTest::YansWifiChannelThreadsTest (bool batched)
+  : TestCase (batched ? "Batched path loss with and without threads" : "Per receiver path loss with and without threads"),
+    m_batched (batched),
+    m_events (0),
+    m_firstNode (0)
+{
+}
+
+YansWifiChannelThreadsTest::~YansWifiChannelThreadsTest ()
+{
+}
+
+void
+YansWifiChannelThreadsTest::NotifyRxBegin (Ptr<const Packet> packet)
+{
+  RxEvent event;
+  event.time = Simulator::Now ().GetNanoSeconds ();
+  event.node = Simulator::GetContext () - m_firstNode;
+  event.decoded = false;
+  event.signalDbm = 0;
+  m_events->push_back (event);
+}
+
+void
+YansWifiChannelThreadsTest::NotifyRx (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                                      MpduInfo aMpdu, SignalNoiseDbm signalNoise)
+{
+  RxEvent event;
+  event.time = Simulator::Now ().GetNanoSeconds ();
+  event.node = Simulator::GetContext () - m_firstNode;
+  event.decoded = true;
+  event.signalDbm = signalNoise.signal;
+  m_events->push_back (event);
+}
+
+bool
+YansWifiChannelThreadsTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                     const Address &from)
+{
+  return true;
+}
+
+void
+YansWifiChannelThreadsTest::RunScenario (uint32_t threads, std::vector<RxEvent> &events)
+{
+  const uint32_t nNodes = 40;
+  m_events = &events;
+
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetPropagationLossModel (CreateObject<FriisPropagationLossModel> ());
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetAttribute ("BatchedPathLoss", BooleanValue (m_batched));
+  channel->SetAttribute ("PropagationThreads", UintegerValue (threads));
+  channel->SetAttribute ("PropagationThreadThreshold", UintegerValue (1));
+
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+  m_firstNode = nodes.Get (0)->GetId ();
+  Ptr<UniformRandomVariable> coordinate = CreateObject<UniformRandomVariable> ();
+  coordinate->SetStream (1);
+  coordinate->SetAttribute ("Max", DoubleValue (400));
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (coordinate->GetValue (), coordinate->GetValue (), coordinate->GetValue () / 4));
+      nodes.Get (i)->AggregateObject (mobility);
+    }
+
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel);
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  wifi.AssignStreams (devices, 100);
+
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (devices.Get (i));
+      device->SetReceiveCallback (MakeCallback (&YansWifiChannelThreadsTest::Receive, this));
+      device->GetPhy ()->TraceConnectWithoutContext ("PhyRxBegin",
+                                                     MakeCallback (&YansWifiChannelThreadsTest::NotifyRxBegin, this));
+      device->GetPhy ()->TraceConnectWithoutContext ("MonitorSnifferRx",
+                                                     MakeCallback (&YansWifiChannelThreadsTest::NotifyRx, this));
+      //Frames are queued closer than their duration, so that deferrals and collisions are compared as well
+      for (uint32_t j = 0; j < 3; j++)
+        {
+          Simulator::Schedule (MilliSeconds (100 + 50 * j) + MicroSeconds (50 * i), &WifiNetDevice::Send, device,
+                               Create<Packet> (200), Mac48Address::GetBroadcast (), 0x88b5);
+        }
+    }
+
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_events = 0;
+}
+
+void
+YansWifiChannelThreadsTest::DoRun (void)
+{
+  std::vector<RxEvent> serial;
+  std::vector<RxEvent> pooled;
+  RunScenario (1, serial);
+  RunScenario (4, pooled);
+
+  NS_TEST_ASSERT_MSG_GT (serial.size (), 0, "The scenario should have receptions");
+  NS_TEST_ASSERT_MSG_EQ (pooled.size (), serial.size (), "Different number of rx events with threads");
+  for (std::size_t i = 0; i < serial.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (pooled[i].time, serial[i].time, "Rx event " << i << " at another time");
+      NS_TEST_ASSERT_MSG_EQ (pooled[i].node, serial[i].node, "Rx event " << i << " at another node");
+      NS_TEST_ASSERT_MSG_EQ (pooled[i].decoded, serial[i].decoded, "Rx event " << i << " of another kind");
+      //Exact comparison, the threads must not change a single bit
+      NS_TEST_ASSERT_MSG_EQ (pooled[i].signalDbm, serial[i].signalDbm, "Rx event " << i << " with another power");
+    }
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief YansWifiChannel propagation threads test suite
+ */
+class YansWifiChannelThreadsTestSuite : public TestSuite
+{
+public:
+  YansWifiChannelThreadsTestSuite ();
+};
+
+YansWifiChannelThreadsTestSuite::YansWifiChannelThreadsTestSuite ()
+  : TestSuite ("wifi-channel-propagation-threads", UNIT)
+{
+  AddTestCase (new YansWifiChannelThreadsTest (true), TestCase::QUICK);
+  AddTestCase (new YansWifiChannelThreadsTest (false), TestCase::QUICK);
+}
+
+static YansWifiChannelThreadsTestSuite g_yansWifiChannelThreadsTestSuite; ///< the test suite